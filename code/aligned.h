@@ -0,0 +1,30 @@
+// aligned.h
+#pragma once
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// 带 _Alignas 成员的结构体（缓存行对齐的原子量、SIMD 数组）不能用 malloc/calloc 分配：
+// 它们只保证 16 字节对齐。这里按 align（2 的幂）对齐、内容清零，用 aligned_free 释放。
+// mingw 的 C 运行库没有 aligned_alloc，用 _aligned_malloc
+static inline void* aligned_calloc(size_t align, size_t size){
+    // aligned_alloc 要求大小是对齐的整数倍
+    size = (size + align - 1) & ~(align - 1);
+#if defined(_WIN32)
+    void* p = _aligned_malloc(size, align);
+#else
+    void* p = aligned_alloc(align, size);
+#endif
+    if(p) memset(p, 0, size);
+    return p;
+}
+
+static inline void aligned_free(void* p){
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
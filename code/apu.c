@@ -0,0 +1,604 @@
+// apu.c
+#include "apu.h"
+#include "bus.h"
+#include <string.h> // for memset, memcpy, memmove
+#include <stddef.h>
+
+// 混音：用 nesdev 上的线性近似，每个声道按自己的权重直接叠加进同一个 blip。
+// 权重已经换算到 int16 满幅（全部声道最大时约 28000）。
+#define PULSE_WEIGHT    246
+#define TRIANGLE_WEIGHT 279
+#define NOISE_WEIGHT    162
+#define DMC_WEIGHT      110
+
+static const uint8_t length_table[32] = {
+    10, 254, 20,  2, 40,  4, 80,  6, 160,  8, 60, 10, 14, 12, 26, 14,
+    12,  16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30
+};
+
+static const uint8_t duty_table[4][8] = {
+    {0, 1, 0, 0, 0, 0, 0, 0}, // 12.5%
+    {0, 1, 1, 0, 0, 0, 0, 0}, // 25%
+    {0, 1, 1, 1, 1, 0, 0, 0}, // 50%
+    {1, 0, 0, 1, 1, 1, 1, 1}, // 25% 反相
+};
+
+static const uint8_t triangle_table[32] = {
+    15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15
+};
+
+static const uint16_t noise_period_table[16] = {
+    4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068
+};
+
+static const uint16_t dmc_rate_table[16] = {
+    428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54
+};
+
+// 帧计数器各步骤距离序列起点的 CPU 周期，以及整个序列的长度
+static const uint32_t frame_step_cycles[2][4] = {
+    {7457, 14913, 22371, 29829}, // 4 步：最后一步产生 IRQ
+    {7457, 14913, 22371, 37281}, // 5 步：第 4 步 (29829) 什么也不做，直接跳过
+};
+static const uint32_t frame_period[2] = {29830, 37282};
+
+// 输出电平变了就在 time 处往 blip 里加一个台阶
+static inline void update_amp(APU* apu, int* amp, int level, int weight, uint64_t time){
+    int delta = level - *amp;
+    if(delta){
+        *amp = level;
+        blip_add_delta(&apu->blip, (uint32_t)(time - apu->frame_start), delta * weight);
+    }
+}
+
+// 定时器在 [next, end] 之间不产生跳变时，直接算出走了多少步
+static inline uint64_t skip_steps(uint64_t* next, uint64_t end, uint32_t period){
+    uint64_t n = (end - *next) / period + 1;
+    *next += n * period;
+    return n;
+}
+
+// ---------------------------------------------------------
+// 包络 / 扫频 / 长度计数器（由帧计数器驱动）
+// ---------------------------------------------------------
+static int envelope_output(const ApuEnvelope* env){
+    return env->constant ? env->volume : env->decay;
+}
+
+static void envelope_clock(ApuEnvelope* env){
+    if(env->start){
+        env->start = 0;
+        env->decay = 15;
+        env->divider = env->volume;
+    }
+    else if(env->divider == 0){
+        env->divider = env->volume;
+        if(env->decay > 0) env->decay--;
+        else if(env->loop) env->decay = 15;
+    }
+    else{
+        env->divider--;
+    }
+}
+
+static int sweep_target(const ApuPulse* p){
+    int change = p->period >> p->sweep_shift;
+    if(p->sweep_negate) return p->period - change - p->ones_complement;
+    return p->period + change;
+}
+
+// 周期太短，或者扫频目标溢出，都会让方波静音（即使扫频没有开启）
+static int pulse_muted(const ApuPulse* p){
+    return p->period < 8 || (!p->sweep_negate && sweep_target(p) > 0x7FF);
+}
+
+static void sweep_clock(ApuPulse* p){
+    if(p->sweep_divider == 0 && p->sweep_enabled && p->sweep_shift > 0 && !pulse_muted(p)){
+        p->period = (uint16_t)sweep_target(p);
+    }
+    if(p->sweep_divider == 0 || p->sweep_reload){
+        p->sweep_divider = p->sweep_period;
+        p->sweep_reload = 0;
+    }
+    else{
+        p->sweep_divider--;
+    }
+}
+
+static void quarter_frame(APU* apu){
+    envelope_clock(&apu->pulse[0].env);
+    envelope_clock(&apu->pulse[1].env);
+    envelope_clock(&apu->noise.env);
+
+    ApuTriangle* tri = &apu->triangle;
+    if(tri->reload_flag) tri->linear = tri->linear_reload;
+    else if(tri->linear > 0) tri->linear--;
+    if(!tri->control) tri->reload_flag = 0;
+}
+
+static void half_frame(APU* apu){
+    for(int i = 0; i < 2; i++){
+        ApuPulse* p = &apu->pulse[i];
+        if(!p->env.loop && p->length > 0) p->length--;
+        sweep_clock(p);
+    }
+    if(!apu->triangle.control && apu->triangle.length > 0) apu->triangle.length--;
+    if(!apu->noise.env.loop && apu->noise.length > 0) apu->noise.length--;
+}
+
+static void frame_sequencer_step(APU* apu){
+    int mode = apu->frame_mode;
+    int step = apu->frame_step;
+
+    quarter_frame(apu);
+    if(step == 1 || step == 3) half_frame(apu);
+
+    if(step == 3){
+        if(mode == 0 && !apu->irq_inhibit) apu->frame_irq = 1;
+        // 回到下一个序列的第 0 步
+        uint64_t start = apu->frame_next - frame_step_cycles[mode][3] + frame_period[mode];
+        apu->frame_step = 0;
+        apu->frame_next = start + frame_step_cycles[mode][0];
+    }
+    else{
+        apu->frame_next += frame_step_cycles[mode][step + 1] - frame_step_cycles[mode][step];
+        apu->frame_step++;
+    }
+}
+
+// ---------------------------------------------------------
+// 声道：从 apu->clock 运行到 end（包括恰好落在 end 上的定时器时钟），
+// 只在波形跳变时产生台阶
+// ---------------------------------------------------------
+static void run_pulse(APU* apu, ApuPulse* p, uint64_t end){
+    int volume = (p->length && !pulse_muted(p)) ? envelope_output(&p->env) : 0;
+    const uint8_t* duty = duty_table[p->duty];
+    // 寄存器写入、帧计数器都可能刚刚改变了音量
+    update_amp(apu, &p->amp, duty[p->step] ? volume : 0, PULSE_WEIGHT, apu->clock);
+
+    if(p->next > end) return;
+    uint32_t period = (p->period + 1u) * 2; // 方波定时器每 2 个 CPU 周期走一次
+
+    if(volume == 0){
+        // 静音时序列照常前进，但不会有跳变
+        p->step = (uint8_t)((p->step + skip_steps(&p->next, end, period)) & 7);
+        return;
+    }
+
+    uint64_t t = p->next;
+    int step = p->step;
+    do{
+        step = (step + 1) & 7;
+        update_amp(apu, &p->amp, duty[step] ? volume : 0, PULSE_WEIGHT, t);
+        t += period;
+    } while(t <= end);
+    p->next = t;
+    p->step = (uint8_t)step;
+}
+
+static void run_triangle(APU* apu, uint64_t end){
+    ApuTriangle* tri = &apu->triangle;
+    update_amp(apu, &tri->amp, triangle_table[tri->step], TRIANGLE_WEIGHT, apu->clock);
+
+    if(tri->next > end) return;
+    uint32_t period = tri->period + 1u;
+
+    // 长度或线性计数器为 0 时序列停在原地；周期小于 2 是超声频率，
+    // 真机上听起来就是一个直流电平，这里同样停住，省掉每周期一次的跳变
+    if(tri->length == 0 || tri->linear == 0 || tri->period < 2){
+        skip_steps(&tri->next, end, period);
+        return;
+    }
+
+    uint64_t t = tri->next;
+    int step = tri->step;
+    do{
+        step = (step + 1) & 31;
+        update_amp(apu, &tri->amp, triangle_table[step], TRIANGLE_WEIGHT, t);
+        t += period;
+    } while(t <= end);
+    tri->next = t;
+    tri->step = (uint8_t)step;
+}
+
+static inline uint16_t clock_lfsr(uint16_t lfsr, int tap){
+    uint16_t feedback = (lfsr ^ (lfsr >> tap)) & 1;
+    return (uint16_t)((lfsr >> 1) | (feedback << 14));
+}
+
+static void run_noise(APU* apu, uint64_t end){
+    ApuNoise* n = &apu->noise;
+    int volume = n->length ? envelope_output(&n->env) : 0;
+    update_amp(apu, &n->amp, (n->lfsr & 1) ? 0 : volume, NOISE_WEIGHT, apu->clock);
+
+    if(n->next > end) return;
+    uint32_t period = noise_period_table[n->period_index];
+    int tap = n->mode ? 6 : 1;
+
+    uint64_t t = n->next;
+    uint16_t lfsr = n->lfsr;
+    if(volume == 0){
+        // 静音时移位寄存器仍然要走，它的状态决定了之后的波形
+        do{
+            lfsr = clock_lfsr(lfsr, tap);
+            t += period;
+        } while(t <= end);
+    }
+    else{
+        do{
+            lfsr = clock_lfsr(lfsr, tap);
+            update_amp(apu, &n->amp, (lfsr & 1) ? 0 : volume, NOISE_WEIGHT, t);
+            t += period;
+        } while(t <= end);
+    }
+    n->next = t;
+    n->lfsr = lfsr;
+}
+
+// DMC 取一个采样字节：通过总线读取，CPU 被挂起 4 个周期
+static void dmc_fetch(APU* apu){
+    ApuDmc* d = &apu->dmc;
+    if(d->buffer_full || d->remaining == 0) return;
+
+    d->buffer = apu->bus ? bus_read(apu->bus, d->addr) : 0;
+    d->buffer_full = 1;
+    d->addr = (d->addr == 0xFFFF) ? 0x8000 : d->addr + 1;
+    apu->dma_stall += 4;
+
+    if(--d->remaining == 0){
+        if(d->loop){
+            d->addr = d->sample_addr;
+            d->remaining = d->sample_length;
+        }
+        else if(d->irq_enabled){
+            apu->dmc_irq = 1;
+        }
+    }
+}
+
+// 一个字节的 8 位放完：从采样缓冲装入下一个字节，缓冲空了就立刻去取
+static void dmc_reload(APU* apu){
+    ApuDmc* d = &apu->dmc;
+    d->bits = 8;
+    if(d->buffer_full){
+        d->silence = 0;
+        d->shift = d->buffer;
+        d->buffer_full = 0;
+        dmc_fetch(apu);
+    }
+    else{
+        d->silence = 1;
+    }
+}
+
+static void dmc_clock(APU* apu, uint64_t t){
+    ApuDmc* d = &apu->dmc;
+    if(!d->silence){
+        if(d->shift & 1){
+            if(d->level <= 125) d->level += 2;
+        }
+        else if(d->level >= 2){
+            d->level -= 2;
+        }
+        update_amp(apu, &d->amp, d->level, DMC_WEIGHT, t);
+    }
+    d->shift >>= 1;
+    if(--d->bits == 0) dmc_reload(apu);
+}
+
+// 既不在播放也没有待取的字节：只有位计数在转，直接算出来。返回 1 表示已经处理
+static int dmc_skip_idle(ApuDmc* d, uint64_t end, uint32_t period){
+    if(!d->silence || d->buffer_full || d->remaining != 0) return 0;
+    uint64_t n = skip_steps(&d->next, end, period);
+    d->bits = (uint8_t)((d->bits - 1 + 8 - (int)(n & 7)) % 8 + 1);
+    return 1;
+}
+
+static void run_dmc(APU* apu, uint64_t end){
+    ApuDmc* d = &apu->dmc;
+    update_amp(apu, &d->amp, d->level, DMC_WEIGHT, apu->clock); // $4011 直接写电平
+
+    if(d->next > end) return;
+    uint32_t period = dmc_rate_table[d->rate_index];
+    if(dmc_skip_idle(d, end, period)) return;
+
+    uint64_t t = d->next;
+    do{
+        dmc_clock(apu, t);
+        t += period;
+    } while(t <= end);
+    d->next = t;
+}
+
+// 关闭音频时的 DMC：CPU 只看得到取样（DMA 挪用周期和 IRQ），
+// 所以直接从一次"装入移位寄存器"跳到下一次，中间的位不再逐个移出。
+// 定时器、位计数和取样时间点与 run_dmc 完全一致，只有输出电平停住不动。
+static void run_dmc_events(APU* apu, uint64_t end){
+    ApuDmc* d = &apu->dmc;
+    if(d->next > end) return;
+    uint32_t period = dmc_rate_table[d->rate_index];
+
+    while(!dmc_skip_idle(d, end, period)){
+        uint64_t reload = d->next + (uint64_t)(d->bits - 1) * period; // 本字节最后一位的时钟
+        if(reload > end){
+            d->bits -= (uint8_t)skip_steps(&d->next, end, period);
+            return;
+        }
+        d->next = reload + period;
+        d->shift = 0; // 8 位已经全部移出
+        dmc_reload(apu);
+        if(d->next > end) return;
+    }
+}
+
+static void run_channels(APU* apu, uint64_t end){
+    run_pulse(apu, &apu->pulse[0], end);
+    run_pulse(apu, &apu->pulse[1], end);
+    run_triangle(apu, end);
+    run_noise(apu, end);
+    run_dmc(apu, end);
+}
+
+// ---------------------------------------------------------
+// 对外接口
+// ---------------------------------------------------------
+void apu_init(APU* apu, double sample_rate){
+    memset(apu, 0, sizeof(APU));
+
+    apu->pulse[0].ones_complement = 1;
+    apu->noise.lfsr = 1;
+    // 三角波上电停在第 0 步（电平 15）：当作基准电平，避免开机"噗"的一声
+    apu->triangle.amp = triangle_table[0];
+    apu->dmc.bits = 8;
+    apu->dmc.silence = 1;
+    apu->dmc.sample_addr = 0xC000;
+    apu->dmc.sample_length = 1;
+
+    // 上电相当于向 $4017 写了 0
+    apu->frame_next = frame_step_cycles[0][0];
+
+    apu->audio_enabled = 1;
+    apu->synth_ready = 1;
+    apu->sample_rate = sample_rate;
+    blip_init(&apu->blip, APU_CLOCK_RATE, sample_rate * APU_SYNTH_OVERSAMPLE);
+    resampler_init(&apu->resampler, sample_rate * APU_SYNTH_OVERSAMPLE, sample_rate, RESAMPLE_MEDIUM);
+}
+
+void apu_set_sample_rate(APU* apu, double sample_rate){
+    apu->sample_rate = sample_rate;
+    if(!apu->synth_ready) return; // 打开音频时按新的采样率初始化
+    blip_set_rates(&apu->blip, APU_CLOCK_RATE, sample_rate * APU_SYNTH_OVERSAMPLE);
+    resampler_set_rates(&apu->resampler, sample_rate * APU_SYNTH_OVERSAMPLE, sample_rate);
+}
+
+void apu_set_resample_quality(APU* apu, int quality){
+    if(!apu->synth_ready) return;
+    resampler_set_quality(&apu->resampler, quality);
+}
+
+void apu_set_rate_adjust(APU* apu, double ratio){
+    if(!apu->synth_ready) return;
+    resampler_set_adjust(&apu->resampler, ratio);
+}
+
+void apu_set_audio(APU* apu, int enabled){
+    if(enabled && !apu->synth_ready){
+        blip_init(&apu->blip, APU_CLOCK_RATE, apu->sample_rate * APU_SYNTH_OVERSAMPLE);
+        resampler_init(&apu->resampler, apu->sample_rate * APU_SYNTH_OVERSAMPLE, apu->sample_rate, RESAMPLE_MEDIUM);
+        apu->synth_ready = 1;
+    }
+    if(enabled && !apu->audio_enabled){
+        // 关闭期间各声道的定时器没有走：从现在重新开始，丢掉旧的音频数据
+        apu->pulse[0].next = apu->pulse[1].next = apu->clock;
+        apu->triangle.next = apu->noise.next = apu->clock;
+        blip_clear(&apu->blip);
+        resampler_clear(&apu->resampler);
+        apu->frame_start = apu->clock;
+        apu->out_count = 0;
+    }
+    apu->audio_enabled = (uint8_t)(enabled != 0);
+}
+
+void apu_fork(const APU* apu, APU* child){
+    // 模拟状态都在 blip 之前；合成器和输出缓冲有几十 KB，分支用不到就不碰
+    memcpy(child, apu, offsetof(APU, blip));
+    child->audio_enabled = 0;
+    child->synth_ready = 0;
+    child->out_count = 0;
+}
+
+void apu_run_to(APU* apu, uint64_t target){
+    // 声道之间互不影响，只有帧计数器会改变它们的参数：
+    // 按帧计数器的步骤把时间切成几段，每段内各声道独立跑完
+    while(apu->clock < target){
+        uint64_t end = target < apu->frame_next ? target : apu->frame_next;
+        if(apu->audio_enabled) run_channels(apu, end);
+        else run_dmc_events(apu, end);
+        apu->clock = end;
+        if(end == apu->frame_next){
+            frame_sequencer_step(apu);
+        }
+    }
+}
+
+uint64_t apu_next_event(const APU* apu){
+    uint64_t next = UINT64_MAX;
+
+    // 4 步模式下最后一步的帧 IRQ
+    if(apu->frame_mode == 0 && !apu->irq_inhibit && !apu->frame_irq){
+        next = apu->frame_next + frame_step_cycles[0][3] - frame_step_cycles[0][apu->frame_step];
+    }
+
+    // DMC 下一次取样：当前字节的位放完、缓冲被装入移位寄存器的时刻
+    const ApuDmc* d = &apu->dmc;
+    if(d->buffer_full && d->remaining > 0){
+        uint64_t fetch = d->next + (uint64_t)(d->bits - 1) * dmc_rate_table[d->rate_index];
+        if(fetch < next) next = fetch;
+    }
+    return next;
+}
+
+uint8_t apu_read_status(APU* apu){
+    uint8_t status = 0;
+    if(apu->pulse[0].length)   status |= 0x01;
+    if(apu->pulse[1].length)   status |= 0x02;
+    if(apu->triangle.length)   status |= 0x04;
+    if(apu->noise.length)      status |= 0x08;
+    if(apu->dmc.remaining)     status |= 0x10;
+    if(apu->frame_irq)         status |= 0x40;
+    if(apu->dmc_irq)           status |= 0x80;
+
+    // 读 $4015 清除帧 IRQ
+    apu->frame_irq = 0;
+    return status;
+}
+
+static void write_pulse(ApuPulse* p, int reg, uint8_t data){
+    switch(reg){
+        case 0:
+            p->duty = data >> 6;
+            p->env.loop = (data >> 5) & 1;
+            p->env.constant = (data >> 4) & 1;
+            p->env.volume = data & 0x0F;
+            break;
+        case 1:
+            p->sweep_enabled = data >> 7;
+            p->sweep_period = (data >> 4) & 7;
+            p->sweep_negate = (data >> 3) & 1;
+            p->sweep_shift = data & 7;
+            p->sweep_reload = 1;
+            break;
+        case 2:
+            p->period = (p->period & 0x0700) | data;
+            break;
+        case 3:
+            p->period = (p->period & 0x00FF) | ((data & 7) << 8);
+            if(p->enabled) p->length = length_table[data >> 3];
+            p->step = 0;
+            p->env.start = 1;
+            break;
+    }
+}
+
+void apu_write_register(APU* apu, uint16_t addr, uint8_t data){
+    ApuTriangle* tri = &apu->triangle;
+    ApuNoise* noise = &apu->noise;
+    ApuDmc* dmc = &apu->dmc;
+
+    switch(addr){
+        case 0x4000: case 0x4001: case 0x4002: case 0x4003:
+            write_pulse(&apu->pulse[0], addr & 3, data);
+            break;
+        case 0x4004: case 0x4005: case 0x4006: case 0x4007:
+            write_pulse(&apu->pulse[1], addr & 3, data);
+            break;
+
+        case 0x4008:
+            tri->control = data >> 7;
+            tri->linear_reload = data & 0x7F;
+            break;
+        case 0x400A:
+            tri->period = (tri->period & 0x0700) | data;
+            break;
+        case 0x400B:
+            tri->period = (tri->period & 0x00FF) | ((data & 7) << 8);
+            if(tri->enabled) tri->length = length_table[data >> 3];
+            tri->reload_flag = 1;
+            break;
+
+        case 0x400C:
+            noise->env.loop = (data >> 5) & 1;
+            noise->env.constant = (data >> 4) & 1;
+            noise->env.volume = data & 0x0F;
+            break;
+        case 0x400E:
+            noise->mode = data >> 7;
+            noise->period_index = data & 0x0F;
+            break;
+        case 0x400F:
+            if(noise->enabled) noise->length = length_table[data >> 3];
+            noise->env.start = 1;
+            break;
+
+        case 0x4010:
+            dmc->irq_enabled = data >> 7;
+            dmc->loop = (data >> 6) & 1;
+            dmc->rate_index = data & 0x0F;
+            if(!dmc->irq_enabled) apu->dmc_irq = 0;
+            break;
+        case 0x4011:
+            dmc->level = data & 0x7F;
+            break;
+        case 0x4012:
+            dmc->sample_addr = 0xC000 + (uint16_t)data * 64;
+            break;
+        case 0x4013:
+            dmc->sample_length = (uint16_t)data * 16 + 1;
+            break;
+
+        // 声道开关：关掉的声道长度计数器立即清零
+        case 0x4015:
+            apu->pulse[0].enabled = data & 0x01;
+            apu->pulse[1].enabled = (data >> 1) & 1;
+            tri->enabled = (data >> 2) & 1;
+            noise->enabled = (data >> 3) & 1;
+            if(!apu->pulse[0].enabled) apu->pulse[0].length = 0;
+            if(!apu->pulse[1].enabled) apu->pulse[1].length = 0;
+            if(!tri->enabled) tri->length = 0;
+            if(!noise->enabled) noise->length = 0;
+
+            apu->dmc_irq = 0;
+            if(!(data & 0x10)){
+                dmc->remaining = 0;
+            }
+            else if(dmc->remaining == 0){
+                dmc->addr = dmc->sample_addr;
+                dmc->remaining = dmc->sample_length;
+                dmc_fetch(apu);
+            }
+            break;
+
+        // 帧计数器：重新开始序列，5 步模式立即产生一次 1/4 帧和 1/2 帧时钟
+        case 0x4017:
+            apu->frame_mode = data >> 7;
+            apu->irq_inhibit = (data >> 6) & 1;
+            if(apu->irq_inhibit) apu->frame_irq = 0;
+            apu->frame_step = 0;
+            apu->frame_next = apu->clock + frame_step_cycles[apu->frame_mode][0];
+            if(apu->frame_mode){
+                quarter_frame(apu);
+                half_frame(apu);
+            }
+            break;
+    }
+}
+
+void apu_end_frame(APU* apu, uint64_t end){
+    apu_run_to(apu, end);
+    if(!apu->audio_enabled){
+        apu->frame_start = end;
+        return;
+    }
+    blip_end_frame(&apu->blip, (uint32_t)(end - apu->frame_start));
+    apu->frame_start = end;
+
+    // 整帧一次性合成、一次性重采样
+    int16_t synth[BLIP_CAPACITY];
+    int count = blip_read_samples(&apu->blip, synth, BLIP_CAPACITY);
+
+    // 没有人读取时丢掉积压的采样，缓冲不会溢出
+    if(apu->out_count > APU_OUT_CAPACITY / 2){
+        apu->out_count = 0;
+    }
+    apu->out_count += resampler_process(&apu->resampler, synth, count,
+                                        apu->out + apu->out_count, APU_OUT_CAPACITY - apu->out_count);
+}
+
+int apu_read_samples(APU* apu, int16_t* out, int count){
+    if(count > apu->out_count) count = apu->out_count;
+    memcpy(out, apu->out, (size_t)count * sizeof(int16_t));
+    apu->out_count -= count;
+    memmove(apu->out, apu->out + count, (size_t)apu->out_count * sizeof(int16_t));
+    return count;
+}
@@ -0,0 +1,167 @@
+// apu.h
+#pragma once
+#include <stdint.h>
+#include "blip.h"
+#include "resampler.h"
+
+// NTSC CPU 时钟，APU 的所有计时都以 CPU 周期为单位
+#define APU_CLOCK_RATE 1789773.0
+
+// blip 以输出采样率的 2 倍合成，再由多相 FIR 降到输出采样率：
+// 高频的抗混叠交给更长的 FIR，同时可以对输出采样率做动态微调
+#define APU_SYNTH_OVERSAMPLE 2
+
+// 已经转换好、等待前端取走的输出采样
+#define APU_OUT_CAPACITY 4096
+
+struct Bus;
+
+// 音量包络（方波、噪声共用）
+typedef struct ApuEnvelope{
+    uint8_t start;     // 写 $4003/$4007/$400F 后置 1，下一个 1/4 帧重新开始
+    uint8_t loop;      // 循环，同时也是长度计数器的暂停位
+    uint8_t constant;  // 1 = 固定音量
+    uint8_t volume;    // 固定音量值，同时是包络分频器的周期
+    uint8_t divider;
+    uint8_t decay;     // 衰减计数 15 -> 0
+} ApuEnvelope;
+
+typedef struct ApuPulse{
+    ApuEnvelope env;
+    uint8_t enabled;   // $4015 对应位
+    uint8_t length;    // 长度计数器
+    uint8_t duty;      // 占空比 0-3
+    uint8_t step;      // 序列位置 0-7
+    uint16_t period;   // 11 位定时器周期
+
+    // 扫频单元
+    uint8_t sweep_enabled, sweep_period, sweep_negate, sweep_shift;
+    uint8_t sweep_reload, sweep_divider;
+    uint8_t ones_complement; // 方波 1 取反时多减 1
+
+    uint64_t next;     // 下一次定时器时钟的绝对 CPU 周期
+    int amp;           // 已经送进 blip 的输出电平
+} ApuPulse;
+
+typedef struct ApuTriangle{
+    uint8_t enabled;
+    uint8_t length;
+    uint8_t control;        // 长度暂停 + 线性计数器控制
+    uint8_t linear_reload;  // 线性计数器重载值
+    uint8_t linear;         // 线性计数器
+    uint8_t reload_flag;
+    uint8_t step;           // 32 步序列位置
+    uint16_t period;
+
+    uint64_t next;
+    int amp;
+} ApuTriangle;
+
+typedef struct ApuNoise{
+    ApuEnvelope env;
+    uint8_t enabled;
+    uint8_t length;
+    uint8_t mode;       // 1 = 短周期（93 步）
+    uint8_t period_index;
+    uint16_t lfsr;      // 15 位线性反馈移位寄存器
+
+    uint64_t next;
+    int amp;
+} ApuNoise;
+
+typedef struct ApuDmc{
+    uint8_t irq_enabled;
+    uint8_t loop;
+    uint8_t rate_index;
+    uint8_t level;        // 7 位输出电平
+
+    uint16_t sample_addr;   // $4012 -> $C000 + A*64
+    uint16_t sample_length; // $4013 -> L*16 + 1
+    uint16_t addr;          // 当前读取地址
+    uint16_t remaining;     // 剩余字节数
+
+    uint8_t buffer;       // 采样缓冲（1 字节）
+    uint8_t buffer_full;
+    uint8_t shift;        // 输出移位寄存器
+    uint8_t bits;         // 本字节剩余位数
+    uint8_t silence;
+
+    uint64_t next;
+    int amp;
+} ApuDmc;
+
+typedef struct APU{
+    ApuPulse pulse[2];
+    ApuTriangle triangle;
+    ApuNoise noise;
+    ApuDmc dmc;
+
+    // 帧计数器 ($4017)
+    uint8_t frame_mode;        // 0 = 4 步, 1 = 5 步
+    uint8_t irq_inhibit;
+    uint8_t frame_step;        // 下一个要执行的步骤
+    uint64_t frame_next;       // 下一个步骤的绝对 CPU 周期
+
+    // CPU 可见的中断标志（$4015 bit 6/7）
+    uint8_t frame_irq;
+    uint8_t dmc_irq;
+
+    // DMC 取样时从 CPU 手里抢走的周期，由总线加回主时钟
+    uint32_t dma_stall;
+
+    // 时间：APU 已经追赶到的 CPU 周期，以及当前音频帧的起点
+    uint64_t clock;
+    uint64_t frame_start;
+
+    struct Bus* bus;   // DMC 通过总线读取采样
+
+    // 0 = 无声模式：只推进 CPU 看得到的状态（长度计数器、$4015、帧 IRQ、DMC 取样），
+    // 方波/三角/噪声的定时器完全不走，也不合成音频
+    uint8_t audio_enabled;
+    uint8_t synth_ready;   // blip/重采样器已经初始化（分支出来的 APU 在第一次打开音频时才初始化）
+
+    double sample_rate;
+    Blip blip;
+    Resampler resampler;
+
+    int16_t out[APU_OUT_CAPACITY];
+    int out_count;
+} APU;
+
+// 上电初始化，输出采样率为 sample_rate（44100 / 48000）
+void apu_init(APU* apu, double sample_rate);
+void apu_set_sample_rate(APU* apu, double sample_rate);
+
+// 重采样质量 (enum ResampleQuality)，默认 RESAMPLE_MEDIUM
+void apu_set_resample_quality(APU* apu, int quality);
+// 音画同步：输出采样率乘以 ratio（1 ± 0.5% 以内）
+void apu_set_rate_adjust(APU* apu, double ratio);
+
+// 打开/关闭音频合成。关闭后 CPU 看到的行为（时序、IRQ、DMA）与打开时完全相同，
+// 但几乎不花时间；重新打开时从当前时间开始合成
+void apu_set_audio(APU* apu, int enabled);
+
+// 分支 (machine_fork)：child 得到 apu 的全部模拟状态，但不合成音频，
+// 也不拷贝音频缓冲；之后可以用 apu_set_audio 打开
+void apu_fork(const APU* apu, APU* child);
+
+// 惰性同步：把 APU 追赶到第 target 个 CPU 周期
+void apu_run_to(APU* apu, uint64_t target);
+
+// 下一次 CPU 必须来同步的时间点（帧 IRQ 或 DMC 取样），单位 CPU 周期
+uint64_t apu_next_event(const APU* apu);
+
+// CPU 读写 $4000-$4017（调用前已经追赶到当前时间）
+uint8_t apu_read_status(APU* apu);
+void apu_write_register(APU* apu, uint16_t addr, uint8_t data);
+
+// IRQ 线电平（帧 IRQ 或 DMC IRQ）
+static inline int apu_irq(const APU* apu){
+    return apu->frame_irq | apu->dmc_irq;
+}
+
+// 一帧结束：追赶到 end，把这一帧的跳变合成出来并重采样到 sample_rate
+void apu_end_frame(APU* apu, uint64_t end);
+
+// 读出最多 count 个单声道 int16 采样，返回实际个数
+int apu_read_samples(APU* apu, int16_t* out, int count);
@@ -0,0 +1,168 @@
+// arena.c
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // MAP_HUGETLB, MADV_HUGEPAGE
+#endif
+#include "arena.h"
+#include "aligned.h"
+#include <stdlib.h>
+#include <stdint.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#define CACHE_LINE 64
+#define HUGE_PAGE (2u << 20)
+
+struct MachineArena{
+    uint8_t* slots;     // 第一个槽位，按缓存行对齐
+    size_t stride;      // 相邻槽位的距离
+    int capacity;
+
+    // 空槽位的栈：分配和归还都是 O(1)
+    int* free_slots;
+    int free_count;
+
+    Machine* power_on;  // 上电状态的模板（单独分配，不占槽位）
+
+    // 整块内存的来历，释放时用
+    void* storage;
+    size_t storage_size;
+    int mapped;         // 1 = mmap，0 = malloc
+    int huge;
+};
+
+// 槽位大小按缓存行取整。恰好是 4KB 的整数倍时再错开一个缓存行：
+// 否则每台机器的热字段（寄存器、时钟）落在 L1 的同一组里，同时跑很多台时互相挤掉
+static size_t slot_stride(void){
+    size_t stride = (sizeof(Machine) + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+    if(stride % 4096 == 0){
+        stride += CACHE_LINE;
+    }
+    return stride;
+}
+
+static int map_storage(MachineArena* arena, size_t size, int flags){
+#if defined(__linux__)
+    if(flags & ARENA_HUGE_PAGES){
+        // 预留的大页（/proc/sys/vm/nr_hugepages）；大多数机器上没有，退回透明大页
+        size_t huge_size = (size + HUGE_PAGE - 1) & ~(size_t)(HUGE_PAGE - 1);
+        void* p = mmap(NULL, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(p != MAP_FAILED){
+            arena->storage = p;
+            arena->storage_size = huge_size;
+            arena->mapped = 1;
+            arena->huge = 1;
+            return 1;
+        }
+    }
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(p == MAP_FAILED) return 0;
+    arena->storage = p;
+    arena->storage_size = size;
+    arena->mapped = 1;
+#ifdef MADV_HUGEPAGE
+    if(flags & ARENA_HUGE_PAGES){
+        arena->huge = madvise(p, size, MADV_HUGEPAGE) == 0;
+    }
+#endif
+    return 1;
+#else
+    (void)flags;
+    arena->storage = malloc(size + CACHE_LINE - 1);
+    arena->storage_size = size;
+    arena->mapped = 0;
+    return arena->storage != NULL;
+#endif
+}
+
+static void unmap_storage(MachineArena* arena){
+#if defined(__linux__)
+    if(arena->mapped){
+        munmap(arena->storage, arena->storage_size);
+        return;
+    }
+#endif
+    free(arena->storage);
+}
+
+static int slot_index(const MachineArena* arena, const Machine* m){
+    return (int)(((const uint8_t*)m - arena->slots) / arena->stride);
+}
+
+MachineArena* arena_create(NesRom* rom, int capacity, int flags){
+    if(capacity <= 0) return NULL;
+    MachineArena* arena = (MachineArena*)calloc(1, sizeof(MachineArena));
+    if(!arena) return NULL;
+    arena->stride = slot_stride();
+    arena->capacity = capacity;
+    arena->free_slots = (int*)malloc((size_t)capacity * sizeof(int));
+    arena->power_on = (Machine*)aligned_calloc(_Alignof(Machine), sizeof(Machine));
+    if(!arena->free_slots || !arena->power_on ||
+       !map_storage(arena, (size_t)capacity * arena->stride, flags)){
+        free(arena->free_slots);
+        aligned_free(arena->power_on);
+        free(arena);
+        return NULL;
+    }
+    // mmap 本来就按页对齐；malloc 的要自己对齐到缓存行
+    arena->slots = (uint8_t*)(((uintptr_t)arena->storage + CACHE_LINE - 1) & ~(uintptr_t)(CACHE_LINE - 1));
+
+    // 低编号的槽位先分出去，用到的内存尽量连续
+    for(int i = 0; i < capacity; i++){
+        arena->free_slots[i] = capacity - 1 - i;
+    }
+    arena->free_count = capacity;
+
+    machine_init(arena->power_on, rom);
+    machine_set_audio(arena->power_on, 0);
+    return arena;
+}
+
+void arena_destroy(MachineArena* arena){
+    if(!arena) return;
+    // 还在用的槽位可能和模板共享着存储页，先逐个放掉
+    uint8_t* in_use = (uint8_t*)calloc((size_t)arena->capacity, 1);
+    if(in_use){
+        for(int i = 0; i < arena->capacity; i++) in_use[i] = 1;
+        for(int i = 0; i < arena->free_count; i++) in_use[arena->free_slots[i]] = 0;
+        for(int i = 0; i < arena->capacity; i++){
+            if(in_use[i]) machine_release((Machine*)(arena->slots + (size_t)i * arena->stride));
+        }
+        free(in_use);
+    }
+    machine_release(arena->power_on);
+    aligned_free(arena->power_on);
+    unmap_storage(arena);
+    free(arena->free_slots);
+    free(arena);
+}
+
+Machine* arena_alloc(MachineArena* arena){
+    if(arena->free_count == 0) return NULL;
+    int slot = arena->free_slots[--arena->free_count];
+    Machine* m = (Machine*)(arena->slots + (size_t)slot * arena->stride);
+    machine_fork(arena->power_on, m);
+    return m;
+}
+
+void arena_free(MachineArena* arena, Machine* m){
+    machine_release(m);
+    arena->free_slots[arena->free_count++] = slot_index(arena, m);
+}
+
+void arena_reset(MachineArena* arena, Machine* m){
+    machine_release(m);
+    machine_fork(arena->power_on, m);
+}
+
+int arena_capacity(const MachineArena* arena){
+    return arena->capacity;
+}
+
+int arena_used(const MachineArena* arena){
+    return arena->capacity - arena->free_count;
+}
+
+int arena_huge_pages(const MachineArena* arena){
+    return arena->huge;
+}
@@ -0,0 +1,36 @@
+// arena.h
+#pragma once
+#include "machine.h"
+
+// 机器实例池：成千上万台机器（批量训练、搜索）放在一整块内存里，每台占一个按缓存行对齐的槽位。
+// 一台机器的全部可变状态（CPU、RAM、PPU 的 VRAM/OAM、APU）本来就都在 Machine 结构体里，
+// 卡带 ROM 只读、所有机器共享，所以一个槽位就是一个 Machine。
+//
+// 分配和复位都不再走 machine_init（清零 150KB 再逐个部件初始化），而是从池里那台上电状态的
+// 模板机器分支 (machine_fork)：只拷贝寄存器和 2KB RAM，VRAM 和模板共享，用到时才拷贝。
+// 因此分出来的机器和 machine_fork 的结果一样：不合成音频（需要时 machine_set_audio 打开）、
+// 没有输出队列，画面在跑完第一帧之后才有效。
+//
+// 池本身不加锁，同一时刻只能有一个线程分配或释放；分出来的机器可以在不同线程上同时运行
+
+// 尽量用 2MB 大页（Linux：先试 MAP_HUGETLB，再退回透明大页；其他平台忽略）
+#define ARENA_HUGE_PAGES 1
+
+typedef struct MachineArena MachineArena;
+
+// 给 rom 创建一个能放 capacity 台机器的池，失败返回 NULL
+MachineArena* arena_create(NesRom* rom, int capacity, int flags);
+// 释放整个池；还没归还的机器一起作废
+void arena_destroy(MachineArena* arena);
+
+// 取一个空槽位，里面是一台刚上电的机器；池满时返回 NULL
+Machine* arena_alloc(MachineArena* arena);
+// 归还槽位
+void arena_free(MachineArena* arena, Machine* m);
+// 把池里的一台机器恢复到上电状态
+void arena_reset(MachineArena* arena, Machine* m);
+
+int arena_capacity(const MachineArena* arena);
+int arena_used(const MachineArena* arena);
+// 实际拿到了大页（MAP_HUGETLB 成功，或者内核同意了透明大页）时返回 1
+int arena_huge_pages(const MachineArena* arena);
@@ -0,0 +1,131 @@
+// av_output.c
+#include "av_output.h"
+#include "aligned.h"
+#include <stdlib.h>
+#include <stdatomic.h>
+
+// 通用的单生产者/单消费者环：head 只由生产者写，tail 只由消费者写，分开放在不同缓存行
+typedef struct SpscRing{
+    uint8_t* slots;
+    void* storage;          // malloc 返回的原始指针，slots 是它按 64 字节对齐后的位置
+    size_t slot_size;
+    uint64_t mask;
+
+    _Alignas(64) _Atomic uint64_t head;
+    _Atomic uint64_t dropped;       // 也只由生产者写
+    _Alignas(64) _Atomic uint64_t tail;
+} SpscRing;
+
+struct AvOutput{
+    SpscRing video;
+    SpscRing audio;
+};
+
+static uint64_t round_up_pow2(int n){
+    uint64_t size = 1;
+    while(size < (uint64_t)n) size <<= 1;
+    return size;
+}
+
+static int ring_init(SpscRing* r, size_t slot_size, int slots){
+    uint64_t count = round_up_pow2(slots < 1 ? 1 : slots);
+    // 槽位按缓存行对齐，相邻槽位的写入不会互相干扰
+    r->slot_size = (slot_size + 63) & ~(size_t)63;
+    r->storage = malloc(r->slot_size * count + 63);
+    if(!r->storage) return 0;
+    r->slots = (uint8_t*)(((uintptr_t)r->storage + 63) & ~(uintptr_t)63);
+    r->mask = count - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->dropped, 0);
+    atomic_init(&r->tail, 0);
+    return 1;
+}
+
+static void* ring_write_slot(SpscRing* r){
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if(head - atomic_load_explicit(&r->tail, memory_order_acquire) > r->mask){
+        atomic_store_explicit(&r->dropped, atomic_load_explicit(&r->dropped, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        return NULL;
+    }
+    return r->slots + (head & r->mask) * r->slot_size;
+}
+
+static void ring_commit(SpscRing* r){
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+static const void* ring_read_slot(SpscRing* r){
+    uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if(tail == atomic_load_explicit(&r->head, memory_order_acquire)) return NULL;
+    return r->slots + (tail & r->mask) * r->slot_size;
+}
+
+static void ring_release(SpscRing* r){
+    uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+}
+
+AvOutput* av_output_create(int video_slots, int audio_slots){
+    // head/tail 各占一个缓存行 (_Alignas(64))
+    AvOutput* out = (AvOutput*)aligned_calloc(_Alignof(AvOutput), sizeof(AvOutput));
+    if(!out) return NULL;
+    if(!ring_init(&out->video, sizeof(AvVideoBlock), video_slots)){
+        aligned_free(out);
+        return NULL;
+    }
+    if(!ring_init(&out->audio, sizeof(AvAudioBlock), audio_slots)){
+        free(out->video.storage);
+        aligned_free(out);
+        return NULL;
+    }
+    return out;
+}
+
+void av_output_destroy(AvOutput* out){
+    if(!out) return;
+    free(out->video.storage);
+    free(out->audio.storage);
+    aligned_free(out);
+}
+
+AvVideoBlock* av_output_video_slot(AvOutput* out){
+    return (AvVideoBlock*)ring_write_slot(&out->video);
+}
+
+void av_output_commit_video(AvOutput* out){
+    ring_commit(&out->video);
+}
+
+AvAudioBlock* av_output_audio_slot(AvOutput* out){
+    return (AvAudioBlock*)ring_write_slot(&out->audio);
+}
+
+void av_output_commit_audio(AvOutput* out){
+    ring_commit(&out->audio);
+}
+
+const AvVideoBlock* av_output_peek_video(AvOutput* out){
+    return (const AvVideoBlock*)ring_read_slot(&out->video);
+}
+
+void av_output_release_video(AvOutput* out){
+    ring_release(&out->video);
+}
+
+const AvAudioBlock* av_output_peek_audio(AvOutput* out){
+    return (const AvAudioBlock*)ring_read_slot(&out->audio);
+}
+
+void av_output_release_audio(AvOutput* out){
+    ring_release(&out->audio);
+}
+
+uint64_t av_output_dropped_video(const AvOutput* out){
+    return atomic_load_explicit(&((AvOutput*)out)->video.dropped, memory_order_relaxed);
+}
+
+uint64_t av_output_dropped_audio(const AvOutput* out){
+    return atomic_load_explicit(&((AvOutput*)out)->audio.dropped, memory_order_relaxed);
+}
@@ -0,0 +1,47 @@
+// av_output.h
+#pragma once
+#include <stdint.h>
+#include "ppu.h"
+
+// 模拟线程 -> 输出/编码线程 的画面与音频交接。
+//
+// 两条单生产者/单消费者的无锁环形队列，槽位在创建时一次性分配好：
+// 模拟线程每帧把画面和音频直接写进空闲槽位再提交，不分配内存、不加锁、不等待；
+// 队列满了（消费者跟不上）就丢掉这一帧并计数，模拟线程永远不会被 I/O 卡住。
+// 消费者线程（窗口、声卡回调、编码器）按顺序取出槽位，用完后释放。
+
+#define AV_AUDIO_BLOCK_MAX 2048 // 一个音频块最多的采样数（48kHz 下一帧约 800）
+
+typedef struct AvVideoBlock{
+    uint64_t frame_number;
+    PpuFrame frame;          // 调色板索引格式，转换见 video.h
+} AvVideoBlock;
+
+typedef struct AvAudioBlock{
+    uint64_t frame_number;
+    int count;               // samples 里的有效采样数
+    int sample_rate;
+    int16_t samples[AV_AUDIO_BLOCK_MAX];
+} AvAudioBlock;
+
+typedef struct AvOutput AvOutput;
+
+// 槽位数会向上取整到 2 的幂；失败返回 NULL
+AvOutput* av_output_create(int video_slots, int audio_slots);
+void av_output_destroy(AvOutput* out);
+
+// 生产者（模拟线程）：取一个空槽位写入，写完提交；队列满时返回 NULL（本帧被丢弃）
+AvVideoBlock* av_output_video_slot(AvOutput* out);
+void av_output_commit_video(AvOutput* out);
+AvAudioBlock* av_output_audio_slot(AvOutput* out);
+void av_output_commit_audio(AvOutput* out);
+
+// 消费者（输出线程）：取最早的一个块，没有时返回 NULL；用完后释放
+const AvVideoBlock* av_output_peek_video(AvOutput* out);
+void av_output_release_video(AvOutput* out);
+const AvAudioBlock* av_output_peek_audio(AvOutput* out);
+void av_output_release_audio(AvOutput* out);
+
+// 因为队列满而没能发布的次数（画面直接丢弃；音频留到下一帧再发）
+uint64_t av_output_dropped_video(const AvOutput* out);
+uint64_t av_output_dropped_audio(const AvOutput* out);
@@ -0,0 +1,21 @@
+// batch.c
+#include "batch.h"
+
+typedef struct BatchJob{
+    Machine** machines;
+    int frames;
+} BatchJob;
+
+static void run_machine(void* arg, int index, int worker){
+    (void)worker;
+    BatchJob* job = (BatchJob*)arg;
+    Machine* m = job->machines[index];
+    for(int f = 0; f < job->frames; f++){
+        machine_run_frame(m);
+    }
+}
+
+void batch_run_frames(ThreadPool* pool, Machine** machines, int count, int frames){
+    BatchJob job = {machines, frames};
+    thread_pool_run(pool, count, run_machine, &job);
+}
@@ -0,0 +1,10 @@
+// batch.h
+#pragma once
+#include "machine.h"
+#include "thread_pool.h"
+
+// 批量运行：count 台互相独立的机器各跑 frames 帧，按线程池摊到所有核上。
+// 每台机器整段 frames 帧都在同一个线程上跑完，状态一直留在那个核的缓存里。
+// 机器之间不能共享可写的东西（同一个输出队列、同一个录像回放位置都不行），
+// 共享同一个 NesRom 和写时复制的存储页 (machine_fork) 没有问题
+void batch_run_frames(ThreadPool* pool, Machine** machines, int count, int frames);
@@ -0,0 +1,162 @@
+// battery.c
+#include "battery.h"
+#include "bus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+struct Battery{
+    uint8_t* data;
+    int mode;
+    uint32_t frames;    // 距离上次写回的帧数
+#if !defined(_WIN32)
+    int fd;             // 私有映射重新映射时要用
+#else
+    char* path;         // 同步/回退时重新打开
+#endif
+};
+
+int battery_present(const NesRom* rom){
+    return (rom->header.flags6 & 0x02) != 0;
+}
+
+#if !defined(_WIN32)
+
+static void* map_pages(Battery* battery, void* at){
+    int flags = battery->mode == BATTERY_SHARED ? MAP_SHARED : MAP_PRIVATE;
+    if(at) flags |= MAP_FIXED;
+    return mmap(at, BUS_PRG_RAM_SIZE, PROT_READ | PROT_WRITE, flags, battery->fd, 0);
+}
+
+Battery* battery_open(const char* path, int mode){
+    int shared = mode == BATTERY_SHARED;
+    int fd = open(path, shared ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if(fd < 0) return NULL;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0){
+        close(fd);
+        return NULL;
+    }
+    // 映射超出文件末尾的部分一访问就是 SIGBUS：共享映射补足长度，私有映射要求模板完整
+    if(st.st_size < BUS_PRG_RAM_SIZE){
+        if(!shared || ftruncate(fd, BUS_PRG_RAM_SIZE) != 0){
+            close(fd);
+            return NULL;
+        }
+    }
+
+    Battery* battery = (Battery*)calloc(1, sizeof(Battery));
+    if(!battery){
+        close(fd);
+        return NULL;
+    }
+    battery->mode = mode;
+    battery->fd = fd;
+    void* map = map_pages(battery, NULL);
+    if(map == MAP_FAILED){
+        close(fd);
+        free(battery);
+        return NULL;
+    }
+    battery->data = (uint8_t*)map;
+    return battery;
+}
+
+void battery_close(Battery* battery){
+    if(!battery) return;
+    battery_sync(battery, 1);
+    munmap(battery->data, BUS_PRG_RAM_SIZE);
+    close(battery->fd);
+    free(battery);
+}
+
+int battery_sync(Battery* battery, int wait){
+    battery->frames = 0;
+    if(battery->mode != BATTERY_SHARED) return 1;
+    return msync(battery->data, BUS_PRG_RAM_SIZE, wait ? MS_SYNC : MS_ASYNC) == 0;
+}
+
+int battery_revert(Battery* battery){
+    if(battery->mode != BATTERY_PRIVATE) return 0;
+    // 在原地址上重新映射：写时复制出来的私有页被丢掉，机器里的指针仍然有效
+    return map_pages(battery, battery->data) != MAP_FAILED;
+}
+
+#else
+
+// Windows：整块读进内存，同步时整块写回
+static int read_file(const char* path, uint8_t* data){
+    FILE* fp = fopen(path, "rb");
+    if(!fp) return 0;
+    size_t n = fread(data, 1, BUS_PRG_RAM_SIZE, fp);
+    fclose(fp);
+    return (int)n;
+}
+
+Battery* battery_open(const char* path, int mode){
+    Battery* battery = (Battery*)calloc(1, sizeof(Battery));
+    uint8_t* data = (uint8_t*)calloc(1, BUS_PRG_RAM_SIZE);
+    char* copy = (char*)malloc(strlen(path) + 1);
+    if(!battery || !data || !copy){
+        free(battery);
+        free(data);
+        free(copy);
+        return NULL;
+    }
+    strcpy(copy, path);
+    battery->data = data;
+    battery->mode = mode;
+    battery->path = copy;
+
+    int n = read_file(path, data);
+    if(mode == BATTERY_PRIVATE && n < BUS_PRG_RAM_SIZE){
+        free(battery->data);
+        free(battery->path);
+        free(battery);
+        return NULL;
+    }
+    return battery;
+}
+
+void battery_close(Battery* battery){
+    if(!battery) return;
+    battery_sync(battery, 1);
+    free(battery->data);
+    free(battery->path);
+    free(battery);
+}
+
+int battery_sync(Battery* battery, int wait){
+    (void)wait;
+    battery->frames = 0;
+    if(battery->mode != BATTERY_SHARED) return 1;
+    FILE* fp = fopen(battery->path, "wb");
+    if(!fp) return 0;
+    int ok = fwrite(battery->data, 1, BUS_PRG_RAM_SIZE, fp) == BUS_PRG_RAM_SIZE;
+    return (fclose(fp) == 0) && ok;
+}
+
+int battery_revert(Battery* battery){
+    if(battery->mode != BATTERY_PRIVATE) return 0;
+    return read_file(battery->path, battery->data) == BUS_PRG_RAM_SIZE;
+}
+
+#endif
+
+uint8_t* battery_data(Battery* battery){
+    return battery->data;
+}
+
+void battery_end_frame(Battery* battery){
+    if(++battery->frames >= BATTERY_SYNC_FRAMES){
+        battery_sync(battery, 0);
+    }
+}
@@ -0,0 +1,41 @@
+// battery.h
+#pragma once
+#include <stdint.h>
+#include "ines.h"
+
+// 电池存档：带电池的卡带 (flags6 bit 1) 把 PRG-RAM 直接映射到存档文件 (.sav)，
+// 游戏写 $6000-$7FFF 就是写文件的页，存档不需要单独序列化、写盘，退出时刷一下就行。
+// 也可以私有映射一个模板存档：写入只留在本进程（写时复制），很多实例从同一个模板开始，
+// battery_revert 丢掉写入、回到模板，代价只是重新映射。
+// POSIX 上用 mmap；Windows 上退化成读进内存、同步时整块写回
+
+enum BatteryMode{
+    BATTERY_SHARED,   // 写入落到文件里；文件不存在时新建（内容全 0），不足 8KB 时补 0
+    BATTERY_PRIVATE,  // 从模板开始，写入不改文件；文件必须存在且至少 8KB
+};
+
+// 挂在机器上时每隔多少帧异步刷一次盘（约 10 秒）
+#define BATTERY_SYNC_FRAMES 600
+
+typedef struct Battery Battery;
+
+// 卡带有没有电池 (flags6 bit 1)
+int battery_present(const NesRom* rom);
+
+// 打开/新建存档文件并映射 BUS_PRG_RAM_SIZE 字节，失败返回 NULL
+Battery* battery_open(const char* path, int mode);
+// 刷盘、解除映射；先用 machine_attach_battery(m, NULL) 从机器上摘下来
+void battery_close(Battery* battery);
+
+// 映射进来的 8KB
+uint8_t* battery_data(Battery* battery);
+
+// 把写入刷到文件：wait 为 0 时只是发起写回，为 1 时等它落盘。私有映射什么都不做。成功返回 1
+int battery_sync(Battery* battery, int wait);
+
+// 私有映射丢掉所有写入，回到模板文件的内容（映射地址不变）；共享映射返回 0。
+// 挂在机器上时用 machine_revert_battery，否则增量存档不知道 PRG-RAM 变了
+int battery_revert(Battery* battery);
+
+// 机器每帧结束时调用：每 BATTERY_SYNC_FRAMES 帧发起一次异步写回
+void battery_end_frame(Battery* battery);
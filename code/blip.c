@@ -0,0 +1,101 @@
+// blip.c
+#include "blip.h"
+#include <math.h>
+#include <string.h> // for memset, memmove
+
+#define BLIP_PI 3.14159265358979323846
+
+// 冲激表：第 p 档表示阶跃发生在采样点之后 p/BLIP_PHASES 处。
+// 截止频率略低于奈奎斯特频率，Blackman 窗收尾，每一档的和归一化为 1<<BLIP_KERNEL_BITS，
+// 这样积分后的台阶高度恰好等于 delta。
+static void build_kernel(Blip* blip){
+    const double cutoff = 0.90;
+    const int half = BLIP_TAPS / 2;
+
+    for(int p = 0; p < BLIP_PHASES; p++){
+        double frac = (double)p / BLIP_PHASES;
+        double taps[BLIP_TAPS];
+        double sum = 0;
+
+        for(int k = 0; k < BLIP_TAPS; k++){
+            // 冲激中心落在第 half 个采样处（固定延迟 half 个采样）
+            double x = k - half + 1 - frac;
+            double sinc = (x == 0) ? cutoff : sin(BLIP_PI * cutoff * x) / (BLIP_PI * x);
+            double w = (x + half) / BLIP_TAPS; // 窗的位置 0..1
+            double window = 0.42 - 0.5 * cos(2 * BLIP_PI * w) + 0.08 * cos(4 * BLIP_PI * w);
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+
+        // 量化后再修正误差，保证每一档的和精确
+        int total = 0;
+        for(int k = 0; k < BLIP_TAPS; k++){
+            blip->kernel[p][k] = (int16_t)lround(taps[k] / sum * (1 << BLIP_KERNEL_BITS));
+            total += blip->kernel[p][k];
+        }
+        blip->kernel[p][half - 1] += (int16_t)((1 << BLIP_KERNEL_BITS) - total);
+    }
+}
+
+void blip_init(Blip* blip, double clock_rate, double sample_rate){
+    build_kernel(blip);
+    blip_set_rates(blip, clock_rate, sample_rate);
+    blip_clear(blip);
+}
+
+void blip_set_rates(Blip* blip, double clock_rate, double sample_rate){
+    blip->factor = (uint64_t)(sample_rate / clock_rate * 4294967296.0 + 0.5);
+}
+
+void blip_clear(Blip* blip){
+    blip->offset = 0;
+    blip->integrator = 0;
+    blip->avail = 0;
+    memset(blip->buf, 0, sizeof(blip->buf));
+}
+
+void blip_add_delta(Blip* blip, uint32_t time, int delta){
+    uint64_t pos = blip->offset + (uint64_t)time * blip->factor;
+    uint32_t index = (uint32_t)(pos >> 32);
+    // 调用方长时间不结束帧：丢掉放不下的跳变，而不是写坏内存
+    if(index >= BLIP_CAPACITY) return;
+
+    const int16_t* k = blip->kernel[(pos >> (32 - BLIP_PHASE_BITS)) & (BLIP_PHASES - 1)];
+    int32_t* out = &blip->buf[index];
+    for(int i = 0; i < BLIP_TAPS; i++){
+        out[i] += k[i] * delta;
+    }
+}
+
+void blip_end_frame(Blip* blip, uint32_t clocks){
+    blip->offset += (uint64_t)clocks * blip->factor;
+    blip->avail = (int)(blip->offset >> 32);
+    if(blip->avail > BLIP_CAPACITY) blip->avail = BLIP_CAPACITY;
+}
+
+int blip_read_samples(Blip* blip, int16_t* out, int count){
+    if(count > blip->avail) count = blip->avail;
+    if(count <= 0) return 0;
+
+    // 积分差分缓冲；每个采样漏掉一点积分值，相当于一阶高通
+    int32_t sum = blip->integrator;
+    for(int i = 0; i < count; i++){
+        sum += blip->buf[i];
+        int32_t level = sum >> BLIP_KERNEL_BITS;
+        int32_t s = level;
+        if(s > 32767) s = 32767;
+        if(s < -32768) s = -32768;
+        if(out) out[i] = (int16_t)s;
+        // 漏掉的是未削波的值，削波之后高通不会漂；负数不能左移，用乘法
+        sum -= level * (1 << (BLIP_KERNEL_BITS - BLIP_BASS_SHIFT));
+    }
+    blip->integrator = sum;
+
+    // 剩下的（包括还没结束的帧里已经叠加的部分）挪到开头
+    int remain = BLIP_CAPACITY + BLIP_TAPS - count;
+    memmove(blip->buf, blip->buf + count, (size_t)remain * sizeof(int32_t));
+    memset(blip->buf + remain, 0, (size_t)count * sizeof(int32_t));
+    blip->avail -= count;
+    blip->offset -= (uint64_t)count << 32;
+    return count;
+}
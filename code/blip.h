@@ -0,0 +1,46 @@
+// blip.h
+#pragma once
+#include <stdint.h>
+
+// 带限阶跃合成 (blip buffer)
+//
+// 声道不逐采样输出，而是在波形跳变的那个 CPU 周期往这里加一个"幅度差"。
+// 每个差值按它落在输出采样之间的小数位置，叠加一段带限冲激 (加窗 sinc)
+// 到差分缓冲里；读出时再积分，就得到没有混叠的阶跃波形。
+// 开销只和跳变次数成正比，和 1.79MHz 的 CPU 时钟无关。
+// 时钟 -> 采样的换算在叠加时完成，一帧结束后读出的就是目标采样率的 PCM。
+
+#define BLIP_TAPS     16    // 每个阶跃影响的输出采样数
+#define BLIP_PHASE_BITS 5
+#define BLIP_PHASES   (1 << BLIP_PHASE_BITS) // 采样之间的小数位置分成多少档
+#define BLIP_CAPACITY 4096  // 缓冲能容纳的输出采样数（48kHz 下约 85ms）
+
+#define BLIP_KERNEL_BITS 13 // 冲激表的定点精度
+#define BLIP_BASS_SHIFT  9  // 读出时的高通（去直流），约 15Hz
+
+typedef struct Blip{
+    uint64_t factor;  // 每个时钟对应多少个输出采样 (32.32 定点)
+    uint64_t offset;  // 当前帧起点在缓冲里的位置 (32.32 定点)
+    int32_t integrator;
+    int avail;        // 已经结束的帧里可以读出的采样数
+
+    int16_t kernel[BLIP_PHASES][BLIP_TAPS];
+    int32_t buf[BLIP_CAPACITY + BLIP_TAPS];
+} Blip;
+
+void blip_init(Blip* blip, double clock_rate, double sample_rate);
+
+// 修改时钟/采样率，不清空已有数据
+void blip_set_rates(Blip* blip, double clock_rate, double sample_rate);
+
+void blip_clear(Blip* blip);
+
+// 在本帧第 time 个时钟处，输出幅度变化 delta
+void blip_add_delta(Blip* blip, uint32_t time, int delta);
+
+// 本帧共 clocks 个时钟，结束后这些时钟对应的采样变为可读
+void blip_end_frame(Blip* blip, uint32_t clocks);
+
+// 读出最多 count 个采样（单声道 int16），返回实际读出的个数；
+// out 为 NULL 时只丢弃这些采样
+int blip_read_samples(Blip* blip, int16_t* out, int count);
@@ -8,6 +8,63 @@ void bus_init(Bus* bus, NesRom* rom){
 
     // 连接卡带 ("插入卡带")
     bus->cartridge = rom;
+
+    bus->ppu = NULL;
+    bus->cycles = 0;
+    bus->ppu_deadline = UINT64_MAX;
+    bus->apu = NULL;
+    bus->apu_deadline = UINT64_MAX;
+
+    memset(bus->controller, 0, sizeof(bus->controller));
+    memset(bus->controller_shift, 0, sizeof(bus->controller_shift));
+    bus->controller_strobe = 0;
+    bus->input_polled = 0;
+    bus->ram_dirty = 0;
+
+    // 卡带 PRG-RAM 上电也清零
+    bus->prg_ram = bus->prg_ram_store;
+    memset(bus->prg_ram_store, 0, sizeof(bus->prg_ram_store));
+    bus->prg_ram_dirty = 0;
+}
+
+// 从手柄移位寄存器读出一位；读完 8 位之后标准手柄一直返回 1
+static uint8_t read_controller(Bus* bus, int port){
+    bus->input_polled = 1;
+    if (bus->controller_strobe) {
+        // 锁存期间移位寄存器不停地重新装载，读到的总是 A 键
+        return 0x40 | (bus->controller[port] & 1);
+    }
+    uint8_t bit = bus->controller_shift[port] & 1;
+    bus->controller_shift[port] = (bus->controller_shift[port] >> 1) | 0x80;
+    // 高位是开放总线，通常是地址高字节 $40
+    return 0x40 | bit;
+}
+
+void bus_connect_ppu(Bus* bus, PPU* ppu){
+    bus->ppu = ppu;
+    bus_sync_ppu(bus);
+}
+
+void bus_sync_ppu(Bus* bus){
+    // 1 个 CPU 周期 = 3 个 PPU dot
+    ppu_run_to(bus->ppu, bus->cycles * PPU_DOTS_PER_CPU_CYCLE);
+    // 截止时间向上取整到 CPU 周期
+    uint64_t next = ppu_next_event(bus->ppu);
+    bus->ppu_deadline = (next + PPU_DOTS_PER_CPU_CYCLE - 1) / PPU_DOTS_PER_CPU_CYCLE;
+}
+
+void bus_connect_apu(Bus* bus, APU* apu){
+    bus->apu = apu;
+    apu->bus = bus;
+    bus_sync_apu(bus);
+}
+
+void bus_sync_apu(Bus* bus){
+    apu_run_to(bus->apu, bus->cycles);
+    // DMC 取样期间 CPU 被挂起
+    bus->cycles += bus->apu->dma_stall;
+    bus->apu->dma_stall = 0;
+    bus->apu_deadline = apu_next_event(bus->apu);
 }
 
 // 模拟 CPU 读取内存
@@ -19,13 +76,29 @@ uint8_t bus_read(Bus* bus, uint16_t addr){
         // 使用 & 0x07FF 可以把地址限制在 0-2047 之间 为什么 与运算讲解
         return bus->ram[addr & 0x07FF];
     }
-    //2. PPU 寄存器范围: $2000 - $3FFF (暂时留空)
+    //2. PPU 寄存器范围: $2000 - $3FFF (每 8 字节镜像一次)
     else if (addr >= 0x2000 && addr <= 0x3FFF) {
-        // TODO: return ppu_read_register(addr & 0x0007);
-        return 0;
+        if (!bus->ppu) return 0;
+        // 访问之前先让 PPU 追上当前时间
+        bus_sync_ppu(bus);
+        return ppu_read_register(bus->ppu, addr & 0x0007);
+    }
+    // APU 状态寄存器 $4015
+    else if (addr == 0x4015) {
+        if (!bus->apu) return 0;
+        bus_sync_apu(bus);
+        return apu_read_status(bus->apu);
+    }
+    // 手柄 1 / 手柄 2
+    else if (addr == 0x4016 || addr == 0x4017) {
+        return read_controller(bus, addr & 1);
+    }
+    // 卡带 PRG-RAM: $6000 - $7FFF
+    else if (addr >= 0x6000 && addr <= 0x7FFF) {
+        return bus->prg_ram[addr & 0x1FFF];
     }
     // 3. 卡带/ROM 范围: $8000 - $FFFF (通常用于 PRG-ROM)
-    // 注意：$4020-$7FFF 也属于卡带空间，但通常用于 Mapper 寄存器或 Save RAM
+    // 注意：$4020-$5FFF 也属于卡带空间，通常用于 Mapper 寄存器
     else if (addr >= 0x8000 && addr <= 0xFFFF) {
         // 这里需要读取你的 NesRom 中的数据
         // 这是一个简单的 Mapper 0 (NROM) 实现逻辑示例：
@@ -50,10 +123,48 @@ void bus_write(Bus* bus,uint16_t addr, uint8_t data){
     //1. CPU RAM 范围: $0000 - $1FFF
     if(addr >= 0x0000 && addr <= 0x1FFF){
         bus->ram[addr & 0x07FF] = data;
+        bus->ram_dirty |= 1 << ((addr & 0x07FF) >> 8);
     } 
     // 2. PPU 寄存器写入
     else if (addr >= 0x2000 && addr <= 0x3FFF) {
-        // TODO: ppu_write_register(addr & 0x0007, data);
+        if (!bus->ppu) return;
+        bus_sync_ppu(bus);
+        ppu_write_register(bus->ppu, addr & 0x0007, data);
+        // 写 PPUCTRL/PPUMASK 可能改变 NMI 或奇数帧的时间点
+        bus_sync_ppu(bus);
+    }
+    // OAM DMA: 把 CPU 的第 data 页 (256 字节) 拷贝进 OAM
+    else if (addr == 0x4014) {
+        if (!bus->ppu) return;
+        bus_sync_ppu(bus);
+        uint16_t page = (uint16_t)data << 8;
+        for (int i = 0; i < 256; i++) {
+            ppu_write_register(bus->ppu, 0x0004, bus_read(bus, page + i));
+        }
+        // DMA 期间 CPU 被挂起 513 个周期，奇数周期开始时再多 1 个
+        bus->cycles += 513 + (bus->cycles & 1);
+    }
+    // 手柄锁存：strobe 为 1 期间（包括从 1 变 0 的这一下）不断把当前按键装进移位寄存器
+    else if (addr == 0x4016) {
+        if (bus->controller_strobe || (data & 1)) {
+            bus->controller_shift[0] = bus->controller[0];
+            bus->controller_shift[1] = bus->controller[1];
+        }
+        bus->controller_strobe = data & 1;
+        bus->input_polled = 1;
+    }
+    // APU 寄存器 ($4016 是手柄，不归 APU)
+    else if ((addr >= 0x4000 && addr <= 0x4013) || addr == 0x4015 || addr == 0x4017) {
+        if (!bus->apu) return;
+        bus_sync_apu(bus);
+        apu_write_register(bus->apu, addr, data);
+        // 写 $4015/$4017 可能立即取样或者改变帧 IRQ 的时间点
+        bus_sync_apu(bus);
+    }
+    // 卡带 PRG-RAM
+    else if (addr >= 0x6000 && addr <= 0x7FFF) {
+        bus->prg_ram[addr & 0x1FFF] = data;
+        bus->prg_ram_dirty |= 1 << ((addr & 0x1FFF) >> 10);
     }
     // 3. 卡带区域写入
     else if (addr >= 0x8000 && addr <= 0xFFFF) {
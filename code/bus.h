@@ -2,24 +2,71 @@
 #pragma once
 #include <stdint.h>
 #include "ines.h"
+#include "ppu.h"
+#include "apu.h"
 
-typedef struct Bus{
-    //1. 系统自带的2KB RAM
-    // NES 的 RAM 只有 2KB (0x800)，范围是 0x0000-0x07FF
-    uint8_t ram[2048];
+// 卡带 PRG-RAM 的大小
+#define BUS_PRG_RAM_SIZE 0x2000
 
-    //2.插在总线上的卡带
+typedef struct Bus{
+    //1.插在总线上的卡带
     NesRom* cartridge;
 
-    // 3. 未来还需要加入 PPU, APU, 手柄状态等
-    // struct PPU* ppu; 
-    // uint8_t controller_state[2];
+    // 2. PPU：惰性同步，只有 CPU 访问 $2000-$3FFF / $4014 或到达截止时间时才追赶
+    PPU* ppu;
+
+    // 3. 主时钟：上电以来的 CPU 周期数，由 cpu_step 推进
+    uint64_t cycles;
+    // PPU 下一次必须同步的 CPU 周期（VBlank / NMI 的时间点）
+    uint64_t ppu_deadline;
+
+    // 4. APU：同样惰性同步，访问 $4000-$4017 或到达截止时间（帧 IRQ / DMC 取样）时追赶
+    APU* apu;
+    uint64_t apu_deadline;
+
+    // 5. 手柄：前端（或输入录像）每帧写 controller[n]，
+    // 按位依次是 A B Select Start 上 下 左 右（bit 0 = A）。
+    // 游戏向 $4016 写 1 再写 0 锁存按键，然后从 $4016/$4017 逐位读出。
+    uint8_t controller[2];
+    uint8_t controller_shift[2];
+    uint8_t controller_strobe;
+    // 这一帧游戏有没有写过 $4016 或读过 $4016/$4017；一帧都没碰过就是延迟帧（按键不可能起作用）。
+    // 每帧结束时由 machine_end_frame 结算并清零
+    uint8_t input_polled;
+
+    // 6. 写入追踪（增量存档用）：第 n 位 = RAM 的第 n 个 256 字节页自基准存档以来被写过
+    uint8_t ram_dirty;
+    // 同上，PRG-RAM 按 1KB 页
+    uint8_t prg_ram_dirty;
+
+    // 7. 系统自带的2KB RAM
+    // NES 的 RAM 只有 2KB (0x800)，范围是 0x0000-0x07FF。
+    // 放在最后：上面这些每条指令都要碰的时钟、截止时间紧跟在 CPU 寄存器后面，只占一两个缓存行
+    uint8_t ram[2048];
+
+    // 8. 卡带上的 8KB PRG-RAM（Save RAM），映射在 $6000-$7FFF。
+    // iNES 1.0 的文件头说不清卡带有没有，按惯例总是接上；测试 ROM 也在这里报告结果。
+    // prg_ram 平时指向下面自带的存储，带电池的卡带可以改指向映射进来的存档文件 (battery.h)
+    uint8_t* prg_ram;
+    uint8_t prg_ram_store[BUS_PRG_RAM_SIZE];
 
 } Bus;
 
 // 初始化总线，把卡带插上去
 void bus_init(Bus* bus, NesRom* rom);
 
+// 把 PPU 接到总线上
+void bus_connect_ppu(Bus* bus, PPU* ppu);
+
+// 把 PPU 追赶到当前主时钟，并重新计算下一次同步的截止时间
+void bus_sync_ppu(Bus* bus);
+
+// 把 APU 接到总线上
+void bus_connect_apu(Bus* bus, APU* apu);
+
+// 把 APU 追赶到当前主时钟，把 DMC 抢走的周期加回主时钟，并重新计算截止时间
+void bus_sync_apu(Bus* bus);
+
 // CPU 通过这两个函数与总线交互
 uint8_t bus_read(Bus* bus, uint16_t addr);
 void bus_write(Bus* bus, uint16_t addr, uint8_t data);
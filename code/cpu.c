@@ -8,7 +8,7 @@ typedef uint8_t (*AddrModeFunc)(CPU*);
 
 // 2. 定义指令结构体 (Instruction)
 typedef struct {
-    char* name; // 汇编助记符 (用于调试打印，如 "LDA")
+    const char* name; // 汇编助记符 (用于调试打印，如 "LDA")
     OpcodeFunc operate; //干活的函数 (如 op_lda)
     AddrModeFunc addrmode; //找数据的函数 (如 addr_imm)
     uint8_t cycles; //基础消耗周期
@@ -111,7 +111,8 @@ static uint8_t op_isc(CPU* cpu);
 static uint8_t op_usbc(CPU* cpu);
 
 
-Instruction lookup[256] = {
+// 只读的指令表：所有 CPU 实例共享，多线程同时运行多台机器也不需要任何同步
+static const Instruction lookup[256] = {
     { "BRK", &op_brk, &addr_imp, 7 },                   // 0x00
     { "ORA", &op_ora, &addr_izx, 6 },                   // 0x01
     { "JAM", &op_jam, &addr_imp, 0 },                 // 0x02 (JAM/KIL)
@@ -378,7 +379,7 @@ static uint8_t cpu_read(CPU* cpu, uint16_t addr){
 }
 
 // 封装总线写入
-void cpu_write(CPU* cpu, uint16_t addr, uint8_t data) {
+static void cpu_write(CPU* cpu, uint16_t addr, uint8_t data) {
     bus_write(cpu->bus, addr, data);
 }
 
@@ -397,7 +398,7 @@ static void set_flag(CPU* cpu, uint8_t f, uint8_t v){
 }
 
 // 根据当前寻址模式计算出的地址，读取数据到 fetched_data
-uint8_t fetch(CPU* cpu){
+static uint8_t fetch(CPU* cpu){
     // 只有非隐含寻址模式才需要去内存取数据
     // 注意：这里需要你后续填充 lookup 表，目前先写好逻辑
     // 假设 lookup 表名为 lookup
@@ -490,6 +491,7 @@ static uint8_t addr_ind(CPU* cpu){
         // 正常情况，直接读取指针指向的地址
         cpu->addr_abs = (cpu_read(cpu,ptr+1)<<8) | cpu_read(cpu,ptr);
     }
+    return 0;
 }
 
 static uint8_t addr_izx(CPU* cpu){
@@ -820,11 +822,10 @@ static uint8_t op_nop(CPU* cpu){
     // 没有改变任何寄存器或内存的操作，所以不需要执行任何操作。
     // 步骤 2: 更新标志位
     // 没有影响标志位的操作，所以不需要更新
-    // 图片里没有 "(+1 if page crossed)"。
-    // 这意味着即使 addr_abx() 因为跨页返回了 1，
-    // NOP 指令也不允许增加额外周期（写入操作必须稳定，不能贪快）。
-    // 所以强制返回 0。
-    return 0;
+    // 非官方的 NOP $xxxx,X (0x1C/0x3C/...) 会真的去读内存，
+    // 跨页时和 LDA 一样多 1 个周期，所以这里返回 1。
+    // 隐含/零页/绝对寻址的 NOP 其寻址函数返回 0，不受影响。
+    return 1;
 }
 
 // AND: Logical AND with Accumulator
@@ -1581,7 +1582,7 @@ static uint8_t op_rol(CPU* cpu){
     // 【关键修正】左移出的位是 Bit 7。
     // 方法 A：检查原数据的 0x80
     // 方法 B (推荐)：检查 16 位结果的高 8 位是否有值 (temp > 255)
-    set_flag(cpu, C, (temp & 0xFF00)); 
+    set_flag(cpu, C, (temp & 0xFF00) > 0); 
     
     set_flag(cpu, Z, (temp & 0x00FF) == 0x00);
     set_flag(cpu, N, temp & 0x80);
@@ -1745,4 +1746,295 @@ static uint8_t op_rti(CPU* cpu) {
     cpu->pc = (hi << 8) | lo;
 
     return 0;
-}
\ No newline at end of file
+}
+
+// --- 非官方指令实现 ---
+// 这些指令大多是两条官方指令的"组合"（先读改写内存，再和 A 做运算），
+// nestest 等测试 ROM 会用到它们，所以必须实现。
+
+// JAM: CPU 死机，PC 停在原地不再前进
+static uint8_t op_jam(CPU* cpu){
+    cpu->jammed = 1;
+    cpu->pc--;
+    return 0;
+}
+
+// SLO: ASL 内存 + ORA
+static uint8_t op_slo(CPU* cpu){
+    fetch(cpu);
+    set_flag(cpu, C, cpu->fetched_data & 0x80);
+    uint8_t temp = cpu->fetched_data << 1;
+    cpu_write(cpu, cpu->addr_abs, temp);
+    cpu->a |= temp;
+    set_flag(cpu, Z, cpu->a == 0x00);
+    set_flag(cpu, N, cpu->a & 0x80);
+    return 0;
+}
+
+// ANC: AND 立即数，然后把 N 复制到 C
+static uint8_t op_anc(CPU* cpu){
+    fetch(cpu);
+    cpu->a &= cpu->fetched_data;
+    set_flag(cpu, Z, cpu->a == 0x00);
+    set_flag(cpu, N, cpu->a & 0x80);
+    set_flag(cpu, C, cpu->a & 0x80);
+    return 0;
+}
+
+// RLA: ROL 内存 + AND
+static uint8_t op_rla(CPU* cpu){
+    fetch(cpu);
+    uint8_t temp = (cpu->fetched_data << 1) | get_flag(cpu, C);
+    set_flag(cpu, C, cpu->fetched_data & 0x80);
+    cpu_write(cpu, cpu->addr_abs, temp);
+    cpu->a &= temp;
+    set_flag(cpu, Z, cpu->a == 0x00);
+    set_flag(cpu, N, cpu->a & 0x80);
+    return 0;
+}
+
+// SRE: LSR 内存 + EOR
+static uint8_t op_sre(CPU* cpu){
+    fetch(cpu);
+    set_flag(cpu, C, cpu->fetched_data & 0x01);
+    uint8_t temp = cpu->fetched_data >> 1;
+    cpu_write(cpu, cpu->addr_abs, temp);
+    cpu->a ^= temp;
+    set_flag(cpu, Z, cpu->a == 0x00);
+    set_flag(cpu, N, cpu->a & 0x80);
+    return 0;
+}
+
+// ALR: AND 立即数 + LSR A
+static uint8_t op_alr(CPU* cpu){
+    fetch(cpu);
+    uint8_t temp = cpu->a & cpu->fetched_data;
+    set_flag(cpu, C, temp & 0x01);
+    cpu->a = temp >> 1;
+    set_flag(cpu, Z, cpu->a == 0x00);
+    set_flag(cpu, N, cpu->a & 0x80);
+    return 0;
+}
+
+// RRA: ROR 内存 + ADC
+static uint8_t op_rra(CPU* cpu){
+    fetch(cpu);
+    uint8_t temp = (cpu->fetched_data >> 1) | (get_flag(cpu, C) << 7);
+    set_flag(cpu, C, cpu->fetched_data & 0x01);
+    cpu_write(cpu, cpu->addr_abs, temp);
+    // op_adc 内部会重新 fetch，读到的正是刚写回的值
+    op_adc(cpu);
+    return 0;
+}
+
+// ARR: AND 立即数 + ROR A，C/V 来自结果的 bit 6 / bit 5
+static uint8_t op_arr(CPU* cpu){
+    fetch(cpu);
+    uint8_t temp = cpu->a & cpu->fetched_data;
+    cpu->a = (temp >> 1) | (get_flag(cpu, C) << 7);
+    set_flag(cpu, Z, cpu->a == 0x00);
+    set_flag(cpu, N, cpu->a & 0x80);
+    set_flag(cpu, C, cpu->a & 0x40);
+    set_flag(cpu, V, ((cpu->a >> 6) ^ (cpu->a >> 5)) & 0x01);
+    return 0;
+}
+
+// SAX: 写入 A & X，不影响标志位
+static uint8_t op_sax(CPU* cpu){
+    cpu_write(cpu, cpu->addr_abs, cpu->a & cpu->x);
+    return 0;
+}
+
+// ANE (XAA): 不稳定指令，这里采用常见的 magic = 0xEE
+static uint8_t op_ane(CPU* cpu){
+    fetch(cpu);
+    cpu->a = (cpu->a | 0xEE) & cpu->x & cpu->fetched_data;
+    set_flag(cpu, Z, cpu->a == 0x00);
+    set_flag(cpu, N, cpu->a & 0x80);
+    return 0;
+}
+
+// SHA / TAS / SHY / SHX: 写入 "寄存器 & (目标地址高字节 + 1)"
+static uint8_t op_sha(CPU* cpu){
+    uint8_t hi = (cpu->addr_abs >> 8) + 1;
+    cpu_write(cpu, cpu->addr_abs, cpu->a & cpu->x & hi);
+    return 0;
+}
+
+static uint8_t op_tas(CPU* cpu){
+    uint8_t hi = (cpu->addr_abs >> 8) + 1;
+    cpu->stkp = cpu->a & cpu->x;
+    cpu_write(cpu, cpu->addr_abs, cpu->stkp & hi);
+    return 0;
+}
+
+static uint8_t op_shy(CPU* cpu){
+    uint8_t hi = (cpu->addr_abs >> 8) + 1;
+    cpu_write(cpu, cpu->addr_abs, cpu->y & hi);
+    return 0;
+}
+
+static uint8_t op_shx(CPU* cpu){
+    uint8_t hi = (cpu->addr_abs >> 8) + 1;
+    cpu_write(cpu, cpu->addr_abs, cpu->x & hi);
+    return 0;
+}
+
+// LAX: LDA + LDX
+static uint8_t op_lax(CPU* cpu){
+    fetch(cpu);
+    cpu->a = cpu->fetched_data;
+    cpu->x = cpu->fetched_data;
+    set_flag(cpu, Z, cpu->a == 0x00);
+    set_flag(cpu, N, cpu->a & 0x80);
+    return 1;
+}
+
+// LXA: 不稳定指令，同样采用 magic = 0xEE
+static uint8_t op_lxa(CPU* cpu){
+    fetch(cpu);
+    cpu->a = (cpu->a | 0xEE) & cpu->fetched_data;
+    cpu->x = cpu->a;
+    set_flag(cpu, Z, cpu->a == 0x00);
+    set_flag(cpu, N, cpu->a & 0x80);
+    return 0;
+}
+
+// LAS: A = X = SP = M & SP
+static uint8_t op_las(CPU* cpu){
+    fetch(cpu);
+    uint8_t temp = cpu->fetched_data & cpu->stkp;
+    cpu->a = temp;
+    cpu->x = temp;
+    cpu->stkp = temp;
+    set_flag(cpu, Z, temp == 0x00);
+    set_flag(cpu, N, temp & 0x80);
+    return 1;
+}
+
+// DCP: DEC 内存 + CMP
+static uint8_t op_dcp(CPU* cpu){
+    fetch(cpu);
+    uint8_t temp = cpu->fetched_data - 1;
+    cpu_write(cpu, cpu->addr_abs, temp);
+    set_flag(cpu, C, cpu->a >= temp);
+    set_flag(cpu, Z, cpu->a == temp);
+    set_flag(cpu, N, (uint8_t)(cpu->a - temp) & 0x80);
+    return 0;
+}
+
+// SBX: X = (A & X) - M，不借位，C 的规则与 CMP 相同
+static uint8_t op_sbx(CPU* cpu){
+    fetch(cpu);
+    uint8_t ax = cpu->a & cpu->x;
+    cpu->x = ax - cpu->fetched_data;
+    set_flag(cpu, C, ax >= cpu->fetched_data);
+    set_flag(cpu, Z, cpu->x == 0x00);
+    set_flag(cpu, N, cpu->x & 0x80);
+    return 0;
+}
+
+// ISC: INC 内存 + SBC
+static uint8_t op_isc(CPU* cpu){
+    fetch(cpu);
+    uint8_t temp = cpu->fetched_data + 1;
+    cpu_write(cpu, cpu->addr_abs, temp);
+    // op_sbc 内部会重新 fetch，读到的正是刚写回的值
+    op_sbc(cpu);
+    return 0;
+}
+
+// USBC: 0xEB，行为与官方 SBC 立即数完全相同
+static uint8_t op_usbc(CPU* cpu){
+    op_sbc(cpu);
+    return 0;
+}
+
+
+// --- 对外接口 ---
+void cpu_connect_bus(CPU* cpu, Bus* bus){
+    cpu->bus = bus;
+}
+
+// 复位：从 $FFFC/$FFFD 读取入口地址
+void cpu_reset(CPU* cpu){
+    uint16_t lo = cpu_read(cpu, 0xFFFC);
+    uint16_t hi = cpu_read(cpu, 0xFFFD);
+    cpu->pc = (hi << 8) | lo;
+
+    cpu->a = 0;
+    cpu->x = 0;
+    cpu->y = 0;
+    cpu->stkp = 0xFD;
+    cpu->status = U | I;
+    cpu->jammed = 0;
+
+    cpu->fetched_data = 0;
+    cpu->addr_abs = 0;
+    cpu->addr_rel = 0;
+    cpu->opcode = 0;
+
+    // 复位序列本身消耗 7 个周期
+    cpu->cycles = 7;
+    cpu->bus->cycles += cpu->cycles;
+}
+
+// 中断的公共部分：压栈 PC 和状态，然后跳到向量
+static void cpu_interrupt(CPU* cpu, uint16_t vector){
+    cpu_write(cpu, 0x0100 + cpu->stkp, (cpu->pc >> 8) & 0xFF);
+    cpu->stkp--;
+    cpu_write(cpu, 0x0100 + cpu->stkp, cpu->pc & 0xFF);
+    cpu->stkp--;
+
+    // 硬件中断压栈时 B = 0, U = 1
+    cpu_write(cpu, 0x0100 + cpu->stkp, (cpu->status & ~B) | U);
+    cpu->stkp--;
+    set_flag(cpu, I, 1);
+
+    uint16_t lo = cpu_read(cpu, vector);
+    uint16_t hi = cpu_read(cpu, vector + 1);
+    cpu->pc = (hi << 8) | lo;
+
+    cpu->cycles = 7;
+    cpu->bus->cycles += cpu->cycles;
+}
+
+// 不可屏蔽中断 (PPU VBlank)
+void cpu_nmi(CPU* cpu){
+    cpu_interrupt(cpu, 0xFFFA);
+}
+
+// 可屏蔽中断 (APU / Mapper)，I 标志置位时被忽略
+void cpu_irq(CPU* cpu){
+    if(get_flag(cpu, I) == 0){
+        cpu_interrupt(cpu, 0xFFFE);
+    }
+}
+
+// 执行一整条指令，返回它消耗的周期数
+// 基础周期在执行之前就记到 bus->cycles 上，这样指令里的读写
+// 看到的时间戳是指令末尾（绝大多数 6502 指令正是在最后一个周期访问总线），
+// 惰性同步的 PPU 据此追赶时误差最小。
+uint8_t cpu_step(CPU* cpu){
+    if(cpu->jammed){
+        cpu->bus->cycles++;
+        return 1;
+    }
+
+    cpu->opcode = cpu_read(cpu, cpu->pc++);
+    set_flag(cpu, U, 1);
+
+    const Instruction* ins = &lookup[cpu->opcode];
+    uint8_t base = ins->cycles;
+    cpu->cycles = base;
+    cpu->bus->cycles += base;
+
+    // 寻址模式和指令都"愿意"加周期时，才真正加 1（跨页惩罚）
+    uint8_t extra1 = ins->addrmode(cpu);
+    uint8_t extra2 = ins->operate(cpu);
+    cpu->cycles += (extra1 & extra2);
+
+    // 分支指令会在 operate 内部直接累加 cpu->cycles
+    cpu->bus->cycles += cpu->cycles - base;
+    return cpu->cycles;
+}
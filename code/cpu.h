@@ -34,4 +34,17 @@ typedef struct CPU{
     uint8_t opcode;   //当前指令的操作码
     uint8_t  cycles;         // 当前指令剩余的执行周期数
 
-} CPU;
\ No newline at end of file
+} CPU;
+
+// 连接总线
+void cpu_connect_bus(CPU* cpu, Bus* bus);
+
+// 复位 CPU（读取 $FFFC 复位向量）
+void cpu_reset(CPU* cpu);
+
+// 执行一条完整指令，返回消耗的 CPU 周期数，并推进 bus->cycles
+uint8_t cpu_step(CPU* cpu);
+
+// 外部中断
+void cpu_nmi(CPU* cpu);
+void cpu_irq(CPU* cpu);
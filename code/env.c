@@ -0,0 +1,133 @@
+// env.c
+#include "env.h"
+#include "arena.h"
+#include "aligned.h"
+#include <stdlib.h>
+#include <string.h> // for memcpy
+
+struct EnvBatch{
+    int count;
+    int frame_skip;
+    int skip_lag;       // 每步之后最多再跑几个延迟帧
+    ThreadPool* pool;
+
+    MachineArena* arena;
+    Machine** machines;
+    Machine* start;     // 复位的起点
+
+    // 这一步的参数，线程池里的任务从这里取
+    const uint8_t* actions;
+    uint8_t* obs_out;
+    uint8_t* ram_out;
+};
+
+EnvBatch* env_create(NesRom* rom, int count, int frame_skip, ThreadPool* pool){
+    if(count <= 0) return NULL;
+    EnvBatch* envs = (EnvBatch*)calloc(1, sizeof(EnvBatch));
+    if(!envs) return NULL;
+    envs->count = count;
+    envs->frame_skip = frame_skip < 1 ? 1 : frame_skip;
+    envs->pool = pool;
+    envs->arena = arena_create(rom, count, ARENA_HUGE_PAGES);
+    envs->machines = (Machine**)malloc((size_t)count * sizeof(Machine*));
+    envs->start = (Machine*)aligned_calloc(_Alignof(Machine), sizeof(Machine));
+    if(!envs->arena || !envs->machines || !envs->start){
+        arena_destroy(envs->arena);
+        free(envs->machines);
+        aligned_free(envs->start);
+        free(envs);
+        return NULL;
+    }
+    for(int i = 0; i < count; i++){
+        envs->machines[i] = arena_alloc(envs->arena);
+    }
+    // 起点默认就是上电状态
+    machine_fork(envs->machines[0], envs->start);
+    return envs;
+}
+
+void env_destroy(EnvBatch* envs){
+    if(!envs) return;
+    machine_release(envs->start);
+    aligned_free(envs->start);
+    arena_destroy(envs->arena);
+    free(envs->machines);
+    free(envs);
+}
+
+int env_count(const EnvBatch* envs){
+    return envs->count;
+}
+
+int env_frame_skip(const EnvBatch* envs){
+    return envs->frame_skip;
+}
+
+Machine* env_machine(EnvBatch* envs, int index){
+    return envs->machines[index];
+}
+
+void env_set_skip_lag(EnvBatch* envs, int max_frames){
+    envs->skip_lag = max_frames < 0 ? 0 : max_frames;
+}
+
+void env_set_start_state(EnvBatch* envs, Machine* state){
+    machine_release(envs->start);
+    machine_fork(state, envs->start);
+}
+
+static void reset_one(EnvBatch* envs, int index){
+    Machine* m = envs->machines[index];
+    machine_release(m);
+    machine_fork(envs->start, m);
+}
+
+void env_reset(EnvBatch* envs, int index){
+    if(index >= 0){
+        reset_one(envs, index);
+        return;
+    }
+    for(int i = 0; i < envs->count; i++){
+        reset_one(envs, i);
+    }
+}
+
+// 一台环境走一步，然后把观测写到调用方数组里它的位置上
+static void step_one(void* arg, int index, int worker){
+    (void)worker;
+    EnvBatch* envs = (EnvBatch*)arg;
+    Machine* m = envs->machines[index];
+
+    machine_set_input(m, 0, envs->actions[index]);
+    // 只有要输出画面时，最后一帧才画
+    for(int f = 0; f < envs->frame_skip; f++){
+        m->ppu.skip_render = !(envs->obs_out && f == envs->frame_skip - 1);
+        machine_run_frame(m);
+    }
+    // 延迟帧很少，并进来的帧都画
+    m->ppu.skip_render = !envs->obs_out;
+    machine_skip_lag(m, envs->skip_lag);
+    m->ppu.skip_render = 0;
+
+    if(envs->obs_out){
+        memcpy(envs->obs_out + (size_t)index * ENV_OBS_BYTES, m->ppu.frame.pixels, ENV_OBS_BYTES);
+    }
+    if(envs->ram_out){
+        memcpy(envs->ram_out + (size_t)index * ENV_RAM_BYTES, m->bus.ram, ENV_RAM_BYTES);
+    }
+}
+
+void env_step_batch(EnvBatch* envs, const uint8_t* actions, int n, uint8_t* obs_out, uint8_t* ram_out){
+    if(n > envs->count) n = envs->count;
+    envs->actions = actions;
+    envs->obs_out = obs_out;
+    envs->ram_out = ram_out;
+
+    if(envs->pool){
+        thread_pool_run(envs->pool, n, step_one, envs);
+    } else {
+        for(int i = 0; i < n; i++){
+            step_one(envs, i, 0);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+// env.h
+#pragma once
+#include <stdint.h>
+#include "machine.h"
+#include "thread_pool.h"
+
+// 强化学习用的批量环境：N 台同一个 ROM 的机器，一次调用全部前进一步。
+// 观测写进调用方提供的连续数组（第 i 台在 obs + i * ENV_OBS_BYTES）：每台每步从自己的画面拷贝一次
+// ENV_OBS_BYTES 字节（RAM 同样拷贝一次），没有别的中间缓冲，每一步也不分配内存。
+//
+// 一步 = frame_skip 帧，期间一直按着这一步的动作；只有最后一帧画画面，前面几帧只跑 CPU 可见的状态。
+// 复位不重新上电，而是从缓存的起始状态分支 (machine_fork)，只拷贝寄存器和 2KB RAM。
+// 机器放在实例池 (arena.h) 里，不合成音频
+
+// 一帧画面：调色板索引格式，每像素 1 字节 (PpuFrame.pixels)
+#define ENV_OBS_BYTES (PPU_WIDTH * PPU_HEIGHT)
+// 主机 RAM
+#define ENV_RAM_BYTES 2048
+
+typedef struct EnvBatch EnvBatch;
+
+// count 台环境，每步 frame_skip (>= 1) 帧；pool 为 NULL 时在调用线程上逐台运行。
+// 所有环境都从上电状态开始，失败返回 NULL
+EnvBatch* env_create(NesRom* rom, int count, int frame_skip, ThreadPool* pool);
+void env_destroy(EnvBatch* envs);
+
+int env_count(const EnvBatch* envs);
+int env_frame_skip(const EnvBatch* envs);
+// 第 i 台机器（读状态、调试用；不要在 env_step_batch 运行期间改它）
+Machine* env_machine(EnvBatch* envs, int index);
+
+// 把 state 此刻的状态缓存为以后复位的起点（比如跳过标题画面之后），并不影响已有的环境
+void env_set_start_state(EnvBatch* envs, Machine* state);
+
+// 每一步的 frame_skip 帧之后，最后一帧是延迟帧 (machine_lag_frame) 就接着跑，最多 max_frames 帧，
+// 下一步的动作就不会落在游戏不读手柄的帧上（延迟帧并进前一步）。0 = 关闭（默认）
+void env_set_skip_lag(EnvBatch* envs, int max_frames);
+
+// 第 index 台回到起始状态；index < 0 时全部复位
+void env_reset(EnvBatch* envs, int index);
+
+// 前 n 台各走一步：actions[i] 是第 i 台手柄 1 的按键 (bit 0 = A ... bit 7 = 右)。
+// obs_out 放 n * ENV_OBS_BYTES 字节的画面，ram_out 放 n * ENV_RAM_BYTES 字节的 RAM；
+// 传 NULL 的就不输出（obs_out 为 NULL 时这一步一帧都不画）
+void env_step_batch(EnvBatch* envs, const uint8_t* actions, int n, uint8_t* obs_out, uint8_t* ram_out);
@@ -0,0 +1,294 @@
+// env_shm.c
+#include "env_shm.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+struct EnvShm{
+    EnvBatch* envs;
+    char* name;
+    uint8_t* base;
+    EnvShmHeader* header;
+    uint32_t served;       // 最近处理完的请求号
+    EnvRewardFunc reward;
+    void* user;
+};
+
+struct EnvShmClient{
+    uint8_t* base;
+    EnvShmHeader* header;
+    size_t size;
+};
+
+static uint64_t align_up(uint64_t x, uint64_t a){
+    return (x + a - 1) & ~(a - 1);
+}
+
+// 跨进程的 futex：不带 FUTEX_PRIVATE_FLAG，按共享内存的物理页匹配
+static void futex_wake(_Atomic uint32_t* word){
+    syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+static uint64_t now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// 等 *word 不再是 value，或者 shutdown。返回 1 = 变了，0 = 超时，-1 = 关闭
+static int futex_wait_change(_Atomic uint32_t* word, uint32_t value, _Atomic uint32_t* shutdown, int timeout_ms){
+    uint64_t deadline = timeout_ms >= 0 ? now_ms() + (uint64_t)timeout_ms : 0;
+    for(;;){
+        if(atomic_load(shutdown)) return -1;
+        if(atomic_load(word) != value) return 1;
+
+        struct timespec ts, *tsp = NULL;
+        if(timeout_ms >= 0){
+            uint64_t now = now_ms();
+            if(now >= deadline) return 0;
+            uint64_t left = deadline - now;
+            ts.tv_sec = (time_t)(left / 1000);
+            ts.tv_nsec = (long)(left % 1000) * 1000000;
+            tsp = &ts;
+        }
+        // 值已经变了会立即返回 EAGAIN；被唤醒、超时、信号打断都回到循环开头重新检查
+        syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT, value, tsp, NULL, 0);
+    }
+}
+
+EnvShm* env_shm_create(const char* name, EnvBatch* envs){
+    uint32_t n = (uint32_t)env_count(envs);
+
+    // 布局
+    EnvShmHeader layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.magic = ENV_SHM_MAGIC;
+    layout.version = ENV_SHM_VERSION;
+    layout.env_count = n;
+    layout.obs_bytes = ENV_OBS_BYTES;
+    layout.ram_bytes = ENV_RAM_BYTES;
+    layout.frame_skip = (uint32_t)env_frame_skip(envs);
+    layout.action_offset = align_up(sizeof(EnvShmHeader), 64);
+    layout.reset_offset = align_up(layout.action_offset + n, 64);
+    layout.reward_offset = align_up(layout.reset_offset + n, 64);
+    layout.ram_offset = align_up(layout.reward_offset + (uint64_t)n * sizeof(float), 4096);
+    layout.obs_offset = align_up(layout.ram_offset + (uint64_t)n * ENV_RAM_BYTES, 4096);
+    layout.total_size = align_up(layout.obs_offset + (uint64_t)n * ENV_OBS_BYTES, 4096);
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(fd < 0) return NULL;
+    if(ftruncate(fd, (off_t)layout.total_size) != 0){
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    void* base = mmap(NULL, layout.total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED){
+        shm_unlink(name);
+        return NULL;
+    }
+
+    EnvShm* shm = (EnvShm*)calloc(1, sizeof(EnvShm));
+    char* copy = (char*)malloc(strlen(name) + 1);
+    if(!shm || !copy){
+        free(shm);
+        free(copy);
+        munmap(base, layout.total_size);
+        shm_unlink(name);
+        return NULL;
+    }
+    strcpy(copy, name);
+    shm->envs = envs;
+    shm->name = copy;
+    shm->base = (uint8_t*)base;
+    shm->header = (EnvShmHeader*)base;
+
+    // 新建的共享内存全是 0；最后写 magic，打开的一方看到 magic 时布局已经完整
+    EnvShmHeader* h = shm->header;
+    h->version = layout.version;
+    h->env_count = layout.env_count;
+    h->frame_skip = layout.frame_skip;
+    h->obs_bytes = layout.obs_bytes;
+    h->ram_bytes = layout.ram_bytes;
+    h->total_size = layout.total_size;
+    h->action_offset = layout.action_offset;
+    h->reset_offset = layout.reset_offset;
+    h->reward_offset = layout.reward_offset;
+    h->ram_offset = layout.ram_offset;
+    h->obs_offset = layout.obs_offset;
+    h->want_obs = 1;
+    atomic_thread_fence(memory_order_release);
+    h->magic = ENV_SHM_MAGIC;
+    return shm;
+}
+
+void env_shm_destroy(EnvShm* shm){
+    if(!shm) return;
+    atomic_store(&shm->header->shutdown, 1);
+    futex_wake(&shm->header->done);
+    munmap(shm->base, shm->header->total_size);
+    shm_unlink(shm->name);
+    free(shm->name);
+    free(shm);
+}
+
+void env_shm_set_reward(EnvShm* shm, EnvRewardFunc reward, void* user){
+    shm->reward = reward;
+    shm->user = user;
+}
+
+int env_shm_serve(EnvShm* shm, int timeout_ms){
+    EnvShmHeader* h = shm->header;
+    int r = futex_wait_change(&h->request, shm->served, &h->shutdown, timeout_ms);
+    if(r <= 0) return r;
+    uint32_t seq = atomic_load(&h->request);
+
+    int n = (int)h->env_count;
+    uint8_t* reset = shm->base + h->reset_offset;
+    for(int i = 0; i < n; i++){
+        if(reset[i]){
+            env_reset(shm->envs, i);
+            reset[i] = 0;
+        }
+    }
+    // 观测直接写进共享内存
+    env_step_batch(shm->envs, shm->base + h->action_offset, n,
+                   h->want_obs ? shm->base + h->obs_offset : NULL, shm->base + h->ram_offset);
+
+    float* rewards = (float*)(shm->base + h->reward_offset);
+    for(int i = 0; i < n; i++){
+        rewards[i] = shm->reward ? shm->reward(shm->user, env_machine(shm->envs, i), i) : 0.0f;
+    }
+
+    shm->served = seq;
+    atomic_store(&h->done, seq);
+    futex_wake(&h->done);
+    return 1;
+}
+
+EnvShmClient* env_shm_open(const char* name){
+    int fd = shm_open(name, O_RDWR, 0);
+    if(fd < 0) return NULL;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(EnvShmHeader)){
+        close(fd);
+        return NULL;
+    }
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) return NULL;
+
+    EnvShmHeader* h = (EnvShmHeader*)base;
+    if(h->magic != ENV_SHM_MAGIC || h->version != ENV_SHM_VERSION || h->total_size > (uint64_t)st.st_size){
+        munmap(base, (size_t)st.st_size);
+        return NULL;
+    }
+    atomic_thread_fence(memory_order_acquire);
+
+    EnvShmClient* client = (EnvShmClient*)malloc(sizeof(EnvShmClient));
+    if(!client){
+        munmap(base, (size_t)st.st_size);
+        return NULL;
+    }
+    client->base = (uint8_t*)base;
+    client->header = h;
+    client->size = (size_t)st.st_size;
+    return client;
+}
+
+void env_shm_close(EnvShmClient* client){
+    if(!client) return;
+    atomic_store(&client->header->shutdown, 1);
+    futex_wake(&client->header->request);
+    munmap(client->base, client->size);
+    free(client);
+}
+
+EnvShmHeader* env_shm_header(EnvShmClient* client){
+    return client->header;
+}
+
+int env_shm_step(EnvShmClient* client, int timeout_ms){
+    EnvShmHeader* h = client->header;
+    // 请求号只有训练进程自己写
+    uint32_t seq = atomic_load(&h->request);
+    // 上一个请求还挂着：模拟进程可能正在读 actions，不能叠一个新的上去
+    if(atomic_load(&h->done) != seq) return 0;
+    atomic_store(&h->request, seq + 1);
+    futex_wake(&h->request);
+    return env_shm_wait(client, timeout_ms);
+}
+
+int env_shm_wait(EnvShmClient* client, int timeout_ms){
+    EnvShmHeader* h = client->header;
+    uint32_t seq = atomic_load(&h->request);
+    uint32_t done = atomic_load(&h->done);
+    while(done != seq){
+        int r = futex_wait_change(&h->done, done, &h->shutdown, timeout_ms);
+        if(r <= 0) return r;
+        done = atomic_load(&h->done);
+    }
+    return 1;
+}
+
+#else
+
+// 其他平台：没有 POSIX 共享内存和 futex
+EnvShm* env_shm_create(const char* name, EnvBatch* envs){
+    (void)name;
+    (void)envs;
+    return NULL;
+}
+
+void env_shm_destroy(EnvShm* shm){
+    (void)shm;
+}
+
+void env_shm_set_reward(EnvShm* shm, EnvRewardFunc reward, void* user){
+    (void)shm;
+    (void)reward;
+    (void)user;
+}
+
+int env_shm_serve(EnvShm* shm, int timeout_ms){
+    (void)shm;
+    (void)timeout_ms;
+    return -1;
+}
+
+EnvShmClient* env_shm_open(const char* name){
+    (void)name;
+    return NULL;
+}
+
+void env_shm_close(EnvShmClient* client){
+    (void)client;
+}
+
+EnvShmHeader* env_shm_header(EnvShmClient* client){
+    (void)client;
+    return NULL;
+}
+
+int env_shm_step(EnvShmClient* client, int timeout_ms){
+    (void)client;
+    (void)timeout_ms;
+    return -1;
+}
+
+int env_shm_wait(EnvShmClient* client, int timeout_ms){
+    (void)client;
+    (void)timeout_ms;
+    return -1;
+}
+
+#endif
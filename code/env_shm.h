@@ -0,0 +1,80 @@
+// env_shm.h
+#pragma once
+#include <stdint.h>
+#include <stdatomic.h>
+#include "env.h"
+
+// 把批量环境 (env.h) 的观测放进 POSIX 共享内存，给同一台 Linux 主机上别的进程（训练器）直接读：
+// 没有拷贝，没有套接字。模拟进程调用 env_shm_serve 等待请求，训练进程用 env_shm_step 发请求并等结果，
+// 双方在共享内存里的两个 futex 字上握手。只支持 Linux；其他平台上创建/打开都返回 NULL。
+//
+// 共享内存布局（所有偏移相对映射起点，数组起点按 64 字节对齐，画面和 RAM 按 4KB 页对齐）：
+//
+//   0               EnvShmHeader
+//   action_offset   uint8_t  actions[env_count]            训练进程写：这一步手柄 1 的按键
+//   reset_offset    uint8_t  reset[env_count]              训练进程写：非 0 = 这一步之前先复位（模拟进程处理后清零）
+//   reward_offset   float    rewards[env_count]            模拟进程写：奖励函数的结果（没设奖励函数时为 0）
+//   ram_offset      uint8_t  ram[env_count][ram_bytes]     模拟进程写：主机 RAM
+//   obs_offset      uint8_t  obs[env_count][obs_bytes]     模拟进程写：调色板索引格式的画面
+//
+// 一步的握手：
+//   1. 训练进程写好 actions / reset / want_obs，把 request 加 1 并 futex 唤醒；
+//   2. 模拟进程看到 request 变化，跑完这一步，观测直接写进上面的数组，然后把 done 设成 request 并唤醒；
+//   3. 训练进程等到 done == 自己的 request，就可以读观测了，直到下一次发请求之前内容不变。
+// 请求发出去之后就收不回来：等待超时了，请求仍然挂着，模拟进程随时可能开始处理它。
+// 这时在 env_shm_wait 返回 1 之前，训练进程不能改 actions / reset / want_obs，也不能读结果。
+// 任何一方把 shutdown 置 1 并唤醒，另一方的等待就会返回 -1。
+
+#define ENV_SHM_MAGIC 0x4D48534E // "NSHM"
+#define ENV_SHM_VERSION 1
+
+typedef struct EnvShmHeader{
+    // 1. 布局（模拟进程创建时写好，之后不变）
+    uint32_t magic;
+    uint32_t version;
+    uint32_t env_count;
+    uint32_t frame_skip;
+    uint32_t obs_bytes;      // 每台一帧，ENV_OBS_BYTES
+    uint32_t ram_bytes;      // 每台 RAM，ENV_RAM_BYTES
+    uint64_t total_size;
+    uint64_t action_offset;
+    uint64_t reset_offset;
+    uint64_t reward_offset;
+    uint64_t ram_offset;
+    uint64_t obs_offset;
+
+    // 2. 握手：request 由训练进程写，done 由模拟进程写；各占一个缓存行
+    _Alignas(64) _Atomic uint32_t request;
+    uint32_t want_obs;       // 这一步要不要画面（0 = 只要 RAM，这一步一帧都不画）
+    _Alignas(64) _Atomic uint32_t done;
+    _Atomic uint32_t shutdown;
+} EnvShmHeader;
+
+// 奖励函数：每台环境走完一步之后调用，结果写进 rewards[index]
+typedef float (*EnvRewardFunc)(void* user, Machine* m, int index);
+
+// 模拟进程一侧
+typedef struct EnvShm EnvShm;
+
+// 创建名为 name（"/xxx" 形式）的共享内存并按 envs 的大小布局；同名的已存在时失败，返回 NULL
+EnvShm* env_shm_create(const char* name, EnvBatch* envs);
+// 置 shutdown、解除映射并删除共享内存
+void env_shm_destroy(EnvShm* shm);
+void env_shm_set_reward(EnvShm* shm, EnvRewardFunc reward, void* user);
+// 等一个请求并处理它：处理了一步返回 1，timeout_ms 毫秒内没有请求返回 0（< 0 表示一直等），对方关闭返回 -1
+int env_shm_serve(EnvShm* shm, int timeout_ms);
+
+// 训练进程一侧
+typedef struct EnvShmClient EnvShmClient;
+
+// 打开已经存在的共享内存，检查 magic 和版本，失败返回 NULL
+EnvShmClient* env_shm_open(const char* name);
+// 置 shutdown 并解除映射
+void env_shm_close(EnvShmClient* client);
+// 共享内存的起点和头部；数组用头部里的偏移去找
+EnvShmHeader* env_shm_header(EnvShmClient* client);
+// 发出一步请求并等它完成：完成返回 1，超时返回 0（请求仍然挂着，见上面的握手），对方关闭返回 -1。
+// 上一个请求还没完成时不发新请求，直接返回 0
+int env_shm_step(EnvShmClient* client, int timeout_ms);
+// 等挂着的请求完成（超时之后用）：完成或者没有挂着的请求返回 1，超时返回 0，对方关闭返回 -1
+int env_shm_wait(EnvShmClient* client, int timeout_ms);
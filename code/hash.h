@@ -0,0 +1,10 @@
+// hash.h
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// XXH64：快速的 64 位非加密哈希，用于画面/状态比较，不用于安全用途
+uint64_t hash64(const void* data, size_t len, uint64_t seed);
+
+// 把一个 64 位值按顺序并入一个累计哈希（用于逐行/逐块增量计算）
+uint64_t hash64_combine(uint64_t acc, uint64_t value);
@@ -16,6 +16,8 @@ int get_mapper_id(const INesHeader* hdr){
 }
 
 int get_mirroring(const INesHeader* hdr) {
+    // bit 3 置位时卡带提供四屏 VRAM，忽略 bit 0
+    if (hdr->flags6 & 0x08) return MIRROR_FOUR_SCREEN;
     return (hdr->flags6 & 0x01);// 0 = horizontal, 1 = vertical
 }
 
@@ -18,12 +18,21 @@ typedef struct __attribute__((packed)) INesHeader{
 } INesHeader;
 
 
+// 名称表镜像方式 (NesRom.mirroring)
+enum Mirroring{
+    MIRROR_HORIZONTAL = 0, // 水平镜像 (flags6 bit 0 = 0)
+    MIRROR_VERTICAL = 1,   // 垂直镜像 (flags6 bit 0 = 1)
+    MIRROR_SINGLE_LOW,     // 单屏，只用 CIRAM 前 1KB（由 Mapper 设置）
+    MIRROR_SINGLE_HIGH,    // 单屏，只用 CIRAM 后 1KB（由 Mapper 设置）
+    MIRROR_FOUR_SCREEN,    // 四屏，卡带自带额外 2KB VRAM (flags6 bit 3)
+};
+
 typedef struct NesRom{
     INesHeader header;
     uint8_t* prg_rom;
     uint8_t* chr_rom;
     int mapper_id;
-    int mirroring;
+    int mirroring; // enum Mirroring
     int has_trainer;
     //... 其他运行时状态
 } NesRom;
@@ -0,0 +1,572 @@
+// lockstep.c
+#include "lockstep.h"
+#include <string.h> // for memset
+
+// 16 条 lane 的一个 8 位寄存器正好是一个 SSE2 寄存器
+#if defined(__SSE2__) && LOCKSTEP_LANES == 16
+#include <immintrin.h>
+#define LANES_SIMD 1
+#endif
+
+// 一条 lane 独自执行多少条指令之后拆出去（默认值）
+#define DEFAULT_SPLIT_AFTER 256
+
+#define LANES_FOR(i) for(int i = 0; i < LOCKSTEP_LANES; i++)
+// 只走 group 里的 lane（逐条 lane 访问各自内存的地方）
+#define GROUP_FOR(i, group) for(uint32_t g_ = (group), i; g_ && ((i = __builtin_ctz(g_)), 1); g_ &= g_ - 1)
+
+// 1. 锁步能执行的指令：只列出官方指令里不碰 I/O 的那些，其余为 0（交给标量核心）
+enum LaneKind{
+    L_NONE = 0,
+    L_LDA, L_LDX, L_LDY, L_STA, L_STX, L_STY,
+    L_ADC, L_SBC, L_AND, L_ORA, L_EOR, L_CMP, L_CPX, L_CPY, L_BIT,
+    L_INC, L_DEC, L_ASL, L_LSR, L_ROL, L_ROR,
+    L_INX, L_INY, L_DEX, L_DEY,
+    L_TAX, L_TAY, L_TXA, L_TYA, L_TSX, L_TXS,
+    L_CLC, L_SEC, L_CLI, L_SEI, L_CLV, L_CLD, L_SED, L_NOP,
+    L_BRANCH, L_JMP, L_JSR, L_RTS,
+    L_PHA, L_PLA, L_PHP, L_PLP,
+};
+
+enum LaneMode{
+    LM_IMP, LM_ACC, LM_IMM, LM_ZP0, LM_ZPX, LM_ZPY,
+    LM_ABS, LM_ABX, LM_ABY, LM_IZX, LM_IZY, LM_REL,
+};
+
+typedef struct LaneOp{
+    uint8_t kind;
+    uint8_t mode;
+    uint8_t cycles;   // 基础周期，与 cpu.c 的 lookup 表相同
+    uint8_t penalty;  // 1 = 跨页时多 1 个周期（读类指令）
+} LaneOp;
+
+// ORA/AND/EOR/ADC/LDA/CMP/SBC 共用的 8 种寻址方式
+#define ALU_GROUP(base, kind) \
+    [(base) + 0x00] = {kind, LM_IZX, 6, 1}, [(base) + 0x04] = {kind, LM_ZP0, 3, 1}, \
+    [(base) + 0x08] = {kind, LM_IMM, 2, 1}, [(base) + 0x0C] = {kind, LM_ABS, 4, 1}, \
+    [(base) + 0x10] = {kind, LM_IZY, 5, 1}, [(base) + 0x14] = {kind, LM_ZPX, 4, 1}, \
+    [(base) + 0x18] = {kind, LM_ABY, 4, 1}, [(base) + 0x1C] = {kind, LM_ABX, 4, 1}
+
+// ASL/ROL/LSR/ROR
+#define SHIFT_GROUP(base, kind) \
+    [(base) + 0x06] = {kind, LM_ZP0, 5, 0}, [(base) + 0x0A] = {kind, LM_ACC, 2, 0}, \
+    [(base) + 0x0E] = {kind, LM_ABS, 6, 0}, [(base) + 0x16] = {kind, LM_ZPX, 6, 0}, \
+    [(base) + 0x1E] = {kind, LM_ABX, 7, 0}
+
+static const LaneOp lane_ops[256] = {
+    ALU_GROUP(0x01, L_ORA), ALU_GROUP(0x21, L_AND), ALU_GROUP(0x41, L_EOR), ALU_GROUP(0x61, L_ADC),
+    ALU_GROUP(0xA1, L_LDA), ALU_GROUP(0xC1, L_CMP), ALU_GROUP(0xE1, L_SBC),
+    SHIFT_GROUP(0x00, L_ASL), SHIFT_GROUP(0x20, L_ROL), SHIFT_GROUP(0x40, L_LSR), SHIFT_GROUP(0x60, L_ROR),
+
+    [0x81] = {L_STA, LM_IZX, 6, 0}, [0x85] = {L_STA, LM_ZP0, 3, 0}, [0x8D] = {L_STA, LM_ABS, 4, 0},
+    [0x91] = {L_STA, LM_IZY, 6, 0}, [0x95] = {L_STA, LM_ZPX, 4, 0}, [0x99] = {L_STA, LM_ABY, 5, 0},
+    [0x9D] = {L_STA, LM_ABX, 5, 0},
+    [0x86] = {L_STX, LM_ZP0, 3, 0}, [0x8E] = {L_STX, LM_ABS, 4, 0}, [0x96] = {L_STX, LM_ZPY, 4, 0},
+    [0x84] = {L_STY, LM_ZP0, 3, 0}, [0x8C] = {L_STY, LM_ABS, 4, 0}, [0x94] = {L_STY, LM_ZPX, 4, 0},
+
+    [0xA2] = {L_LDX, LM_IMM, 2, 1}, [0xA6] = {L_LDX, LM_ZP0, 3, 1}, [0xAE] = {L_LDX, LM_ABS, 4, 1},
+    [0xB6] = {L_LDX, LM_ZPY, 4, 1}, [0xBE] = {L_LDX, LM_ABY, 4, 1},
+    [0xA0] = {L_LDY, LM_IMM, 2, 1}, [0xA4] = {L_LDY, LM_ZP0, 3, 1}, [0xAC] = {L_LDY, LM_ABS, 4, 1},
+    [0xB4] = {L_LDY, LM_ZPX, 4, 1}, [0xBC] = {L_LDY, LM_ABX, 4, 1},
+    [0xE0] = {L_CPX, LM_IMM, 2, 1}, [0xE4] = {L_CPX, LM_ZP0, 3, 1}, [0xEC] = {L_CPX, LM_ABS, 4, 1},
+    [0xC0] = {L_CPY, LM_IMM, 2, 1}, [0xC4] = {L_CPY, LM_ZP0, 3, 1}, [0xCC] = {L_CPY, LM_ABS, 4, 1},
+    [0x24] = {L_BIT, LM_ZP0, 3, 0}, [0x2C] = {L_BIT, LM_ABS, 4, 0},
+
+    [0xE6] = {L_INC, LM_ZP0, 5, 0}, [0xEE] = {L_INC, LM_ABS, 6, 0}, [0xF6] = {L_INC, LM_ZPX, 6, 0},
+    [0xFE] = {L_INC, LM_ABX, 7, 0},
+    [0xC6] = {L_DEC, LM_ZP0, 5, 0}, [0xCE] = {L_DEC, LM_ABS, 6, 0}, [0xD6] = {L_DEC, LM_ZPX, 6, 0},
+    [0xDE] = {L_DEC, LM_ABX, 7, 0},
+
+    [0xE8] = {L_INX, LM_IMP, 2, 0}, [0xC8] = {L_INY, LM_IMP, 2, 0},
+    [0xCA] = {L_DEX, LM_IMP, 2, 0}, [0x88] = {L_DEY, LM_IMP, 2, 0},
+    [0xAA] = {L_TAX, LM_IMP, 2, 0}, [0xA8] = {L_TAY, LM_IMP, 2, 0},
+    [0x8A] = {L_TXA, LM_IMP, 2, 0}, [0x98] = {L_TYA, LM_IMP, 2, 0},
+    [0xBA] = {L_TSX, LM_IMP, 2, 0}, [0x9A] = {L_TXS, LM_IMP, 2, 0},
+    [0x18] = {L_CLC, LM_IMP, 2, 0}, [0x38] = {L_SEC, LM_IMP, 2, 0},
+    [0x58] = {L_CLI, LM_IMP, 2, 0}, [0x78] = {L_SEI, LM_IMP, 2, 0},
+    [0xB8] = {L_CLV, LM_IMP, 2, 0}, [0xD8] = {L_CLD, LM_IMP, 2, 0},
+    [0xF8] = {L_SED, LM_IMP, 2, 0}, [0xEA] = {L_NOP, LM_IMP, 2, 0},
+
+    [0x10] = {L_BRANCH, LM_REL, 2, 0}, [0x30] = {L_BRANCH, LM_REL, 2, 0},
+    [0x50] = {L_BRANCH, LM_REL, 2, 0}, [0x70] = {L_BRANCH, LM_REL, 2, 0},
+    [0x90] = {L_BRANCH, LM_REL, 2, 0}, [0xB0] = {L_BRANCH, LM_REL, 2, 0},
+    [0xD0] = {L_BRANCH, LM_REL, 2, 0}, [0xF0] = {L_BRANCH, LM_REL, 2, 0},
+    [0x4C] = {L_JMP, LM_ABS, 3, 0}, [0x20] = {L_JSR, LM_ABS, 6, 0}, [0x60] = {L_RTS, LM_IMP, 6, 0},
+
+    [0x48] = {L_PHA, LM_IMP, 3, 0}, [0x68] = {L_PLA, LM_IMP, 4, 0},
+    [0x08] = {L_PHP, LM_IMP, 3, 0}, [0x28] = {L_PLP, LM_IMP, 4, 0},
+};
+
+// 指令长度（操作码 + 操作数）
+static const uint8_t mode_length[] = {
+    [LM_IMP] = 1, [LM_ACC] = 1, [LM_IMM] = 2, [LM_ZP0] = 2, [LM_ZPX] = 2, [LM_ZPY] = 2,
+    [LM_ABS] = 3, [LM_ABX] = 3, [LM_ABY] = 3, [LM_IZX] = 2, [LM_IZY] = 2, [LM_REL] = 2,
+};
+
+// 2. 每条 lane 上的小工具
+
+// Z/N 两个标志
+static inline uint8_t flags_zn(uint8_t v){
+    return (uint8_t)((v == 0 ? Z : 0) | (v & N));
+}
+
+// on = 0xFF 取 v，on = 0 保留 old；全部 lane 一起做，没有分支
+static inline uint8_t blend(uint8_t on, uint8_t v, uint8_t old){
+    return (uint8_t)((v & on) | (old & ~on));
+}
+
+// 整组 lane 的一个寄存器：有 SSE2 时是一个 __m128i，否则是普通数组上的循环（编译器照样能向量化）
+#if defined(LANES_SIMD)
+typedef __m128i Lanes;
+static inline Lanes lanes_load(const uint8_t* p){ return _mm_loadu_si128((const __m128i*)p); }
+static inline void lanes_store(uint8_t* p, Lanes v){ _mm_storeu_si128((__m128i*)p, v); }
+static inline Lanes lanes_set(uint8_t v){ return _mm_set1_epi8((char)v); }
+static inline Lanes lanes_and(Lanes a, Lanes b){ return _mm_and_si128(a, b); }
+static inline Lanes lanes_or(Lanes a, Lanes b){ return _mm_or_si128(a, b); }
+static inline Lanes lanes_xor(Lanes a, Lanes b){ return _mm_xor_si128(a, b); }
+static inline Lanes lanes_andnot(Lanes a, Lanes b){ return _mm_andnot_si128(a, b); }
+static inline Lanes lanes_add(Lanes a, Lanes b){ return _mm_add_epi8(a, b); }
+static inline Lanes lanes_sub(Lanes a, Lanes b){ return _mm_sub_epi8(a, b); }
+static inline Lanes lanes_eq(Lanes a, Lanes b){ return _mm_cmpeq_epi8(a, b); }
+static inline Lanes lanes_ge(Lanes a, Lanes b){ return _mm_cmpeq_epi8(_mm_max_epu8(a, b), a); }
+static inline Lanes lanes_sign(Lanes a){ return _mm_cmplt_epi8(a, _mm_setzero_si128()); }
+#else
+typedef struct Lanes{ uint8_t v[LOCKSTEP_LANES]; } Lanes;
+#define LANES_MAP(expr) Lanes r; LANES_FOR(i) r.v[i] = (uint8_t)(expr); return r
+static inline Lanes lanes_load(const uint8_t* p){ Lanes r; memcpy(r.v, p, sizeof(r.v)); return r; }
+static inline void lanes_store(uint8_t* p, Lanes v){ memcpy(p, v.v, sizeof(v.v)); }
+static inline Lanes lanes_set(uint8_t v){ LANES_MAP(v); }
+static inline Lanes lanes_and(Lanes a, Lanes b){ LANES_MAP(a.v[i] & b.v[i]); }
+static inline Lanes lanes_or(Lanes a, Lanes b){ LANES_MAP(a.v[i] | b.v[i]); }
+static inline Lanes lanes_xor(Lanes a, Lanes b){ LANES_MAP(a.v[i] ^ b.v[i]); }
+static inline Lanes lanes_andnot(Lanes a, Lanes b){ LANES_MAP(~a.v[i] & b.v[i]); }
+static inline Lanes lanes_add(Lanes a, Lanes b){ LANES_MAP(a.v[i] + b.v[i]); }
+static inline Lanes lanes_sub(Lanes a, Lanes b){ LANES_MAP(a.v[i] - b.v[i]); }
+static inline Lanes lanes_eq(Lanes a, Lanes b){ LANES_MAP(a.v[i] == b.v[i] ? 0xFF : 0); }
+static inline Lanes lanes_ge(Lanes a, Lanes b){ LANES_MAP(a.v[i] >= b.v[i] ? 0xFF : 0); }
+static inline Lanes lanes_sign(Lanes a){ LANES_MAP((a.v[i] & 0x80) ? 0xFF : 0); }
+#undef LANES_MAP
+#endif
+
+// 上面几个的组合：lanes_andnot(a, b) = ~a & b；eq / ge / sign 的结果是每条 lane 0xFF 或 0
+static inline Lanes lanes_blend(Lanes on, Lanes v, Lanes old){
+    return lanes_or(lanes_and(on, v), lanes_andnot(on, old));
+}
+
+static inline Lanes lanes_zn(Lanes v){
+    return lanes_or(lanes_and(lanes_eq(v, lanes_set(0)), lanes_set(Z)), lanes_and(v, lanes_set(N)));
+}
+
+// 把 p 里 mask 的那几位换成 f
+static inline Lanes lanes_flags(Lanes p, uint8_t mask, Lanes f){
+    return lanes_or(lanes_andnot(lanes_set(mask), p), f);
+}
+
+static void fill(Lockstep* ls, int i){
+    const CPU* cpu = &ls->machines[i]->cpu;
+    ls->a[i] = cpu->a;
+    ls->x[i] = cpu->x;
+    ls->y[i] = cpu->y;
+    ls->sp[i] = cpu->stkp;
+    ls->p[i] = cpu->status;
+    ls->pc[i] = cpu->pc;
+}
+
+static void spill(Lockstep* ls, int i){
+    CPU* cpu = &ls->machines[i]->cpu;
+    cpu->a = ls->a[i];
+    cpu->x = ls->x[i];
+    cpu->y = ls->y[i];
+    cpu->stkp = ls->sp[i];
+    cpu->status = ls->p[i];
+    cpu->pc = ls->pc[i];
+}
+
+static inline uint8_t ram_read(Lockstep* ls, int i, uint16_t addr){
+    return ls->machines[i]->bus.ram[addr & 0x07FF];
+}
+
+static inline void ram_write(Lockstep* ls, int i, uint16_t addr, uint8_t data){
+    Bus* bus = &ls->machines[i]->bus;
+    bus->ram[addr & 0x07FF] = data;
+    bus->ram_dirty |= 1 << ((addr & 0x07FF) >> 8);
+}
+
+// 锁步只读 RAM 和 PRG-ROM；ROM 的读取没有副作用，所有 lane 读到的都一样
+static inline uint8_t mem_read(Lockstep* ls, int i, uint16_t addr){
+    if(addr < 0x2000) return ram_read(ls, i, addr);
+    return bus_read(&ls->machines[i]->bus, addr);
+}
+
+// 3. 锁步执行一条指令。group 里的 lane 的 PC 都是 pc；
+// 有任何一条 lane 要碰 I/O 时什么都不改，返回 0，由调用方交给标量核心
+static int lockstep_instruction(Lockstep* ls, uint32_t group, uint16_t pc){
+    if(pc < 0x8000 || pc > 0xFFFD) return 0;
+
+    // 所有 lane 共用一次取指和译码
+    Bus* lead = &ls->machines[__builtin_ctz(group)]->bus;
+    const LaneOp* op = &lane_ops[bus_read(lead, pc)];
+    if(op->kind == L_NONE) return 0;
+    uint8_t b1 = bus_read(lead, pc + 1);
+    uint8_t b2 = bus_read(lead, pc + 2);
+    uint16_t abs = (uint16_t)(b1 | (b2 << 8));
+
+    uint8_t on[LOCKSTEP_LANES];
+    LANES_FOR(i){
+        on[i] = (group >> i & 1) ? 0xFF : 0x00;
+    }
+
+    // 有效地址和跨页：先按寻址方式分开，循环里没有分支
+    uint16_t ea[LOCKSTEP_LANES];
+    uint8_t cross[LOCKSTEP_LANES] = {0};
+    uint8_t* a = ls->a;
+    uint8_t* x = ls->x;
+    uint8_t* y = ls->y;
+    uint8_t* p = ls->p;
+    switch(op->mode){
+    case LM_ZP0: LANES_FOR(i) ea[i] = b1; break;
+    case LM_ZPX: LANES_FOR(i) ea[i] = (uint8_t)(b1 + x[i]); break;
+    case LM_ZPY: LANES_FOR(i) ea[i] = (uint8_t)(b1 + y[i]); break;
+    case LM_ABX:
+    case LM_ABY:
+        LANES_FOR(i){
+            ea[i] = (uint16_t)(abs + (op->mode == LM_ABX ? x[i] : y[i]));
+            cross[i] = (ea[i] >> 8) != (abs >> 8);
+        }
+        break;
+    case LM_IZX:
+        // 零页里的指针每台机器不一样，只能逐条 lane 去读
+        GROUP_FOR(i, group){
+            uint8_t t = (uint8_t)(b1 + x[i]);
+            ea[i] = (uint16_t)(ram_read(ls, i, t) | (ram_read(ls, i, (uint8_t)(t + 1)) << 8));
+        }
+        break;
+    case LM_IZY:
+        GROUP_FOR(i, group){
+            uint16_t base = (uint16_t)(ram_read(ls, i, b1) | (ram_read(ls, i, (uint8_t)(b1 + 1)) << 8));
+            ea[i] = (uint16_t)(base + y[i]);
+            cross[i] = (ea[i] >> 8) != (base >> 8);
+        }
+        break;
+    default: LANES_FOR(i) ea[i] = abs; break;
+    }
+
+    // 访存的指令：地址全部落在 RAM（写）或 RAM / PRG-ROM（读）才能锁步
+    uint8_t kind = op->kind;
+    int has_memory = op->mode != LM_IMP && op->mode != LM_ACC && op->mode != LM_IMM && op->mode != LM_REL &&
+                     kind != L_JMP && kind != L_JSR;
+    int stores = kind == L_STA || kind == L_STX || kind == L_STY;
+    if(has_memory){
+        int writes = stores || kind == L_INC || kind == L_DEC ||
+                     kind == L_ASL || kind == L_LSR || kind == L_ROL || kind == L_ROR;
+        GROUP_FOR(i, group){
+            if(ea[i] >= 0x2000 && (writes || ea[i] < 0x8000)) return 0;
+        }
+    }
+
+    // 操作数（立即数 / 累加器 / 内存）
+    uint8_t m[LOCKSTEP_LANES] = {0};
+    if(op->mode == LM_IMM){
+        LANES_FOR(i) m[i] = b1;
+    } else if(op->mode == LM_ACC){
+        LANES_FOR(i) m[i] = a[i];
+    } else if(has_memory && !stores){
+        GROUP_FOR(i, group) m[i] = mem_read(ls, i, ea[i]);
+    }
+
+    uint8_t cycles[LOCKSTEP_LANES];
+    LANES_FOR(i){
+        cycles[i] = (uint8_t)(op->cycles + (cross[i] & op->penalty));
+    }
+    uint16_t next = (uint16_t)(pc + mode_length[op->mode]);
+
+    // 寄存器运算：全部 16 条 lane 一起算，用掩码只留下组里的
+    Lanes on_v = lanes_load(on);
+    Lanes m_v = lanes_load(m);
+    Lanes p_v = lanes_load(p);
+    p_v = lanes_blend(on_v, lanes_or(p_v, lanes_set(U)), p_v);
+    lanes_store(p, p_v);
+    uint8_t r[LOCKSTEP_LANES];
+    switch(kind){
+    case L_LDA:
+    case L_LDX:
+    case L_LDY: {
+        uint8_t* dst = kind == L_LDA ? a : kind == L_LDX ? x : y;
+        lanes_store(dst, lanes_blend(on_v, m_v, lanes_load(dst)));
+        lanes_store(p, lanes_blend(on_v, lanes_flags(p_v, Z | N, lanes_zn(m_v)), p_v));
+        break;
+    }
+    case L_AND:
+    case L_ORA:
+    case L_EOR: {
+        Lanes a_v = lanes_load(a);
+        Lanes v = kind == L_AND ? lanes_and(a_v, m_v) : kind == L_ORA ? lanes_or(a_v, m_v) : lanes_xor(a_v, m_v);
+        lanes_store(a, lanes_blend(on_v, v, a_v));
+        lanes_store(p, lanes_blend(on_v, lanes_flags(p_v, Z | N, lanes_zn(v)), p_v));
+        break;
+    }
+    case L_ADC:
+    case L_SBC: {
+        // 8 位加法，进位和溢出从最高位推出来：
+        // 进位 = 两个加数最高位都是 1，或者只有一个是 1 而和的最高位是 0
+        Lanes a_v = lanes_load(a);
+        Lanes v = kind == L_SBC ? lanes_xor(m_v, lanes_set(0xFF)) : m_v;
+        Lanes t = lanes_add(lanes_add(a_v, v), lanes_and(p_v, lanes_set(C)));
+        Lanes carry = lanes_sign(lanes_or(lanes_and(a_v, v), lanes_andnot(t, lanes_or(a_v, v))));
+        Lanes over = lanes_sign(lanes_andnot(lanes_xor(a_v, v), lanes_xor(a_v, t)));
+        Lanes f = lanes_or(lanes_or(lanes_and(carry, lanes_set(C)), lanes_and(over, lanes_set(V))), lanes_zn(t));
+        lanes_store(a, lanes_blend(on_v, t, a_v));
+        lanes_store(p, lanes_blend(on_v, lanes_flags(p_v, C | Z | N | V, f), p_v));
+        break;
+    }
+    case L_CMP:
+    case L_CPX:
+    case L_CPY: {
+        Lanes reg = lanes_load(kind == L_CMP ? a : kind == L_CPX ? x : y);
+        Lanes f = lanes_or(lanes_or(lanes_and(lanes_ge(reg, m_v), lanes_set(C)), lanes_and(lanes_eq(reg, m_v), lanes_set(Z))),
+                           lanes_and(lanes_sub(reg, m_v), lanes_set(N)));
+        lanes_store(p, lanes_blend(on_v, lanes_flags(p_v, C | Z | N, f), p_v));
+        break;
+    }
+    case L_BIT: {
+        Lanes zero = lanes_eq(lanes_and(lanes_load(a), m_v), lanes_set(0));
+        Lanes f = lanes_or(lanes_and(zero, lanes_set(Z)), lanes_and(m_v, lanes_set(N | V)));
+        lanes_store(p, lanes_blend(on_v, lanes_flags(p_v, Z | N | V, f), p_v));
+        break;
+    }
+    case L_INC:
+    case L_DEC:
+    case L_ASL:
+    case L_LSR:
+    case L_ROL:
+    case L_ROR:
+        LANES_FOR(i){
+            uint8_t c = p[i] & C;
+            uint8_t out = c;
+            switch(kind){
+            case L_INC: r[i] = (uint8_t)(m[i] + 1); break;
+            case L_DEC: r[i] = (uint8_t)(m[i] - 1); break;
+            case L_ASL: r[i] = (uint8_t)(m[i] << 1); out = m[i] >> 7; break;
+            case L_LSR: r[i] = m[i] >> 1; out = m[i] & 1; break;
+            case L_ROL: r[i] = (uint8_t)((m[i] << 1) | c); out = m[i] >> 7; break;
+            default:    r[i] = (uint8_t)((m[i] >> 1) | (c << 7)); out = m[i] & 1; break;
+            }
+            p[i] = blend(on[i], (p[i] & ~(C | Z | N)) | out | flags_zn(r[i]), p[i]);
+        }
+        if(op->mode == LM_ACC){
+            LANES_FOR(i) a[i] = blend(on[i], r[i], a[i]);
+        } else {
+            GROUP_FOR(i, group) ram_write(ls, i, ea[i], r[i]);
+        }
+        break;
+    case L_STA:
+        GROUP_FOR(i, group) ram_write(ls, i, ea[i], a[i]);
+        break;
+    case L_STX:
+        GROUP_FOR(i, group) ram_write(ls, i, ea[i], x[i]);
+        break;
+    case L_STY:
+        GROUP_FOR(i, group) ram_write(ls, i, ea[i], y[i]);
+        break;
+    case L_INX:
+    case L_INY:
+    case L_DEX:
+    case L_DEY: {
+        uint8_t* reg = (kind == L_INX || kind == L_DEX) ? x : y;
+        Lanes old = lanes_load(reg);
+        Lanes v = lanes_add(old, lanes_set((kind == L_INX || kind == L_INY) ? 1 : 0xFF));
+        lanes_store(reg, lanes_blend(on_v, v, old));
+        lanes_store(p, lanes_blend(on_v, lanes_flags(p_v, Z | N, lanes_zn(v)), p_v));
+        break;
+    }
+    case L_TAX:
+    case L_TAY:
+    case L_TXA:
+    case L_TYA:
+    case L_TSX: {
+        Lanes v = lanes_load(kind == L_TXA ? x : kind == L_TYA ? y : kind == L_TSX ? ls->sp : a);
+        uint8_t* dst = (kind == L_TAX || kind == L_TSX) ? x : kind == L_TAY ? y : a;
+        lanes_store(dst, lanes_blend(on_v, v, lanes_load(dst)));
+        lanes_store(p, lanes_blend(on_v, lanes_flags(p_v, Z | N, lanes_zn(v)), p_v));
+        break;
+    }
+    case L_TXS:
+        lanes_store(ls->sp, lanes_blend(on_v, lanes_load(x), lanes_load(ls->sp)));
+        break;
+    case L_CLC: case L_SEC: case L_CLI: case L_SEI: case L_CLV: case L_CLD: case L_SED: {
+        static const uint8_t flag[] = {[L_CLC] = C, [L_SEC] = C, [L_CLI] = I, [L_SEI] = I,
+                                       [L_CLV] = V, [L_CLD] = D, [L_SED] = D};
+        uint8_t f = flag[kind];
+        uint8_t set = (kind == L_SEC || kind == L_SEI || kind == L_SED) ? f : 0;
+        lanes_store(p, lanes_blend(on_v, lanes_flags(p_v, f, lanes_set(set)), p_v));
+        break;
+    }
+    case L_NOP:
+        break;
+    case L_BRANCH: {
+        // 操作码高 2 位选标志 (N V C Z)，第 5 位是跳转所需的值
+        static const uint8_t flag[4] = {N, V, C, Z};
+        uint8_t opcode = bus_read(lead, pc);
+        uint8_t f = flag[opcode >> 6];
+        uint8_t want = (opcode >> 5) & 1;
+        uint16_t target = (uint16_t)(next + (int8_t)b1);
+        uint8_t far = (target & 0xFF00) != (next & 0xFF00);
+        GROUP_FOR(i, group){
+            if(((p[i] & f) != 0) == want){
+                cycles[i] += 1 + far;
+                ls->pc[i] = target;
+            } else {
+                ls->pc[i] = next;
+            }
+        }
+        break;
+    }
+    case L_JMP:
+        next = abs;
+        break;
+    case L_JSR:
+        GROUP_FOR(i, group){
+            uint16_t ret = (uint16_t)(pc + 2);
+            ram_write(ls, i, 0x0100 + ls->sp[i], ret >> 8);
+            ram_write(ls, i, 0x0100 + (uint8_t)(ls->sp[i] - 1), ret & 0xFF);
+            ls->sp[i] -= 2;
+        }
+        next = abs;
+        break;
+    case L_RTS:
+        GROUP_FOR(i, group){
+            uint8_t lo = ram_read(ls, i, 0x0100 + (uint8_t)(ls->sp[i] + 1));
+            uint8_t hi = ram_read(ls, i, 0x0100 + (uint8_t)(ls->sp[i] + 2));
+            ls->sp[i] += 2;
+            ls->pc[i] = (uint16_t)(((hi << 8) | lo) + 1);
+        }
+        break;
+    case L_PHA:
+    case L_PHP:
+        GROUP_FOR(i, group){
+            ram_write(ls, i, 0x0100 + ls->sp[i], kind == L_PHA ? a[i] : (p[i] | B | U));
+            ls->sp[i]--;
+        }
+        if(kind == L_PHP){
+            LANES_FOR(i) p[i] = blend(on[i], (p[i] & ~B) | U, p[i]);
+        }
+        break;
+    case L_PLA:
+    case L_PLP:
+        GROUP_FOR(i, group){
+            ls->sp[i]++;
+            uint8_t v = ram_read(ls, i, 0x0100 + ls->sp[i]);
+            if(kind == L_PLA){
+                a[i] = v;
+                p[i] = (p[i] & ~(Z | N)) | flags_zn(v);
+            } else {
+                p[i] = (v & ~B) | U;
+            }
+        }
+        break;
+    }
+
+    // PC 和主时钟（分支和 RTS 已经自己设好了 PC）
+    if(kind != L_BRANCH && kind != L_RTS){
+        LANES_FOR(i) ls->pc[i] = on[i] ? next : ls->pc[i];
+    }
+    GROUP_FOR(i, group){
+        ls->machines[i]->bus.cycles += cycles[i];
+    }
+    return 1;
+}
+
+// 4. 调度
+
+int lockstep_init(Lockstep* ls, Machine** machines, int count){
+    if(count < 1 || count > LOCKSTEP_LANES) return 0;
+    memset(ls, 0, sizeof(Lockstep));
+    for(int i = 0; i < count; i++){
+        if(machines[i]->bus.cartridge != machines[0]->bus.cartridge) return 0;
+        ls->machines[i] = machines[i];
+    }
+    ls->count = count;
+    ls->split_after = DEFAULT_SPLIT_AFTER;
+    return 1;
+}
+
+// 锁步执行过的 lane：大多数指令之后什么都不用做，
+// 到了截止时间或者有 IRQ 等着的时候才交给 machine_finish_instruction
+// (指令本身不碰 I/O，不会挂起 NMI，也不会画完一帧)
+static int finish_lane(Lockstep* ls, int i){
+    Machine* m = ls->machines[i];
+    Bus* bus = &m->bus;
+    if(bus->cycles < bus->ppu_deadline && bus->cycles < bus->apu_deadline &&
+       !(apu_irq(&m->apu) && !(ls->p[i] & I))){
+        return 0;
+    }
+    spill(ls, i);
+    int done = machine_finish_instruction(m);
+    fill(ls, i);
+    return done;
+}
+
+static int scalar_lane(Lockstep* ls, int i){
+    spill(ls, i);
+    int done = machine_step(ls->machines[i]);
+    fill(ls, i);
+    ls->scalar_instructions++;
+    return done;
+}
+
+void lockstep_run_frame(Lockstep* ls){
+    int n = ls->count;
+    uint32_t running = (1u << n) - 1;
+    for(int i = 0; i < n; i++){
+        fill(ls, i);
+        ls->alone[i] = 0;
+    }
+
+    while(running){
+        // 挑出时间上落在最后的那条 lane，和它 PC 相同的 lane 组成这一步的执行组。
+        // 先追上落后的，lane 之间在时间上大致对齐，分叉之后更容易重新走到同一个 PC
+        int lead = -1;
+        uint64_t oldest = UINT64_MAX;
+        for(int i = 0; i < n; i++){
+            if((running >> i & 1) && ls->machines[i]->bus.cycles < oldest){
+                oldest = ls->machines[i]->bus.cycles;
+                lead = i;
+            }
+        }
+        uint16_t pc = ls->pc[lead];
+        uint32_t group = 0;
+        for(int i = 0; i < n; i++){
+            if((running >> i & 1) && ls->pc[i] == pc) group |= 1u << i;
+        }
+
+        if(lockstep_instruction(ls, group, pc)){
+            ls->lockstep_groups++;
+            GROUP_FOR(i, group){
+                ls->lockstep_instructions++;
+                if(finish_lane(ls, i)) running &= ~(1u << i);
+            }
+        } else {
+            GROUP_FOR(i, group){
+                if(scalar_lane(ls, i)) running &= ~(1u << i);
+            }
+        }
+
+        // 分叉太久的 lane 拆出去，用标量核心把这一帧跑完
+        if(group & (group - 1)){
+            GROUP_FOR(i, group) ls->alone[i] = 0;
+        } else if((running & group) && ++ls->alone[lead] > (uint32_t)ls->split_after){
+            Machine* m = ls->machines[lead];
+            spill(ls, lead);
+            do{
+                ls->scalar_instructions++;
+            }while(!machine_step(m));
+            fill(ls, lead);
+            running &= ~group;
+        }
+    }
+
+    for(int i = 0; i < n; i++){
+        spill(ls, i);
+        machine_end_frame(ls->machines[i]);
+    }
+}
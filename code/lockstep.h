@@ -0,0 +1,47 @@
+// lockstep.h
+#pragma once
+#include <stdint.h>
+#include "machine.h"
+
+// 实验性的锁步核心：同一个 ROM 的多台机器（只是输入不同）绝大多数时间都在执行同一个 PC，
+// 这里把它们的 A/X/Y/P/SP/PC 按“结构体数组”排成一条条 lane，
+// 同一个 PC 上的 lane 一起取指、一起译码，然后对整组 lane 做同一个运算（带掩码）：
+// 有 SSE2 时 16 条 lane 的一个寄存器就是一个 SSE2 寄存器，否则退回普通循环。
+//
+// 只有访问内部 RAM / PRG-ROM 的官方指令走锁步；碰到 I/O（$2000-$401F、卡带 $4020-$7FFF）、
+// 中断和非官方指令时，这一组 lane 逐台交给标量核心 (cpu_step) 执行，结果逐周期一致。
+// 一条 lane 连续 split_after 条指令都没有同伴时，就把它拆出去，这一帧剩下的部分用标量核心跑完；
+// 下一帧开始时重新加入。
+//
+// 机器的状态只在 lockstep_run_frame 期间由这里接管，调用前后都可以照常读写 Machine。
+// 不处理录像、预跑和输出队列
+
+#define LOCKSTEP_LANES 16
+
+typedef struct Lockstep{
+    int count;
+    Machine* machines[LOCKSTEP_LANES];
+
+    // 1. 每条 lane 的寄存器（运行期间以这里为准）
+    uint8_t a[LOCKSTEP_LANES];
+    uint8_t x[LOCKSTEP_LANES];
+    uint8_t y[LOCKSTEP_LANES];
+    uint8_t sp[LOCKSTEP_LANES];
+    uint8_t p[LOCKSTEP_LANES];
+    uint16_t pc[LOCKSTEP_LANES];
+
+    // 2. 分流：连续多少条指令独自执行之后拆出去
+    int split_after;
+    uint32_t alone[LOCKSTEP_LANES];
+
+    // 3. 统计（按 lane 计的指令条数）
+    uint64_t lockstep_instructions;  // 锁步执行的
+    uint64_t lockstep_groups;        // 锁步执行了多少组（平均组宽 = 上一项 / 这一项）
+    uint64_t scalar_instructions;    // 交给标量核心的（I/O、非官方指令、拆出去的 lane）
+} Lockstep;
+
+// count 台机器（1 .. LOCKSTEP_LANES），必须插着同一个卡带；返回 0 表示参数不合法
+int lockstep_init(Lockstep* ls, Machine** machines, int count);
+
+// 所有机器各跑一帧，效果与逐台调用 machine_run_frame 相同
+void lockstep_run_frame(Lockstep* ls);
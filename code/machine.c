@@ -0,0 +1,317 @@
+// machine.c
+#include "machine.h"
+#include "ppu_thread.h"
+#include "av_output.h"
+#include "movie.h"
+#include "savestate.h"
+#include "statehash.h"
+#include "battery.h"
+#include <stdlib.h>
+#include <string.h> // for memset, memcpy
+
+void machine_init(Machine* m, NesRom* rom){
+    memset(m, 0, sizeof(Machine));
+
+    bus_init(&m->bus, rom);
+    ppu_init(&m->ppu, rom);
+    bus_connect_ppu(&m->bus, &m->ppu);
+    apu_init(&m->apu, MACHINE_SAMPLE_RATE);
+    bus_connect_apu(&m->bus, &m->apu);
+    cpu_connect_bus(&m->cpu, &m->bus);
+
+    machine_reset(m);
+}
+
+void machine_reset(Machine* m){
+    cpu_reset(&m->cpu);
+}
+
+int machine_fork(Machine* parent, Machine* child){
+    if(parent->ppu.worker) return 0;
+
+    child->cpu = parent->cpu;
+    child->bus = parent->bus;
+    ppu_fork(&parent->ppu, &child->ppu);
+    apu_fork(&parent->apu, &child->apu);
+
+    // 重新接线：指针都要指向 child 自己的部件
+    child->cpu.bus = &child->bus;
+    child->bus.prg_ram = child->bus.prg_ram_store;
+    if(parent->bus.prg_ram != parent->bus.prg_ram_store){
+        memcpy(child->bus.prg_ram_store, parent->bus.prg_ram, BUS_PRG_RAM_SIZE);
+    }
+    child->bus.ppu = &child->ppu;
+    child->bus.apu = &child->apu;
+    child->apu.bus = &child->bus;
+
+    child->output = NULL;
+    child->hash_log = NULL;
+    child->battery = NULL;
+    child->movie = parent->movie;
+    child->movie_frame = parent->movie_frame;
+    child->lag = parent->lag;
+    child->lag_frames = parent->lag_frames;
+    child->state_base = parent->state_base;
+    child->run_ahead = 0;
+    child->run_ahead_state = NULL;
+    child->run_ahead_size = 0;
+    return 1;
+}
+
+void machine_release(Machine* m){
+    if(m->ppu.worker){
+        machine_stop_render_thread(m);
+    }
+    ppu_unshare(&m->ppu, 1);
+}
+
+// 把这一帧直接写进输出队列的槽位：画面拷贝一次，音频从 APU 直接读进槽位
+static void publish_output(Machine* m){
+    AvOutput* out = m->output;
+
+    AvVideoBlock* video = av_output_video_slot(out);
+    if(video){
+        video->frame_number = m->ppu.frame_count;
+        memcpy(&video->frame, machine_frame(m), sizeof(PpuFrame));
+        av_output_commit_video(out);
+    }
+
+    // 音频队列满时采样留在 APU 里，下一帧一起发出（积压太多时 APU 自己会丢）
+    AvAudioBlock* audio = av_output_audio_slot(out);
+    if(audio){
+        audio->frame_number = m->ppu.frame_count;
+        audio->sample_rate = (int)m->apu.sample_rate;
+        audio->count = machine_read_audio(m, audio->samples, AV_AUDIO_BLOCK_MAX);
+        av_output_commit_audio(out);
+    }
+}
+
+// 录像回放：只是按下标取字节，没有解析
+static void apply_movie_frame(Machine* m){
+    const Movie* movie = m->movie;
+    if(m->movie_frame >= movie->frame_count){
+        m->movie = NULL;
+        m->bus.controller[0] = m->bus.controller[1] = 0;
+        return;
+    }
+    uint32_t f = m->movie_frame++;
+    if(movie_commands(movie, f) & MOVIE_CMD_RESET){
+        machine_reset(m);
+    }
+    m->bus.controller[0] = movie_buttons(movie, f, 0);
+    m->bus.controller[1] = movie_buttons(movie, f, 1);
+}
+
+void machine_set_input(Machine* m, int port, uint8_t buttons){
+    m->bus.controller[port & 1] = buttons;
+}
+
+void machine_play_movie(Machine* m, const Movie* movie){
+    m->movie = movie;
+    m->movie_frame = 0;
+}
+
+int machine_movie_playing(const Machine* m){
+    return m->movie != NULL && m->movie_frame < m->movie->frame_count;
+}
+
+// 一条指令执行完之后：到截止时间就追赶 PPU / APU，然后响应中断。返回 1 表示这一帧画完了
+static inline int finish_instruction(Machine* m){
+    Bus* bus = &m->bus;
+    PPU* ppu = &m->ppu;
+
+    // PPU 平时不动，只有到达截止时间（VBlank）时才在这里追赶一次
+    if(bus->cycles >= bus->ppu_deadline){
+        bus_sync_ppu(bus);
+    }
+    if(bus->cycles >= bus->apu_deadline){
+        bus_sync_apu(bus);
+    }
+    // NMI 可能来自截止时间的同步，也可能来自指令里对 $2000 的写入
+    if(ppu->nmi_pending){
+        ppu->nmi_pending = 0;
+        cpu_nmi(&m->cpu);
+    }
+    // APU 的 IRQ 是电平触发：标志一直挂着，直到程序读 $4015 / 写 $4017 / $4010 清掉
+    else if(apu_irq(&m->apu)){
+        cpu_irq(&m->cpu);
+    }
+    if(ppu->frame_complete){
+        ppu->frame_complete = 0;
+        return 1;
+    }
+    return 0;
+}
+
+int machine_step(Machine* m){
+    cpu_step(&m->cpu);
+    return finish_instruction(m);
+}
+
+int machine_finish_instruction(Machine* m){
+    return finish_instruction(m);
+}
+
+void machine_end_frame(Machine* m){
+    bus_sync_apu(&m->bus);
+    apu_end_frame(&m->apu, m->bus.cycles);
+
+    m->lag = !m->bus.input_polled;
+    m->lag_frames += m->lag;
+    m->bus.input_polled = 0;
+}
+
+// 跑完一帧：CPU 一直走到 PPU 进入 VBlank，然后结束这一帧的音频
+static void emulate_frame(Machine* m){
+    do{
+        cpu_step(&m->cpu);
+    }while(!finish_instruction(m));
+
+    machine_end_frame(m);
+}
+
+static void run_ahead_frame(Machine* m){
+    PPU* ppu = &m->ppu;
+    APU* apu = &m->apu;
+
+    // 1. 真实时间线上的这一帧：出声音，画面反正会被预跑的结果盖掉
+    ppu->skip_render = 1;
+    emulate_frame(m);
+    savestate_save(m, m->run_ahead_state, m->run_ahead_size);
+
+    // 2. 按住当前按键往前跑，只画最后一帧。
+    // 直接关掉合成而不走 apu_set_audio：声道状态马上会从存档恢复，不需要重新对齐
+    uint8_t audio = apu->audio_enabled;
+    apu->audio_enabled = 0;
+    for(int i = 0; i < m->run_ahead; i++){
+        ppu->skip_render = (i < m->run_ahead - 1);
+        emulate_frame(m);
+    }
+    ppu->skip_render = 0;
+
+    // 3. 回到真实时间线；画面不在存档里，留下的是预跑出来的那一帧
+    savestate_load(m, m->run_ahead_state, m->run_ahead_size);
+    apu->audio_enabled = audio;
+}
+
+int machine_lag_frame(const Machine* m){
+    return m->lag;
+}
+
+uint32_t machine_lag_count(const Machine* m){
+    return m->lag_frames;
+}
+
+int machine_skip_lag(Machine* m, int max_frames){
+    int frames = 0;
+    while(m->lag && frames < max_frames){
+        machine_run_frame(m);
+        frames++;
+    }
+    return frames;
+}
+
+void machine_run_frame(Machine* m){
+    if(m->movie){
+        apply_movie_frame(m);
+    }
+
+    if(m->run_ahead > 0 && !m->ppu.worker){
+        run_ahead_frame(m);
+    } else {
+        emulate_frame(m);
+    }
+
+    if(m->hash_log){
+        statehash_log_append(m->hash_log, m);
+    }
+    if(m->battery){
+        battery_end_frame(m->battery);
+    }
+    if(m->output){
+        publish_output(m);
+    }
+}
+
+int machine_set_run_ahead(Machine* m, int frames){
+    if(frames <= 0){
+        free(m->run_ahead_state);
+        m->run_ahead_state = NULL;
+        m->run_ahead_size = 0;
+        m->run_ahead = 0;
+        return 1;
+    }
+    if(!m->run_ahead_state){
+        m->run_ahead_size = savestate_size(m);
+        m->run_ahead_state = (uint8_t*)malloc(m->run_ahead_size);
+        if(!m->run_ahead_state) return 0;
+    }
+    m->run_ahead = frames;
+    return 1;
+}
+
+void machine_set_sample_rate(Machine* m, double sample_rate){
+    apu_set_sample_rate(&m->apu, sample_rate);
+}
+
+void machine_set_audio_quality(Machine* m, int quality){
+    apu_set_resample_quality(&m->apu, quality);
+}
+
+void machine_adjust_audio_rate(Machine* m, double ratio){
+    apu_set_rate_adjust(&m->apu, ratio);
+}
+
+void machine_set_audio(Machine* m, int enabled){
+    apu_set_audio(&m->apu, enabled);
+}
+
+int machine_read_audio(Machine* m, int16_t* out, int count){
+    return apu_read_samples(&m->apu, out, count);
+}
+
+int machine_start_render_thread(Machine* m){
+    if(m->ppu.worker) return 1;
+    return ppu_thread_start(&m->ppu) != NULL;
+}
+
+void machine_stop_render_thread(Machine* m){
+    ppu_thread_stop(m->ppu.worker);
+}
+
+void machine_attach_output(Machine* m, struct AvOutput* output){
+    m->output = output;
+}
+
+void machine_attach_hash_log(Machine* m, struct StateHashLog* log){
+    m->hash_log = log;
+}
+
+void machine_attach_battery(Machine* m, struct Battery* battery){
+    Bus* bus = &m->bus;
+    if(battery){
+        bus->prg_ram = battery_data(battery);
+    } else {
+        if(bus->prg_ram != bus->prg_ram_store){
+            memcpy(bus->prg_ram_store, bus->prg_ram, BUS_PRG_RAM_SIZE);
+        }
+        bus->prg_ram = bus->prg_ram_store;
+    }
+    m->battery = battery;
+    // 内容整块换了：增量存档要把 PRG-RAM 全部带上
+    bus->prg_ram_dirty = 0xFF;
+}
+
+int machine_revert_battery(Machine* m){
+    if(!m->battery || !battery_revert(m->battery)) return 0;
+    // 页被换掉而不是被写：总线的脏页记录看不到，整块标脏
+    m->bus.prg_ram_dirty = 0xFF;
+    return 1;
+}
+
+const PpuFrame* machine_frame(Machine* m){
+    if(m->ppu.worker){
+        return ppu_thread_acquire_frame(m->ppu.worker, NULL);
+    }
+    return &m->ppu.frame;
+}
@@ -0,0 +1,127 @@
+// machine.h
+#pragma once
+#include <stdint.h>
+#include "ines.h"
+#include "bus.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "apu.h"
+
+// 默认输出采样率
+#define MACHINE_SAMPLE_RATE 48000
+
+// 一台完整的 NES：把 CPU、总线、PPU、APU 组装在一起
+typedef struct Machine{
+    CPU cpu;
+    Bus bus;
+    PPU ppu;
+    APU apu;
+
+    // 输出队列 (av_output.h)；NULL 表示不发布，由调用方自己取画面和音频
+    struct AvOutput* output;
+
+    // 正在回放的输入录像 (movie.h)；NULL 表示按键由前端通过 machine_set_input 给出
+    const struct Movie* movie;
+    uint32_t movie_frame;   // 下一帧要用录像里的第几帧
+
+    // 延迟帧：游戏整帧没有碰手柄（见 Bus 的 input_polled）。最近一帧是不是，以及上电以来一共有多少个
+    uint8_t lag;
+    uint32_t lag_frames;
+
+    // 逐帧状态哈希日志 (statehash.h)；NULL 表示不记录
+    struct StateHashLog* hash_log;
+
+    // 电池存档 (battery.h)：PRG-RAM 映射在它的文件上；NULL 表示用总线自带的存储
+    struct Battery* battery;
+
+    // 增量存档的基准 (savestate.h)：最近一次完整存档/恢复的那份存档的标识（0 = 那份存档不是基准）。
+    // 总线和 PPU 上的写入追踪位都是相对这个存档记录的
+    uint64_t state_base;
+
+    // 预跑 (machine_set_run_ahead)：往前跑的帧数，以及跑之前的存档
+    int run_ahead;
+    uint8_t* run_ahead_state;
+    size_t run_ahead_size;
+} Machine;
+
+// 插入卡带并上电复位
+void machine_init(Machine* m, NesRom* rom);
+void machine_reset(Machine* m);
+
+// 写时复制分支（搜索、强化学习里每秒上千次地从同一个状态分出去）：
+// child 得到 parent 此刻的全部模拟状态，和 parent 共享卡带 ROM 与 VRAM 存储页，
+// 之后两边谁先写某一页谁才拷贝那 1KB。2KB 的 RAM 几乎每帧都会写，和 8KB 的 PRG-RAM 一起直接拷贝。
+// child 是调用方提供的存储，原内容直接覆盖；它不合成音频（可用 machine_set_audio 打开）、
+// 没有输出队列，画面在它跑完第一帧之后才有效。
+// parent 处于渲染线程模式时返回 0
+int machine_fork(Machine* parent, Machine* child);
+
+// 不再与别的机器共享存储页（共享页拷回自己），之后照常可用。
+// 参与过分支的机器（包括 parent）丢弃或重新 machine_init 之前调用，否则共享页会泄漏
+void machine_release(Machine* m);
+
+// 设置手柄按键（bit 0 = A ... bit 7 = 右），在下一次游戏读手柄时生效
+void machine_set_input(Machine* m, int port, uint8_t buttons);
+
+// 从录像的第 0 帧开始回放：之后每帧开始时自动装入按键，放完后自动停止
+void machine_play_movie(Machine* m, const struct Movie* movie);
+int machine_movie_playing(const Machine* m);
+
+// 运行到下一帧画面完成（PPU 进入 VBlank），同时结束这一帧的音频
+void machine_run_frame(Machine* m);
+
+// 逐条指令驱动（给锁步核心这类自己调度多台机器的调用方）：
+// machine_step 执行一条指令；machine_finish_instruction 只做指令之后的事（到截止时间追赶 PPU / APU、响应中断），
+// 给已经在外面把指令执行完的调用方用。两者返回 1 表示这一帧画完了，这时调用 machine_end_frame 结束这一帧的音频。
+// 不处理录像、预跑和输出队列
+int machine_step(Machine* m);
+int machine_finish_instruction(Machine* m);
+void machine_end_frame(Machine* m);
+
+// 延迟帧：最近完成的一帧游戏没有锁存也没有读手柄，这一帧给的按键不可能起作用。
+// 游戏逻辑跑不完一帧（掉帧）时也会出现，计数可以用来监控游戏自身的卡顿。
+// 预跑的帧不计入（状态从存档恢复）
+int machine_lag_frame(const Machine* m);
+uint32_t machine_lag_count(const Machine* m);
+
+// 最近一帧是延迟帧时按住当前按键接着跑，直到跑出一帧读了手柄的，最多 max_frames 帧；返回多跑了几帧。
+// 强化学习、搜索每一步之后调用，下一个决策点就不会落在按键没用的帧上
+int machine_skip_lag(Machine* m, int max_frames);
+
+// 预跑：每帧先跑真实的一帧（出声音），存档，再用当前按键往前跑 frames 帧
+// （中间帧不画也不出声，只画最后一帧），显示这一帧后恢复存档。
+// 游戏自带的 1-3 帧输入延迟就被抵掉了，代价是每帧多跑 frames 帧。
+// frames = 0 关闭并释放存档缓冲；渲染线程模式下不生效。成功返回 1
+int machine_set_run_ahead(Machine* m, int frames);
+
+// 音频输出：采样率可选 44100 / 48000；每帧结束后读出这一帧的单声道 int16 采样
+void machine_set_sample_rate(Machine* m, double sample_rate);
+// 重采样质量 (enum ResampleQuality)，以及音画同步用的 ±0.5% 采样率微调
+void machine_set_audio_quality(Machine* m, int quality);
+void machine_adjust_audio_rate(Machine* m, double ratio);
+int machine_read_audio(Machine* m, int16_t* out, int count);
+
+// 无头运行（批量跑、训练）时关掉音频合成，模拟结果与打开时逐周期一致
+void machine_set_audio(Machine* m, int enabled);
+
+// 把像素渲染放到独立线程上（多核机器上用于高速录像/快进），成功返回 1
+int machine_start_render_thread(Machine* m);
+void machine_stop_render_thread(Machine* m);
+
+// 每帧结束时把画面和音频发布到输出队列（传 NULL 取消）。
+// 队列满时丢帧而不是等待，模拟线程不会被输出线程拖慢
+void machine_attach_output(Machine* m, struct AvOutput* output);
+
+// 每帧结束时把状态哈希追加到日志（传 NULL 取消）；分支出来的机器不继承
+void machine_attach_hash_log(Machine* m, struct StateHashLog* log);
+
+// 把 PRG-RAM 换成电池存档的内容，之后游戏的写入直接落在存档上（每 BATTERY_SYNC_FRAMES 帧异步刷一次盘）。
+// 传 NULL 摘下：存档当前的内容拷回总线自带的存储。分支出来的机器拿到的是拷贝，不会写到存档里
+void machine_attach_battery(Machine* m, struct Battery* battery);
+
+// 挂着的私有存档回到模板 (battery_revert)，并让下一个增量存档带上整块 PRG-RAM。
+// 没挂存档或者是共享存档时返回 0
+int machine_revert_battery(Machine* m);
+
+// 最新完成的一帧画面（调色板索引格式，不拷贝）
+const PpuFrame* machine_frame(Machine* m);
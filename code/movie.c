@@ -0,0 +1,136 @@
+// movie.c
+#include "movie.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define FRAME_COUNT_UNKNOWN 0xFFFFFFFFu
+
+static uint32_t read_u32(const uint8_t* p){
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write_u32(uint8_t* p, uint32_t v){
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+// 把整个文件放进内存：POSIX 上用只读映射，页面按需调入；Windows 上直接读进来
+static int map_file(Movie* movie, const char* path){
+#if !defined(_WIN32)
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return 0;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < MOVIE_HEADER_SIZE){
+        close(fd);
+        return 0;
+    }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // 映射建立之后就不再需要文件描述符
+    if(map == MAP_FAILED) return 0;
+    // 回放是顺序访问，提示内核提前预读
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+    movie->map = map;
+    movie->map_size = (size_t)st.st_size;
+    return 1;
+#else
+    FILE* fp = fopen(path, "rb");
+    if(!fp) return 0;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if(size < MOVIE_HEADER_SIZE){
+        fclose(fp);
+        return 0;
+    }
+    void* data = malloc((size_t)size);
+    if(!data || fread(data, 1, (size_t)size, fp) != (size_t)size){
+        free(data);
+        fclose(fp);
+        return 0;
+    }
+    fclose(fp);
+    movie->map = data;
+    movie->map_size = (size_t)size;
+    return 1;
+#endif
+}
+
+static void unmap_file(Movie* movie){
+    if(!movie->map) return;
+#if !defined(_WIN32)
+    munmap(movie->map, movie->map_size);
+#else
+    free(movie->map);
+#endif
+    movie->map = NULL;
+}
+
+int movie_open(Movie* movie, const char* path){
+    memset(movie, 0, sizeof(Movie));
+    if(!map_file(movie, path)) return 0;
+
+    const uint8_t* header = (const uint8_t*)movie->map;
+    uint8_t ports = header[5];
+    uint8_t bytes_per_port = header[6];
+    if(memcmp(header, "NESM", 4) != 0 || header[4] != MOVIE_VERSION ||
+       ports < 1 || ports > MOVIE_MAX_PORTS || bytes_per_port < 1 || bytes_per_port > 2){
+        unmap_file(movie);
+        return 0;
+    }
+
+    movie->ports = ports;
+    movie->bytes_per_port = bytes_per_port;
+    movie->stride = ports * bytes_per_port;
+    movie->frames = header + MOVIE_HEADER_SIZE;
+
+    // 文件头里的帧数不可信（没有正常关闭的录像），以文件实际长度为上限
+    uint32_t available = (uint32_t)((movie->map_size - MOVIE_HEADER_SIZE) / movie->stride);
+    uint32_t count = read_u32(header + 8);
+    movie->frame_count = (count == FRAME_COUNT_UNKNOWN || count > available) ? available : count;
+    return 1;
+}
+
+void movie_close(Movie* movie){
+    unmap_file(movie);
+    movie->frames = NULL;
+    movie->frame_count = 0;
+}
+
+int movie_writer_open(MovieWriter* writer, const char* path, int ports, int bytes_per_port){
+    memset(writer, 0, sizeof(MovieWriter));
+    if(ports < 1 || ports > MOVIE_MAX_PORTS || bytes_per_port < 1 || bytes_per_port > 2) return 0;
+
+    writer->fp = fopen(path, "wb");
+    if(!writer->fp) return 0;
+    writer->ports = (uint8_t)ports;
+    writer->bytes_per_port = (uint8_t)bytes_per_port;
+
+    uint8_t header[MOVIE_HEADER_SIZE] = {'N', 'E', 'S', 'M', MOVIE_VERSION, (uint8_t)ports, (uint8_t)bytes_per_port, 0};
+    write_u32(header + 8, FRAME_COUNT_UNKNOWN);
+    fwrite(header, 1, sizeof(header), writer->fp);
+    return 1;
+}
+
+void movie_writer_frame(MovieWriter* writer, const uint8_t* input){
+    fwrite(input, 1, (size_t)writer->ports * writer->bytes_per_port, writer->fp);
+    writer->frame_count++;
+}
+
+int movie_writer_close(MovieWriter* writer){
+    if(!writer->fp) return 0;
+    uint8_t count[4];
+    write_u32(count, writer->frame_count);
+    int ok = fseek(writer->fp, 8, SEEK_SET) == 0 && fwrite(count, 1, 4, writer->fp) == 4;
+    ok = (fclose(writer->fp) == 0) && ok;
+    writer->fp = NULL;
+    return ok;
+}
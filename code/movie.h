@@ -0,0 +1,69 @@
+// movie.h
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+
+// 输入录像：逐帧记录手柄按键，回放时逐周期重现同一局游戏。
+//
+// 文件格式（小端，固定布局）：
+//   0  "NESM"
+//   4  版本号 (MOVIE_VERSION)
+//   5  端口数 (1 或 2)
+//   6  每个端口每帧的字节数 (1 或 2)
+//   7  保留
+//   8  帧数 (uint32)；录制中途崩溃时为 0xFFFFFFFF，按文件长度推算
+//   12 保留 (uint32)
+//   16 帧数据：第 f 帧、第 p 个端口的第 k 个字节在 16 + f*stride + p*bytes_per_port + k
+//
+// 每个端口的第 0 字节是手柄按键（bit 0 = A ... bit 7 = 右，与 Bus.controller 相同）；
+// 第 1 字节（如果有）是命令位，目前只用了端口 0 的 MOVIE_CMD_RESET。
+//
+// 回放时整个文件映射进内存，每帧只是按下标取字节，没有任何解析。
+
+#define MOVIE_VERSION 1
+#define MOVIE_HEADER_SIZE 16
+#define MOVIE_MAX_PORTS 2
+
+#define MOVIE_CMD_RESET 0x01 // 这一帧开始前按下复位键
+
+typedef struct Movie{
+    const uint8_t* frames;   // 第 0 帧的数据
+    uint32_t frame_count;
+    uint8_t ports;
+    uint8_t bytes_per_port;
+    uint8_t stride;          // 每帧的字节数 = ports * bytes_per_port
+
+    // 映射/读入的整个文件
+    void* map;
+    size_t map_size;
+} Movie;
+
+// 第 frame 帧第 port 个端口的按键
+static inline uint8_t movie_buttons(const Movie* movie, uint32_t frame, int port){
+    if(port >= movie->ports) return 0;
+    return movie->frames[frame * movie->stride + port * movie->bytes_per_port];
+}
+
+// 第 frame 帧的命令位（只有每端口 2 字节的录像才有）
+static inline uint8_t movie_commands(const Movie* movie, uint32_t frame){
+    if(movie->bytes_per_port < 2) return 0;
+    return movie->frames[frame * movie->stride + 1];
+}
+
+// 打开录像用于回放，成功返回 1
+int movie_open(Movie* movie, const char* path);
+void movie_close(Movie* movie);
+
+// 录制：每帧追加 ports * bytes_per_port 个字节
+typedef struct MovieWriter{
+    FILE* fp;
+    uint8_t ports;
+    uint8_t bytes_per_port;
+    uint32_t frame_count;
+} MovieWriter;
+
+int movie_writer_open(MovieWriter* writer, const char* path, int ports, int bytes_per_port);
+// input 按端口顺序排列：端口 0 的字节，端口 1 的字节
+void movie_writer_frame(MovieWriter* writer, const uint8_t* input);
+// 写回最终帧数并关闭文件，成功返回 1
+int movie_writer_close(MovieWriter* writer);
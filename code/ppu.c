@@ -0,0 +1,661 @@
+// ppu.c
+#include "ppu.h"
+#include "ppu_thread.h"
+#include "hash.h"
+#include <string.h> // for memset
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+// VBlank 开始的位置：第 241 行的第 1 个 dot
+#define VBLANK_LINE 241
+#define PRERENDER_LINE 261
+
+void ppu_init(PPU* ppu, NesRom* rom){
+    memset(ppu, 0, sizeof(PPU));
+
+    // 连接卡带的图案表：没有 CHR-ROM 的卡带使用 8KB CHR-RAM
+    if(rom && rom->chr_rom){
+        ppu->chr = rom->chr_rom;
+        ppu->chr_banks = rom->header.chr_size * 8;
+        ppu->chr_writable = 0;
+    } else {
+        ppu->chr = ppu->chr_ram;
+        ppu->chr_banks = sizeof(ppu->chr_ram) / PPU_PAGE_SIZE;
+        ppu->chr_writable = 1;
+    }
+    // 上电时 8 个槽位按顺序映射前 8KB (NROM)
+    for(int i = 0; i < 8; i++){
+        ppu->chr_bank[i] = (uint16_t)i;
+    }
+    ppu->mirroring = rom ? rom->mirroring : MIRROR_HORIZONTAL;
+    ppu_relink(ppu);
+}
+
+static int rendering_enabled(const PPU* ppu){
+    return (ppu->mask & 0x18) != 0;
+}
+
+// 渲染线程模式下，把影响画面的事件记进日志
+static void log_event(PPU* ppu, uint8_t type, uint16_t addr, uint8_t data){
+    PpuCommand cmd;
+    cmd.clock = ppu->clock;
+    cmd.addr = addr;
+    cmd.type = type;
+    cmd.data = data;
+    cmd.ctrl = ppu->ctrl;
+    cmd.mask = ppu->mask;
+    cmd.x = ppu->x;
+    cmd.reserved = 0;
+    ppu_thread_push(ppu->worker, &cmd);
+}
+
+
+// --- PPU 地址空间 (页表) ---
+// 每种镜像方式下，4 个逻辑名称表分别落在 CIRAM 的哪个 1KB 上
+static const uint8_t nametable_layout[5][4] = {
+    { 0, 0, 1, 1 }, // 水平镜像: A A B B
+    { 0, 1, 0, 1 }, // 垂直镜像: A B A B
+    { 0, 0, 0, 0 }, // 单屏 (低)
+    { 1, 1, 1, 1 }, // 单屏 (高)
+    { 0, 1, 2, 3 }, // 四屏
+};
+
+// 写时复制的共享页：只读，最后一个引用释放时回收
+typedef struct CowPage{
+    _Atomic int refs;
+    uint8_t data[PPU_PAGE_SIZE];
+} CowPage;
+
+static uint8_t* own_store_page(PPU* ppu, int n){
+    return n < 8 ? ppu->chr_ram + n * PPU_PAGE_SIZE : ppu->ciram + (n - 8) * PPU_PAGE_SIZE;
+}
+
+uint8_t* ppu_store_page(PPU* ppu, int n){
+    return ppu->shared[n] ? ppu->shared[n]->data : own_store_page(ppu, n);
+}
+
+static void map_nametables(PPU* ppu){
+    const uint8_t* layout = nametable_layout[ppu->mirroring];
+    for(int i = 0; i < 4; i++){
+        uint8_t* page = ppu_store_page(ppu, 8 + layout[i]);
+        ppu->pages[8 + i] = page;  // $2000-$2FFF
+        ppu->pages[12 + i] = page; // $3000-$3EFF 是它的镜像
+        ppu->page_store[8 + i] = ppu->page_store[12 + i] = (uint8_t)(8 + layout[i]);
+    }
+    ppu->page_writable |= 0xFF00;
+}
+
+static void map_chr_slot(PPU* ppu, int slot){
+    uint32_t bank = ppu->chr_bank[slot] % ppu->chr_banks;
+    ppu->pages[slot] = ppu->chr_writable ? ppu_store_page(ppu, bank) : ppu->chr + bank * PPU_PAGE_SIZE;
+    ppu->page_store[slot] = (uint8_t)(bank & 7); // 只有 8KB 的 CHR-RAM 可写
+    if(ppu->chr_writable){
+        ppu->page_writable |= (1 << slot);
+    } else {
+        ppu->page_writable &= ~(1 << slot);
+    }
+}
+
+void ppu_relink(PPU* ppu){
+    if(ppu->chr_writable){
+        ppu->chr = ppu->chr_ram;
+    }
+    for(int i = 0; i < 8; i++){
+        map_chr_slot(ppu, i);
+    }
+    map_nametables(ppu);
+}
+
+void ppu_map_chr(PPU* ppu, int slot, uint16_t bank){
+    if(ppu->worker){
+        log_event(ppu, PPU_CMD_CHR_BANK, bank, (uint8_t)slot);
+    }
+    ppu->chr_bank[slot] = bank;
+    map_chr_slot(ppu, slot);
+}
+
+void ppu_set_mirroring(PPU* ppu, int mirroring){
+    if(ppu->worker){
+        log_event(ppu, PPU_CMD_MIRRORING, 0, (uint8_t)mirroring);
+    }
+    ppu->mirroring = mirroring;
+    map_nametables(ppu);
+}
+
+// 渲染时的取数：图案表和名称表都只是一次页表查找
+static inline uint8_t vram_fetch(const PPU* ppu, uint16_t addr){
+    return ppu->pages[addr >> 10][addr & 0x03FF];
+}
+
+// 调色板镜像：$3F10/$3F14/$3F18/$3F1C 是 $3F00/$3F04/$3F08/$3F0C 的镜像
+static uint8_t palette_index(uint16_t addr){
+    uint8_t i = addr & 0x1F;
+    if((i & 0x13) == 0x10){
+        i &= ~0x10;
+    }
+    return i;
+}
+
+// --- 写时复制 ---
+static void release_page(CowPage* page){
+    if(atomic_fetch_sub_explicit(&page->refs, 1, memory_order_acq_rel) == 1){
+        free(page);
+    }
+}
+
+static void unshare_page(PPU* ppu, int n, int copy){
+    if(copy){
+        memcpy(own_store_page(ppu, n), ppu->shared[n]->data, PPU_PAGE_SIZE);
+    }
+    release_page(ppu->shared[n]);
+    ppu->shared[n] = NULL;
+    ppu->store_shared &= ~(1 << n);
+}
+
+void ppu_unshare(PPU* ppu, int copy){
+    if(!ppu->store_shared) return;
+    for(int n = 0; n < PPU_STORE_PAGES; n++){
+        if(ppu->shared[n]){
+            unshare_page(ppu, n, copy);
+        }
+    }
+    ppu_relink(ppu);
+}
+
+void ppu_fork(PPU* ppu, PPU* child){
+    // 只拷贝寄存器、卡带描述、时序状态、调色板和 OAM；CHR-RAM/CIRAM 走共享页，画面不拷贝
+    memcpy(child, ppu, offsetof(PPU, ciram));
+    memcpy(child->palette, ppu->palette, sizeof(ppu->palette));
+    memcpy(child->oam, ppu->oam, sizeof(ppu->oam));
+    child->worker = NULL;
+    child->store_shared = 0;
+    memset(child->shared, 0, sizeof(child->shared));
+
+    // CHR-ROM 本来就是共享的只读数据，只有 CHR-RAM 卡带的图案表需要处理
+    int first = ppu->chr_writable ? 0 : 8;
+    for(int n = first; n < PPU_STORE_PAGES; n++){
+        // 自己独占的页先冻结成共享页；上次分支之后没写过的页已经是共享的，不用再拷贝
+        if(!ppu->shared[n]){
+            CowPage* page = (CowPage*)malloc(sizeof(CowPage));
+            if(!page){
+                continue; // 内存不够时这一页照常拷贝
+            }
+            atomic_init(&page->refs, 1);
+            memcpy(page->data, own_store_page(ppu, n), PPU_PAGE_SIZE);
+            ppu->shared[n] = page;
+            ppu->store_shared |= 1 << n;
+        }
+        atomic_fetch_add_explicit(&ppu->shared[n]->refs, 1, memory_order_relaxed);
+        child->shared[n] = ppu->shared[n];
+        child->store_shared |= 1 << n;
+    }
+    // 没有共享成功的页按值拷贝
+    for(int n = first; n < PPU_STORE_PAGES; n++){
+        if(!child->shared[n]){
+            memcpy(own_store_page(child, n), own_store_page(ppu, n), PPU_PAGE_SIZE);
+        }
+    }
+    ppu_relink(ppu);
+    ppu_relink(child);
+}
+
+uint8_t ppu_bus_read(PPU* ppu, uint16_t addr){
+    addr &= 0x3FFF;
+    if(addr >= 0x3F00){
+        return ppu->palette[palette_index(addr)];
+    }
+    return vram_fetch(ppu, addr);
+}
+
+void ppu_bus_write(PPU* ppu, uint16_t addr, uint8_t data){
+    addr &= 0x3FFF;
+    if(ppu->worker){
+        log_event(ppu, PPU_CMD_VRAM, addr, data);
+    }
+    if(addr >= 0x3F00){
+        ppu->palette[palette_index(addr)] = data & 0x3F;
+    } else if(ppu->page_writable & (1 << (addr >> 10))){
+        uint8_t store = ppu->page_store[addr >> 10];
+        if(ppu->store_shared & (1 << store)){
+            unshare_page(ppu, store, 1);
+            ppu_relink(ppu);
+        }
+        ppu->pages[addr >> 10][addr & 0x03FF] = data;
+        ppu->vram_dirty |= 1 << store;
+    }
+}
+
+
+// --- CPU 可见的寄存器 ---
+uint8_t ppu_read_register(PPU* ppu, uint16_t reg){
+    uint8_t data = 0x00;
+    switch(reg){
+        case 0x0002: // PPUSTATUS
+            // 低 5 位是总线上残留的数据，这里用读缓冲近似
+            data = (ppu->status & 0xE0) | (ppu->read_buffer & 0x1F);
+            ppu->status &= ~0x80; // 读取后清除 VBlank 标志
+            ppu->w = 0;
+            break;
+        case 0x0004: // OAMDATA
+            data = ppu->oam[ppu->oam_addr];
+            break;
+        case 0x0007: // PPUDATA
+            // 普通地址的读取会延迟一次（返回上一次缓冲的值）
+            data = ppu->read_buffer;
+            ppu->read_buffer = ppu_bus_read(ppu, ppu->v);
+            // 调色板没有延迟，但缓冲区会装入"下面"的名称表数据
+            if((ppu->v & 0x3FFF) >= 0x3F00){
+                data = ppu->read_buffer;
+                ppu->read_buffer = ppu_bus_read(ppu, ppu->v - 0x1000);
+            }
+            ppu->v += (ppu->ctrl & 0x04) ? 32 : 1;
+            break;
+        default: // 其他寄存器是只写的
+            break;
+    }
+    return data;
+}
+
+void ppu_write_register(PPU* ppu, uint16_t reg, uint8_t data){
+    switch(reg){
+        case 0x0000: { // PPUCTRL
+            uint8_t old = ppu->ctrl;
+            ppu->ctrl = data;
+            ppu->t = (ppu->t & 0xF3FF) | ((data & 0x03) << 10);
+            // 在 VBlank 期间打开 NMI 使能会立刻触发一次 NMI
+            if((data & 0x80) && !(old & 0x80) && (ppu->status & 0x80)){
+                ppu->nmi_pending = 1;
+            }
+            break;
+        }
+        case 0x0001: // PPUMASK
+            ppu->mask = data;
+            break;
+        case 0x0003: // OAMADDR
+            ppu->oam_addr = data;
+            break;
+        case 0x0004: // OAMDATA
+            if(ppu->worker){
+                log_event(ppu, PPU_CMD_OAM, ppu->oam_addr, data);
+            }
+            ppu->oam[ppu->oam_addr++] = data;
+            break;
+        case 0x0005: // PPUSCROLL
+            if(ppu->w == 0){
+                ppu->x = data & 0x07;
+                ppu->t = (ppu->t & 0xFFE0) | (data >> 3);
+                ppu->w = 1;
+            } else {
+                ppu->t = (ppu->t & 0x8C1F) | ((data & 0x07) << 12) | ((data & 0xF8) << 2);
+                ppu->w = 0;
+            }
+            break;
+        case 0x0006: // PPUADDR
+            if(ppu->w == 0){
+                ppu->t = (ppu->t & 0x80FF) | ((data & 0x3F) << 8);
+                ppu->w = 1;
+            } else {
+                ppu->t = (ppu->t & 0xFF00) | data;
+                ppu->v = ppu->t;
+                ppu->w = 0;
+            }
+            break;
+        case 0x0007: // PPUDATA
+            ppu_bus_write(ppu, ppu->v, data);
+            ppu->v += (ppu->ctrl & 0x04) ? 32 : 1;
+            break;
+        default:
+            break;
+    }
+}
+
+
+// --- 滚动寄存器的更新 (与硬件在固定 dot 上做的事情一致) ---
+// dot 256: v 的垂直位置 +1
+static void increment_y(PPU* ppu){
+    if((ppu->v & 0x7000) != 0x7000){
+        ppu->v += 0x1000; // fine Y < 7，直接加
+        return;
+    }
+    ppu->v &= ~0x7000;
+    uint16_t coarse_y = (ppu->v & 0x03E0) >> 5;
+    if(coarse_y == 29){
+        coarse_y = 0;
+        ppu->v ^= 0x0800; // 切换垂直名称表
+    } else if(coarse_y == 31){
+        coarse_y = 0;     // 属性表区域，回卷但不切换名称表
+    } else {
+        coarse_y++;
+    }
+    ppu->v = (ppu->v & ~0x03E0) | (coarse_y << 5);
+}
+
+// dot 257: 从 t 复制水平位置
+static void copy_x(PPU* ppu){
+    ppu->v = (ppu->v & ~0x041F) | (ppu->t & 0x041F);
+}
+
+// pre-render 行 dot 280-304: 从 t 复制垂直位置
+static void copy_y(PPU* ppu){
+    ppu->v = (ppu->v & ~0x7BE0) | (ppu->t & 0x7BE0);
+}
+
+
+// --- 扫描线渲染 ---
+// 选出本行可见的精灵（按 OAM 顺序最多 8 个），同时维护精灵溢出标志
+static int evaluate_sprites(PPU* ppu, int line, uint8_t selected[8]){
+    int height = (ppu->ctrl & 0x20) ? 16 : 8;
+    int count = 0;
+    for(int i = 0; i < 64; i++){
+        // OAM 中的 Y 比实际显示位置少 1
+        int row = line - (ppu->oam[i * 4] + 1);
+        if(row < 0 || row >= height){
+            continue;
+        }
+        if(count == 8){
+            ppu->status |= 0x20; // 精灵溢出
+            break;
+        }
+        selected[count++] = (uint8_t)i;
+    }
+    return count;
+}
+
+// 取出第 i 个精灵在本行的一行图案（两个位平面）
+static void sprite_pattern(PPU* ppu, int i, int line, uint8_t* lo, uint8_t* hi){
+    const uint8_t* s = &ppu->oam[i * 4];
+    int height = (ppu->ctrl & 0x20) ? 16 : 8;
+    int row = line - (s[0] + 1);
+    uint8_t tile = s[1];
+    if(s[2] & 0x80){
+        row = height - 1 - row; // 垂直翻转
+    }
+    uint16_t addr;
+    if(height == 16){
+        addr = ((tile & 0x01) ? 0x1000 : 0x0000) + (tile & 0xFE) * 16;
+        if(row >= 8){
+            addr += 16;
+            row -= 8;
+        }
+    } else {
+        addr = ((ppu->ctrl & 0x08) ? 0x1000 : 0x0000) + tile * 16;
+    }
+    *lo = vram_fetch(ppu, addr + row);
+    *hi = vram_fetch(ppu, addr + row + 8);
+}
+
+// 背景在屏幕第 x 列的颜色号 (0-3)，只用于精灵 0 命中检测
+static uint8_t background_pixel(PPU* ppu, int x){
+    int offset = x + ppu->x;
+    uint16_t v = ppu->v;
+    uint16_t coarse_x = (v & 0x001F) + (offset >> 3);
+    if(coarse_x >= 32){
+        coarse_x -= 32;
+        v ^= 0x0400; // 跨到水平相邻的名称表
+    }
+    v = (v & ~0x001F) | coarse_x;
+
+    uint8_t tile_id = vram_fetch(ppu, 0x2000 | (v & 0x0FFF));
+    uint16_t addr = ((ppu->ctrl & 0x10) ? 0x1000 : 0x0000) + tile_id * 16 + ((v >> 12) & 0x07);
+    int bit = 7 - (offset & 0x07);
+    return ((vram_fetch(ppu, addr) >> bit) & 0x01) | (((vram_fetch(ppu, addr + 8) >> bit) & 0x01) << 1);
+}
+
+// 不画像素，只计算本行 CPU 可见的状态（精灵溢出、精灵 0 命中）
+// 渲染线程模式下由 CPU 线程调用，代价只有 OAM 扫描加最多 8 个像素的比较
+static void scanline_status(PPU* ppu, int line){
+    if(!rendering_enabled(ppu)){
+        return;
+    }
+    uint8_t selected[8];
+    int count = evaluate_sprites(ppu, line, selected);
+    if(count == 0 || selected[0] != 0 || (ppu->mask & 0x18) != 0x18 || (ppu->status & 0x40)){
+        return;
+    }
+
+    uint8_t lo, hi;
+    sprite_pattern(ppu, 0, line, &lo, &hi);
+    uint8_t attr = ppu->oam[2];
+    for(int col = 0; col < 8; col++){
+        int x = ppu->oam[3] + col;
+        if(x >= 255){
+            break; // x = 255 永远不会命中
+        }
+        if(x < 8 && (ppu->mask & 0x06) != 0x06){
+            continue; // 左侧 8 像素被裁剪
+        }
+        int bit = (attr & 0x40) ? col : 7 - col;
+        if((((lo >> bit) | (hi >> bit << 1)) & 0x03) && background_pixel(ppu, x)){
+            ppu->status |= 0x40;
+            return;
+        }
+    }
+}
+
+// 以整行为单位渲染：在 dot 256 时用当前的 v/x 一次画完 256 个像素。
+static void draw_scanline(PPU* ppu, int line){
+    uint8_t* out = &ppu->frame.pixels[line * PPU_WIDTH];
+    uint8_t grey = (ppu->mask & 0x01) ? 0x30 : 0x3F;
+    ppu->frame.emphasis[line] = (ppu->mask >> 5) & 0x07;
+
+    if(!rendering_enabled(ppu)){
+        memset(out, ppu->palette[0] & grey, PPU_WIDTH);
+        return;
+    }
+
+    // 1. 背景：每个像素存 (调色板号 << 2) | 颜色号，颜色号为 0 表示透明
+    uint8_t bg[PPU_WIDTH + 16];
+    memset(bg, 0, sizeof(bg));
+    if(ppu->mask & 0x08){
+        uint16_t v = ppu->v;
+        uint16_t fine_y = (v >> 12) & 0x07;
+        uint16_t pattern_base = (ppu->ctrl & 0x10) ? 0x1000 : 0x0000;
+        for(int tile = 0; tile < 33; tile++){
+            uint8_t tile_id = vram_fetch(ppu, 0x2000 | (v & 0x0FFF));
+            uint8_t attr = vram_fetch(ppu, 0x23C0 | (v & 0x0C00) | ((v >> 4) & 0x38) | ((v >> 2) & 0x07));
+            uint8_t shift = ((v >> 4) & 0x04) | (v & 0x02);
+            uint8_t pal = ((attr >> shift) & 0x03) << 2;
+
+            uint16_t addr = pattern_base + tile_id * 16 + fine_y;
+            uint8_t lo = vram_fetch(ppu, addr);
+            uint8_t hi = vram_fetch(ppu, addr + 8);
+            for(int b = 0; b < 8; b++){
+                uint8_t px = ((lo >> (7 - b)) & 0x01) | (((hi >> (7 - b)) & 0x01) << 1);
+                bg[tile * 8 + b] = px ? (pal | px) : 0;
+            }
+
+            // coarse X +1，跨越到水平相邻的名称表
+            if((v & 0x001F) == 31){
+                v &= ~0x001F;
+                v ^= 0x0400;
+            } else {
+                v++;
+            }
+        }
+    }
+    uint8_t* bg_line = bg + ppu->x;
+    if(!(ppu->mask & 0x02)){
+        memset(bg_line, 0, 8); // 左侧 8 像素背景裁剪
+    }
+
+    // 2. 精灵：编号小的精灵优先，先画上的像素不会被覆盖
+    uint8_t spr[PPU_WIDTH];     // 0x10 | (调色板号 << 2) | 颜色号
+    uint8_t spr_behind[PPU_WIDTH];
+    uint8_t spr_zero[PPU_WIDTH];
+    memset(spr, 0, sizeof(spr));
+    uint8_t selected[8];
+    int count = evaluate_sprites(ppu, line, selected);
+    if(ppu->mask & 0x10){
+        for(int n = 0; n < count; n++){
+            int i = selected[n];
+            const uint8_t* s = &ppu->oam[i * 4];
+            uint8_t attr = s[2];
+            uint8_t lo, hi;
+            sprite_pattern(ppu, i, line, &lo, &hi);
+
+            for(int col = 0; col < 8; col++){
+                int x = s[3] + col;
+                if(x >= PPU_WIDTH){
+                    break;
+                }
+                if(x < 8 && !(ppu->mask & 0x04)){
+                    continue; // 左侧 8 像素精灵裁剪
+                }
+                int bit = (attr & 0x40) ? col : 7 - col; // 水平翻转
+                uint8_t px = ((lo >> bit) & 0x01) | (((hi >> bit) & 0x01) << 1);
+                if(px && !spr[x]){
+                    spr[x] = 0x10 | ((attr & 0x03) << 2) | px;
+                    spr_behind[x] = attr & 0x20;
+                    spr_zero[x] = (i == 0);
+                }
+            }
+        }
+    }
+
+    // 3. 合成
+    for(int x = 0; x < PPU_WIDTH; x++){
+        uint8_t b = bg_line[x];
+        uint8_t s = spr[x];
+        uint8_t color = b;
+        if(s){
+            // 精灵 0 命中：精灵 0 和背景的不透明像素重叠 (x = 255 除外)
+            if(spr_zero[x] && b && x != 255){
+                ppu->status |= 0x40;
+            }
+            if(!(b && spr_behind[x])){
+                color = s;
+            }
+        }
+        out[x] = ppu->palette[color] & grey;
+    }
+}
+
+
+// 画完一行后更新脏行标记和整帧哈希（行按 0-239 的顺序渲染）
+static void track_scanline(PpuFrame* frame, int line){
+    uint64_t h = hash64(&frame->pixels[line * PPU_WIDTH], PPU_WIDTH, frame->emphasis[line]);
+    if(line == 0){
+        frame->dirty[0] = frame->dirty[1] = frame->dirty[2] = frame->dirty[3] = 0;
+        frame->dirty_count = 0;
+        frame->hash = 0;
+    }
+    if(h != frame->line_hash[line]){
+        frame->line_hash[line] = h;
+        frame->dirty[line >> 6] |= 1ULL << (line & 63);
+        frame->dirty_count++;
+    }
+    frame->hash = hash64_combine(frame->hash, h);
+}
+
+void ppu_render_scanline(PPU* ppu, int line){
+    draw_scanline(ppu, line);
+    track_scanline(&ppu->frame, line);
+}
+
+
+// --- 惰性同步 ---
+// 当前行内下一个"有事发生"的 dot；两个事件之间 PPU 对外不可见，直接跳过
+static int next_event_dot(const PPU* ppu){
+    int d = ppu->dot;
+    if(ppu->scanline < PPU_HEIGHT){
+        if(d < 256) return 256;
+        if(d < 257) return 257;
+        return PPU_DOTS_PER_LINE;
+    }
+    if(ppu->scanline == VBLANK_LINE){
+        if(d < 1) return 1;
+        return PPU_DOTS_PER_LINE;
+    }
+    if(ppu->scanline == PRERENDER_LINE){
+        if(d < 1) return 1;
+        if(d < 256) return 256;
+        if(d < 257) return 257;
+        if(d < 280) return 280;
+        // 奇数帧且渲染开启时，pre-render 行少一个 dot
+        if(d < 340 && (ppu->frame_count & 1) && rendering_enabled(ppu)) return 340;
+        return PPU_DOTS_PER_LINE;
+    }
+    return PPU_DOTS_PER_LINE;
+}
+
+static void end_scanline(PPU* ppu){
+    ppu->dot = 0;
+    ppu->scanline++;
+    if(ppu->scanline == PPU_LINES_PER_FRAME){
+        ppu->scanline = 0;
+        ppu->frame_count++;
+    }
+}
+
+// PPU 走到 ppu->dot 时要做的事情
+static void handle_event(PPU* ppu){
+    int line = ppu->scanline;
+    int d = ppu->dot;
+
+    if(d == PPU_DOTS_PER_LINE || (line == PRERENDER_LINE && d == 340)){
+        end_scanline(ppu);
+        return;
+    }
+
+    if(line < PPU_HEIGHT){
+        if(d == 256){
+            if(ppu->worker){
+                // 像素交给渲染线程，这里只算 CPU 能看到的状态位
+                scanline_status(ppu, line);
+                log_event(ppu, PPU_CMD_LINE, ppu->v, (uint8_t)line);
+            } else if(ppu->skip_render){
+                scanline_status(ppu, line);
+            } else {
+                ppu_render_scanline(ppu, line);
+            }
+            if(rendering_enabled(ppu)) increment_y(ppu);
+        } else if(d == 257){
+            if(rendering_enabled(ppu)) copy_x(ppu);
+        }
+    } else if(line == VBLANK_LINE){
+        ppu->status |= 0x80;
+        ppu->frame_complete = 1;
+        if(ppu->worker){
+            log_event(ppu, PPU_CMD_FRAME_END, 0, 0);
+        }
+        if(ppu->ctrl & 0x80){
+            ppu->nmi_pending = 1;
+        }
+    } else if(line == PRERENDER_LINE){
+        if(d == 1){
+            ppu->status &= ~0xE0; // 清除 VBlank / 精灵 0 / 溢出
+        } else if(rendering_enabled(ppu)){
+            if(d == 256) increment_y(ppu);
+            else if(d == 257) copy_x(ppu);
+            else if(d == 280) copy_y(ppu);
+        }
+    }
+}
+
+void ppu_run_to(PPU* ppu, uint64_t target){
+    while(ppu->clock < target){
+        int next = next_event_dot(ppu);
+        uint64_t budget = target - ppu->clock;
+        if((uint64_t)(next - ppu->dot) > budget){
+            // 目标落在两个事件之间：只推进计数，不做任何工作
+            ppu->dot += (int)budget;
+            ppu->clock = target;
+            return;
+        }
+        ppu->clock += next - ppu->dot;
+        ppu->dot = next;
+        handle_event(ppu);
+    }
+}
+
+uint64_t ppu_next_event(const PPU* ppu){
+    // 忽略奇数帧少掉的那个 dot：截止时间最多早 1 个 dot，到时多同步一次即可
+    int64_t pos = (int64_t)ppu->scanline * PPU_DOTS_PER_LINE + ppu->dot;
+    int64_t vblank = (int64_t)VBLANK_LINE * PPU_DOTS_PER_LINE + 1;
+    int64_t delta = vblank - pos;
+    if(delta <= 0){
+        delta += (int64_t)PPU_LINES_PER_FRAME * PPU_DOTS_PER_LINE;
+    }
+    return ppu->clock + (uint64_t)delta;
+}
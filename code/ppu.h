@@ -0,0 +1,144 @@
+// ppu.h
+#pragma once
+#include <stdint.h>
+#include "ines.h"
+
+#define PPU_WIDTH  256
+#define PPU_HEIGHT 240
+
+// NTSC 时序：每行 341 个 dot，每帧 262 行，1 个 CPU 周期 = 3 个 dot
+#define PPU_DOTS_PER_LINE  341
+#define PPU_LINES_PER_FRAME 262
+#define PPU_DOTS_PER_CPU_CYCLE 3
+
+// PPU 的 16KB 地址空间按 1KB 分页：0-7 图案表, 8-11 名称表, 12-15 名称表镜像 + 调色板
+#define PPU_PAGE_SIZE 1024
+#define PPU_PAGE_COUNT 16
+// 可写的存储页：CHR-RAM 的 8 个 bank + CIRAM 的 4 个 1KB（也是 vram_dirty 的位定义）
+#define PPU_STORE_PAGES 12
+
+struct CowPage;
+
+// 一帧画面的原生格式：每像素 1 字节的 6 位 NES 颜色号（已应用灰度位），
+// 外加每条扫描线 3 位的颜色强调 (PPUMASK bit 5-7)。
+// 扫描线渲染时强调位在一行内不变，所以按行存储就够了；
+// 需要 RGBA/RGB565/YUV 时再用 video.h 里的转换函数按需转换。
+//
+// 渲染每一行时顺便计算该行的哈希：和上一帧同一行的哈希不同就标记为"脏"，
+// 并按行顺序累计出整帧的哈希。帧差分推流、回归比对可以跳过没变的行/帧。
+typedef struct PpuFrame{
+    uint8_t pixels[PPU_WIDTH * PPU_HEIGHT];
+    uint8_t emphasis[PPU_HEIGHT];
+
+    uint64_t line_hash[PPU_HEIGHT]; // 每行 (像素 + 强调位) 的哈希
+    uint64_t dirty[4];              // 第 n 位 = 第 n 行与上一帧不同（共 240 位）
+    uint16_t dirty_count;           // 本帧变化的行数，0 表示整帧未变
+    uint64_t hash;                  // 整帧哈希，第 239 行画完后有效
+} PpuFrame;
+
+// 第 line 行是否与上一帧不同
+static inline int ppu_frame_line_dirty(const PpuFrame* frame, int line){
+    return (frame->dirty[line >> 6] >> (line & 63)) & 1;
+}
+
+typedef struct PPU{
+    // 1. CPU 可见的寄存器 ($2000 - $2007)
+    uint8_t ctrl;     // $2000 PPUCTRL
+    uint8_t mask;     // $2001 PPUMASK
+    uint8_t status;   // $2002 PPUSTATUS
+    uint8_t oam_addr; // $2003 OAMADDR
+
+    // 2. 内部滚动寄存器 (loopy v/t/x/w)
+    uint16_t v;  // 当前 VRAM 地址
+    uint16_t t;  // 临时 VRAM 地址 (左上角滚动位置)
+    uint8_t x;   // fine X 滚动 (3 位)
+    uint8_t w;   // $2005/$2006 的写入翻转标志
+    uint8_t read_buffer; // $2007 读缓冲
+
+    // 3. 卡带连接：页表由下面这些"描述"推导出来
+    uint8_t* chr;          // CHR-ROM，或者指向 chr_ram
+    uint32_t chr_banks;    // CHR 总大小，单位 1KB
+    uint8_t chr_writable;  // CHR-RAM 可写
+    uint16_t chr_bank[8];  // 图案表每个 1KB 槽位当前映射的 bank
+    int mirroring;         // enum Mirroring
+
+    // 地址空间页表：每次取数都是 pages[addr >> 10][addr & 0x3FF]，
+    // Mapper 切换 CHR bank 或镜像方式时只需要改指针
+    uint8_t* pages[PPU_PAGE_COUNT];
+    uint16_t page_writable; // 第 n 位 = 第 n 页可写
+
+    // 写入追踪（增量存档用）：按 1KB 的存储页记录自基准存档以来被写过的页，
+    // 第 0-7 位是 CHR-RAM 的 8 个 bank，第 8-11 位是 CIRAM 的 4 个 1KB
+    uint16_t vram_dirty;
+    uint8_t page_store[PPU_PAGE_COUNT]; // 第 n 页落在 vram_dirty 的哪一位上
+
+    // 写时复制 (machine_fork)：存储页可以换成和别的机器共享的只读副本，
+    // 第一次写入时才拷回自己的 chr_ram/ciram。第 n 位 = 第 n 个存储页是共享的
+    uint16_t store_shared;
+    struct CowPage* shared[PPU_STORE_PAGES];
+
+    // 4. 时序状态
+    int scanline;      // 0-239 可见, 240 post-render, 241-260 VBlank, 261 pre-render
+    int dot;           // 当前行内已经走过的 dot 数 (0-340)
+    uint64_t clock;    // 上电以来走过的 dot 总数（惰性同步的时间戳）
+    uint64_t frame_count;
+
+    uint8_t nmi_pending;     // VBlank 开始且 NMI 使能时置 1，由 CPU 侧取走
+    uint8_t frame_complete;  // 一帧画面渲染完成（进入 VBlank）时置 1
+
+    // 渲染线程 (ppu_thread.h)；NULL 表示在 CPU 线程上直接渲染
+    struct PpuThread* worker;
+
+    // 1 = 跳过像素渲染，只计算 CPU 看得到的状态（精灵 0 命中）。
+    // 预跑 (run-ahead) 的中间帧用，画面保留上一次渲染的内容
+    uint8_t skip_render;
+
+    // 5. PPU 自己的存储器。放在寄存器和时序状态后面：
+    // CPU 每条指令都要查的 nmi_pending / frame_complete 和寄存器挨在一起，不被 12KB 的存储隔开
+    uint8_t ciram[4096];   // 名称表 VRAM：主机 2KB + 四屏卡带额外的 2KB
+    uint8_t palette[32];   // 调色板 RAM
+    uint8_t oam[256];      // 精灵属性表 (64 个精灵 x 4 字节)
+    uint8_t chr_ram[8192]; // 卡带没有 CHR-ROM 时使用的 CHR-RAM
+
+    // 6. 输出画面（调色板索引格式）
+    PpuFrame frame;
+} PPU;
+
+// 初始化 PPU 并连接卡带的 CHR 数据
+void ppu_init(PPU* ppu, NesRom* rom);
+
+// Mapper 接口：把第 slot 个 1KB 图案表槽位 (0-7) 映射到 CHR 的第 bank 个 1KB
+void ppu_map_chr(PPU* ppu, int slot, uint16_t bank);
+// Mapper 接口：切换名称表镜像方式 (enum Mirroring)
+void ppu_set_mirroring(PPU* ppu, int mirroring);
+
+// PPU 结构体被整体拷贝（线程副本、存档恢复）之后，让页表重新指向自己的存储器
+void ppu_relink(PPU* ppu);
+
+// 第 n 个存储页 (0-7 CHR-RAM, 8-11 CIRAM) 当前的内容，可能是共享的只读副本
+uint8_t* ppu_store_page(PPU* ppu, int n);
+
+// 写时复制分支：child 得到 ppu 的全部状态（画面除外），存储页与 ppu 共享，
+// 之后两边谁先写某一页谁拷贝。child 的原内容直接覆盖
+void ppu_fork(PPU* ppu, PPU* child);
+
+// 不再共享任何存储页：copy = 1 时把共享页的内容拷回自己的存储器，
+// copy = 0 时直接丢掉（调用方马上会整体覆盖，例如恢复存档）
+void ppu_unshare(PPU* ppu, int copy);
+
+// CPU 通过 $2000-$2007 访问 PPU（reg 已经是 addr & 0x0007）
+uint8_t ppu_read_register(PPU* ppu, uint16_t reg);
+void ppu_write_register(PPU* ppu, uint16_t reg, uint8_t data);
+
+// 惰性同步：把 PPU 一次性追赶到 target（单位：dot）
+void ppu_run_to(PPU* ppu, uint64_t target);
+
+// 下一次 CPU 必须来同步的时间点（单位：dot），目前就是下一次进入 VBlank
+uint64_t ppu_next_event(const PPU* ppu);
+
+// 用当前的 v/x/ctrl/mask 画出一条扫描线到 ppu->frame
+void ppu_render_scanline(PPU* ppu, int line);
+
+// PPU 自己的 14 位地址空间读写 ($0000-$3FFF)
+uint8_t ppu_bus_read(PPU* ppu, uint16_t addr);
+void ppu_bus_write(PPU* ppu, uint16_t addr, uint8_t data);
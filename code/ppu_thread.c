@@ -0,0 +1,238 @@
+// ppu_thread.c
+#include "ppu_thread.h"
+#include "aligned.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+
+// 日志容量（条），必须是 2 的幂；一帧通常只有几百到几千条
+#define LOG_CAPACITY (1u << 15)
+#define LOG_MASK (LOG_CAPACITY - 1)
+
+// 三缓冲里"中间"槽位的新鲜标志
+#define FRAME_FRESH 0x04
+
+// 等待时先让出 CPU 自旋这么多轮，还等不到才睡下
+#define SPIN_ROUNDS 64
+
+struct PpuThread{
+    // 1. 日志：head 只由 CPU 线程写，tail 只由渲染线程写，分开放在不同缓存行
+    PpuCommand ring[LOG_CAPACITY];
+    _Alignas(64) _Atomic uint64_t head;
+    _Alignas(64) _Atomic uint64_t tail;
+
+    // 2. 渲染线程自己的 PPU 副本（只用它的存储器和渲染函数）
+    _Alignas(64) PPU shadow;
+    PPU* owner;
+
+    // 3. 三缓冲画面：渲染线程写 back，读者读 front，middle 用原子交换传递
+    PpuFrame frames[3];
+    uint64_t frame_numbers[3];
+    _Atomic int middle;
+    int back;
+    int front;
+
+    _Atomic int running;
+    pthread_t thread;
+
+    // 4. 休眠：日志空了渲染线程睡在 render_wake 上，日志满了/flush 时 CPU 线程睡在 space 上。
+    // 对方只在看到 *_sleeping 时才去加锁唤醒，平时的 push 不碰锁
+    pthread_mutex_t lock;
+    pthread_cond_t render_wake;
+    pthread_cond_t space;
+    _Atomic int render_sleeping;
+    _Atomic int cpu_sleeping;
+};
+
+// 睡下之前先置标志再检查条件，唤醒的一方先发布数据再看标志（都是顺序一致的原子操作），
+// 两边至少有一方能看到对方，唤醒不会丢
+static void wake(PpuThread* th, _Atomic int* sleeping, pthread_cond_t* cond){
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load(sleeping)){
+        pthread_mutex_lock(&th->lock);
+        pthread_cond_signal(cond);
+        pthread_mutex_unlock(&th->lock);
+    }
+}
+
+static void publish_frame(PpuThread* th){
+    th->frames[th->back] = th->shadow.frame;
+    th->frame_numbers[th->back] = th->shadow.frame_count++;
+    int prev = atomic_exchange_explicit(&th->middle, th->back | FRAME_FRESH, memory_order_acq_rel);
+    th->back = prev & 0x03;
+}
+
+static void apply(PpuThread* th, const PpuCommand* cmd){
+    PPU* shadow = &th->shadow;
+    switch(cmd->type){
+        case PPU_CMD_VRAM:
+            ppu_bus_write(shadow, cmd->addr, cmd->data);
+            break;
+        case PPU_CMD_OAM:
+            shadow->oam[cmd->addr & 0xFF] = cmd->data;
+            break;
+        case PPU_CMD_LINE:
+            shadow->v = cmd->addr;
+            shadow->x = cmd->x;
+            shadow->ctrl = cmd->ctrl;
+            shadow->mask = cmd->mask;
+            ppu_render_scanline(shadow, cmd->data);
+            break;
+        case PPU_CMD_FRAME_END:
+            publish_frame(th);
+            break;
+        case PPU_CMD_CHR_BANK:
+            ppu_map_chr(shadow, cmd->data, cmd->addr);
+            break;
+        case PPU_CMD_MIRRORING:
+            ppu_set_mirroring(shadow, cmd->data);
+            break;
+        default:
+            break;
+    }
+}
+
+// 渲染线程：日志里有新内容（或者要退出）时返回
+static void wait_for_log(PpuThread* th, uint64_t tail){
+    for(int i = 0; i < SPIN_ROUNDS; i++){
+        if(atomic_load_explicit(&th->head, memory_order_acquire) != tail ||
+           !atomic_load_explicit(&th->running, memory_order_acquire)){
+            return;
+        }
+        sched_yield();
+    }
+    // 模拟器空闲、暂停或者限速在 60Hz 时，大部分时间睡在这里
+    pthread_mutex_lock(&th->lock);
+    atomic_store(&th->render_sleeping, 1);
+    while(atomic_load(&th->head) == tail && atomic_load(&th->running)){
+        pthread_cond_wait(&th->render_wake, &th->lock);
+    }
+    atomic_store(&th->render_sleeping, 0);
+    pthread_mutex_unlock(&th->lock);
+}
+
+// CPU 线程：等渲染线程把 tail 推进到 target
+static void wait_for_tail(PpuThread* th, uint64_t target){
+    if(atomic_load_explicit(&th->tail, memory_order_acquire) >= target) return;
+    // 渲染线程可能正睡着（它只在一帧结束时被叫醒）
+    wake(th, &th->render_sleeping, &th->render_wake);
+    for(int i = 0; i < SPIN_ROUNDS; i++){
+        if(atomic_load_explicit(&th->tail, memory_order_acquire) >= target) return;
+        sched_yield();
+    }
+    pthread_mutex_lock(&th->lock);
+    atomic_store(&th->cpu_sleeping, 1);
+    while(atomic_load(&th->tail) < target){
+        pthread_cond_wait(&th->space, &th->lock);
+    }
+    atomic_store(&th->cpu_sleeping, 0);
+    pthread_mutex_unlock(&th->lock);
+}
+
+static void* render_main(void* arg){
+    PpuThread* th = (PpuThread*)arg;
+    uint64_t tail = atomic_load_explicit(&th->tail, memory_order_relaxed);
+
+    for(;;){
+        uint64_t head = atomic_load_explicit(&th->head, memory_order_acquire);
+        if(tail == head){
+            // 只有在日志已经空了的时候才检查退出，保证 stop 之前的事件都被重放
+            if(!atomic_load_explicit(&th->running, memory_order_acquire)){
+                break;
+            }
+            wait_for_log(th, tail);
+            continue;
+        }
+        // 一次把已发布的日志全部重放完，再统一归还空间
+        while(tail != head){
+            apply(th, &th->ring[tail & LOG_MASK]);
+            tail++;
+        }
+        atomic_store_explicit(&th->tail, tail, memory_order_release);
+        wake(th, &th->cpu_sleeping, &th->space);
+    }
+    return NULL;
+}
+
+PpuThread* ppu_thread_start(PPU* ppu){
+    // head/tail/副本各自按缓存行对齐 (_Alignas(64))
+    PpuThread* th = (PpuThread*)aligned_calloc(_Alignof(PpuThread), sizeof(PpuThread));
+    if(!th) return NULL;
+
+    // 副本从 CPU 侧当前的存储器内容开始；页表要指向副本自己的 VRAM，
+    // 所以写时复制的共享页先全部拷回来
+    ppu_unshare(ppu, 1);
+    th->shadow = *ppu;
+    th->shadow.worker = NULL;
+    ppu_relink(&th->shadow);
+    th->shadow.frame_count = ppu->frame_count;
+    th->owner = ppu;
+
+    th->back = 0;
+    th->front = 1;
+    atomic_init(&th->middle, 2);
+    atomic_init(&th->head, 0);
+    atomic_init(&th->tail, 0);
+    atomic_init(&th->running, 1);
+    atomic_init(&th->render_sleeping, 0);
+    atomic_init(&th->cpu_sleeping, 0);
+    pthread_mutex_init(&th->lock, NULL);
+    pthread_cond_init(&th->render_wake, NULL);
+    pthread_cond_init(&th->space, NULL);
+
+    if(pthread_create(&th->thread, NULL, render_main, th) != 0){
+        pthread_cond_destroy(&th->space);
+        pthread_cond_destroy(&th->render_wake);
+        pthread_mutex_destroy(&th->lock);
+        aligned_free(th);
+        return NULL;
+    }
+    ppu->worker = th;
+    return th;
+}
+
+void ppu_thread_stop(PpuThread* th){
+    if(!th) return;
+    atomic_store_explicit(&th->running, 0, memory_order_release);
+    wake(th, &th->render_sleeping, &th->render_wake);
+    pthread_join(th->thread, NULL);
+    pthread_cond_destroy(&th->space);
+    pthread_cond_destroy(&th->render_wake);
+    pthread_mutex_destroy(&th->lock);
+
+    // 之后回到单线程渲染，画面从渲染线程的最新结果接着画
+    th->owner->worker = NULL;
+    th->owner->frame = th->shadow.frame;
+    aligned_free(th);
+}
+
+void ppu_thread_push(PpuThread* th, const PpuCommand* cmd){
+    uint64_t head = atomic_load_explicit(&th->head, memory_order_relaxed);
+    if(head - atomic_load_explicit(&th->tail, memory_order_acquire) >= LOG_CAPACITY){
+        wait_for_tail(th, head - LOG_CAPACITY + 1); // 日志满了：渲染线程落后太多，等它一下
+    }
+    th->ring[head & LOG_MASK] = *cmd;
+    atomic_store_explicit(&th->head, head + 1, memory_order_release);
+
+    // 一帧结束或者日志积了四分之一时才叫醒渲染线程，扫描线命令不逐条唤醒
+    if(cmd->type == PPU_CMD_FRAME_END || ((head + 1) & (LOG_CAPACITY / 4 - 1)) == 0){
+        wake(th, &th->render_sleeping, &th->render_wake);
+    }
+}
+
+void ppu_thread_flush(PpuThread* th){
+    wait_for_tail(th, atomic_load_explicit(&th->head, memory_order_relaxed));
+}
+
+const PpuFrame* ppu_thread_acquire_frame(PpuThread* th, uint64_t* frame_number){
+    if(atomic_load_explicit(&th->middle, memory_order_acquire) & FRAME_FRESH){
+        int prev = atomic_exchange_explicit(&th->middle, th->front, memory_order_acq_rel);
+        th->front = prev & 0x03;
+    }
+    if(frame_number){
+        *frame_number = th->frame_numbers[th->front];
+    }
+    return &th->frames[th->front];
+}
@@ -0,0 +1,46 @@
+// ppu_thread.h
+#pragma once
+#include <stdint.h>
+#include "ppu.h"
+
+// 渲染线程：CPU 线程只维护 CPU 可见的 PPU 状态（寄存器、VBlank、精灵 0 命中），
+// 把所有影响画面的事件按时间顺序记进一个无锁的单生产者/单消费者日志，
+// 渲染线程在自己的 PPU 副本上重放日志画出第 N 帧，同时 CPU 已经在跑第 N+1 帧。
+
+enum PpuCommandType{
+    PPU_CMD_VRAM = 0,  // 通过 $2007 写入图案表/名称表/调色板
+    PPU_CMD_OAM,       // 通过 $2004 或 OAM DMA 写入 OAM
+    PPU_CMD_LINE,      // 渲染一条扫描线，附带当时的 v/x/ctrl/mask
+    PPU_CMD_FRAME_END, // 一帧结束，发布画面
+    PPU_CMD_CHR_BANK,  // Mapper 切换 CHR bank：addr = bank, data = 槽位
+    PPU_CMD_MIRRORING, // Mapper 切换镜像方式：data = enum Mirroring
+};
+
+typedef struct PpuCommand{
+    uint64_t clock;  // 事件发生时的 PPU 时间戳 (dot)
+    uint16_t addr;   // VRAM/OAM 地址；LINE 命令里是 v；CHR_BANK 命令里是 bank
+    uint8_t type;
+    uint8_t data;    // 写入的数据；LINE 命令里是扫描线号
+    uint8_t ctrl;    // LINE 命令附带的寄存器快照
+    uint8_t mask;
+    uint8_t x;
+    uint8_t reserved;
+} PpuCommand;
+
+typedef struct PpuThread PpuThread;
+
+// 以 ppu 当前的存储器内容为起点启动渲染线程，之后 ppu 不再自己画像素
+PpuThread* ppu_thread_start(PPU* ppu);
+
+// 等日志全部重放完，停止线程，并把最后的画面拷回 ppu->frame
+void ppu_thread_stop(PpuThread* th);
+
+// CPU 线程追加一条日志（日志满时等待渲染线程）
+void ppu_thread_push(PpuThread* th, const PpuCommand* cmd);
+
+// 等待渲染线程把目前为止的日志全部重放完
+void ppu_thread_flush(PpuThread* th);
+
+// 取最新完成的一帧，返回的画面在下一次调用之前保持不变
+// frame_number 可为 NULL
+const PpuFrame* ppu_thread_acquire_frame(PpuThread* th, uint64_t* frame_number);
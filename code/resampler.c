@@ -0,0 +1,195 @@
+// resampler.c
+#include "resampler.h"
+#include <math.h>
+#include <string.h> // for memset, memmove
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#define RESAMPLER_PI 3.14159265358979323846
+
+static const int quality_taps[3] = {16, 32, 64};
+
+// 点积：taps 总是 16 的倍数，系数行按 32 字节对齐
+static inline float dot(const float* in, const float* k, int taps){
+#if defined(__AVX__)
+    __m256 acc = _mm256_setzero_ps();
+    for(int i = 0; i < taps; i += 8){
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(in + i), _mm256_load_ps(k + i)));
+    }
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+#elif defined(__SSE2__)
+    __m128 s = _mm_setzero_ps();
+    for(int i = 0; i < taps; i += 4){
+        s = _mm_add_ps(s, _mm_mul_ps(_mm_loadu_ps(in + i), _mm_load_ps(k + i)));
+    }
+#endif
+#if defined(__AVX__) || defined(__SSE2__)
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+#else
+    float a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+    for(int i = 0; i < taps; i += 4){
+        a0 += in[i] * k[i];
+        a1 += in[i + 1] * k[i + 1];
+        a2 += in[i + 2] * k[i + 2];
+        a3 += in[i + 3] * k[i + 3];
+    }
+    return (a0 + a1) + (a2 + a3);
+#endif
+}
+
+// 两组相邻相位的系数按 frac 混合后再做点积
+static inline float dot_interp(const float* in, const float* k0, const float* k1, float frac, int taps){
+#if defined(__AVX__)
+    __m256 acc = _mm256_setzero_ps();
+    __m256 f = _mm256_set1_ps(frac);
+    for(int i = 0; i < taps; i += 8){
+        __m256 a = _mm256_load_ps(k0 + i);
+        __m256 k = _mm256_add_ps(a, _mm256_mul_ps(f, _mm256_sub_ps(_mm256_load_ps(k1 + i), a)));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(in + i), k));
+    }
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+#elif defined(__SSE2__)
+    __m128 s = _mm_setzero_ps();
+    __m128 f = _mm_set1_ps(frac);
+    for(int i = 0; i < taps; i += 4){
+        __m128 a = _mm_load_ps(k0 + i);
+        __m128 k = _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(_mm_load_ps(k1 + i), a)));
+        s = _mm_add_ps(s, _mm_mul_ps(_mm_loadu_ps(in + i), k));
+    }
+#endif
+#if defined(__AVX__) || defined(__SSE2__)
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+#else
+    float acc = 0;
+    for(int i = 0; i < taps; i++){
+        acc += in[i] * (k0[i] + frac * (k1[i] - k0[i]));
+    }
+    return acc;
+#endif
+}
+
+// 第 p 组系数对应"输出位置在输入采样之后 p/PHASES 处"。
+// 截止频率取两个采样率中较低的那个的奈奎斯特频率再留 8% 余量，
+// 这样 +0.5% 的微调也不会让混叠漏进来。
+static void build_kernel(Resampler* r){
+    const int taps = r->taps;
+    double ratio = r->out_rate / r->in_rate;
+    double cutoff = 0.46 * (ratio < 1.0 ? ratio : 1.0); // 单位：输入采样率
+
+    memset(r->kernel, 0, sizeof(r->kernel));
+    for(int p = 0; p <= RESAMPLER_PHASES; p++){
+        double frac = (double)p / RESAMPLER_PHASES;
+        double sum = 0;
+        for(int k = 0; k < taps; k++){
+            double x = k - (taps / 2 - 1) - frac;
+            double sinc = (x == 0) ? 2 * cutoff : sin(2 * RESAMPLER_PI * cutoff * x) / (RESAMPLER_PI * x);
+            double w = (x + taps / 2) / taps;
+            double window = 0.42 - 0.5 * cos(2 * RESAMPLER_PI * w) + 0.08 * cos(4 * RESAMPLER_PI * w);
+            r->kernel[p][k] = (float)(sinc * window);
+            sum += sinc * window;
+        }
+        // 每组系数的和归一化为 1，直流增益不随相位变化
+        for(int k = 0; k < taps; k++){
+            r->kernel[p][k] = (float)(r->kernel[p][k] / sum);
+        }
+    }
+}
+
+static void update_step(Resampler* r){
+    r->step = (uint64_t)(r->in_rate / (r->out_rate * r->adjust) * 4294967296.0 + 0.5);
+}
+
+void resampler_init(Resampler* r, double in_rate, double out_rate, int quality){
+    r->adjust = 1.0;
+    r->in_rate = in_rate;
+    r->out_rate = out_rate;
+    r->quality = quality;
+    r->taps = quality_taps[quality];
+    build_kernel(r);
+    update_step(r);
+    resampler_clear(r);
+}
+
+void resampler_set_rates(Resampler* r, double in_rate, double out_rate){
+    r->in_rate = in_rate;
+    r->out_rate = out_rate;
+    build_kernel(r);
+    update_step(r);
+}
+
+void resampler_set_quality(Resampler* r, int quality){
+    if(quality < RESAMPLE_FAST || quality > RESAMPLE_BEST) return;
+    r->quality = quality;
+    r->taps = quality_taps[quality];
+    build_kernel(r);
+}
+
+void resampler_set_adjust(Resampler* r, double ratio){
+    if(ratio > 1.0 + RESAMPLER_MAX_ADJUST) ratio = 1.0 + RESAMPLER_MAX_ADJUST;
+    if(ratio < 1.0 - RESAMPLER_MAX_ADJUST) ratio = 1.0 - RESAMPLER_MAX_ADJUST;
+    r->adjust = ratio;
+    update_step(r);
+}
+
+void resampler_clear(Resampler* r){
+    r->pos = 0;
+    r->count = 0;
+    memset(r->history, 0, sizeof(r->history));
+}
+
+int resampler_process(Resampler* r, const int16_t* in, int in_count, int16_t* out, int out_capacity){
+    // 1. 新的输入接在历史后面
+    int space = RESAMPLER_MAX_TAPS + RESAMPLER_MAX_INPUT - r->count;
+    if(in_count > space) in_count = space;
+    float* dst = r->history + r->count;
+    for(int i = 0; i < in_count; i++){
+        dst[i] = in[i];
+    }
+    r->count += in_count;
+
+    // 2. 输入够一整个滤波窗口就产出一个采样
+    const int taps = r->taps;
+    const uint64_t step = r->step;
+    uint64_t pos = r->pos;
+    int n = 0;
+
+    if(r->quality == RESAMPLE_BEST){
+        while(n < out_capacity){
+            uint32_t index = (uint32_t)(pos >> 32);
+            if(index + taps > (uint32_t)r->count) break;
+            uint32_t fine = (uint32_t)(pos >> 16) & 0xFFFF;   // 16 位小数位置
+            uint32_t phase = fine >> (16 - RESAMPLER_PHASE_BITS);
+            float frac = (float)(fine & ((1 << (16 - RESAMPLER_PHASE_BITS)) - 1)) * (1.0f / (1 << (16 - RESAMPLER_PHASE_BITS)));
+            float s = dot_interp(r->history + index, r->kernel[phase], r->kernel[phase + 1], frac, taps);
+            s = s > 32767.0f ? 32767.0f : (s < -32768.0f ? -32768.0f : s);
+            out[n++] = (int16_t)lrintf(s);
+            pos += step;
+        }
+    }
+    else{
+        while(n < out_capacity){
+            uint32_t index = (uint32_t)(pos >> 32);
+            if(index + taps > (uint32_t)r->count) break;
+            // 四舍五入到最近的相位；进位到第 PHASES 组时正好用上多出来的那一组
+            uint32_t phase = (((uint32_t)(pos >> (32 - RESAMPLER_PHASE_BITS - 1)) & ((RESAMPLER_PHASES << 1) - 1)) + 1) >> 1;
+            float s = dot(r->history + index, r->kernel[phase], taps);
+            s = s > 32767.0f ? 32767.0f : (s < -32768.0f ? -32768.0f : s);
+            out[n++] = (int16_t)lrintf(s);
+            pos += step;
+        }
+    }
+
+    // 3. 丢掉已经用不到的输入
+    uint32_t used = (uint32_t)(pos >> 32);
+    if(used > (uint32_t)r->count) used = (uint32_t)r->count;
+    memmove(r->history, r->history + used, (size_t)(r->count - used) * sizeof(float));
+    r->count -= used;
+    r->pos = pos - ((uint64_t)used << 32);
+    return n;
+}
@@ -0,0 +1,54 @@
+// resampler.h
+#pragma once
+#include <stdint.h>
+
+// 多相 FIR 重采样：把 blip 合成出来的中间采样率转换成声卡的采样率。
+//
+// 滤波器是加窗 sinc，按输入采样之间的小数位置预先切成 RESAMPLER_PHASES 组系数。
+// 每个输出采样 = 一段输入历史和其中一组系数的点积，点积用 SSE/AVX 计算。
+// 一次处理一整帧的输入，循环里没有逐采样的函数调用。
+//
+// 转换比例可以在 ±0.5% 内动态微调：前端按自己音频缓冲的水位
+// 稍微多产出或少产出一点采样，音画就不会慢慢错开。
+
+#define RESAMPLER_PHASE_BITS 7
+#define RESAMPLER_PHASES   (1 << RESAMPLER_PHASE_BITS)
+#define RESAMPLER_MAX_TAPS 64
+#define RESAMPLER_MAX_INPUT 4096  // 一次 resampler_process 最多接收的输入采样数
+#define RESAMPLER_MAX_ADJUST 0.005
+
+enum ResampleQuality{
+    RESAMPLE_FAST = 0,   // 16 个抽头，取最近的相位
+    RESAMPLE_MEDIUM,     // 32 个抽头，取最近的相位
+    RESAMPLE_BEST,       // 64 个抽头，相邻两组相位之间线性插值
+};
+
+typedef struct Resampler{
+    int quality;
+    int taps;
+    double in_rate;
+    double out_rate;
+    double adjust;       // 输出采样率的微调比例，1.0 表示不调
+
+    uint64_t step;       // 每个输出采样前进多少个输入采样 (32.32 定点)
+    uint64_t pos;        // 下一个输出采样在 history 里的位置 (32.32 定点)
+
+    int count;           // history 里的有效输入采样数
+    _Alignas(32) float history[RESAMPLER_MAX_TAPS + RESAMPLER_MAX_INPUT];
+    // 多出一组相位，线性插值时第 PHASES-1 组可以直接和下一组混合
+    _Alignas(32) float kernel[RESAMPLER_PHASES + 1][RESAMPLER_MAX_TAPS];
+} Resampler;
+
+void resampler_init(Resampler* r, double in_rate, double out_rate, int quality);
+
+// 修改采样率或质量会重新生成系数，但保留历史数据
+void resampler_set_rates(Resampler* r, double in_rate, double out_rate);
+void resampler_set_quality(Resampler* r, int quality);
+
+// 输出采样率乘以 ratio（限制在 1 ± RESAMPLER_MAX_ADJUST 之内）
+void resampler_set_adjust(Resampler* r, double ratio);
+
+void resampler_clear(Resampler* r);
+
+// 送入 in_count 个输入采样，最多输出 out_capacity 个，返回实际输出的个数
+int resampler_process(Resampler* r, const int16_t* in, int in_count, int16_t* out, int out_capacity);
@@ -0,0 +1,151 @@
+// rewind.c
+#include "rewind.h"
+#include "savestate.h"
+#include "xdelta.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 全零的差分编码后也要 state_size / 255 字节左右，按每 64 字节数据配一个索引项就够用
+#define BYTES_PER_ENTRY 64
+
+typedef struct RewindEntry{
+    uint32_t offset;  // 在 data 里的位置
+    uint32_t size;    // 编码后的长度
+} RewindEntry;
+
+struct Rewind{
+    size_t state_size;
+    uint8_t* newest;   // 最新一帧的完整存档
+    uint8_t* scratch;  // 新的一帧先存到这里，编码完差分后和 newest 交换
+    uint8_t* encoded;  // 差分先编码到这里（最坏 XDELTA_BOUND），知道实际长度后再拷进环形缓冲区
+    int have_newest;
+
+    // 差分数据：按时间顺序首尾相接地写，写到末尾放不下时回到开头
+    uint8_t* data;
+    size_t data_size;
+    size_t head;       // 下一条差分的写入位置（最新一条的末尾）
+    size_t used;
+
+    // 差分索引：环形队列，first 是最早的一条
+    RewindEntry* entries;
+    uint32_t entry_cap;
+    uint32_t first;
+    uint32_t count;
+
+    void* block;       // 以上所有缓冲区共用的一次分配
+};
+
+Rewind* rewind_create(const Machine* m, size_t budget){
+    size_t state_size = savestate_size(m);
+    size_t fixed = sizeof(Rewind) + 2 * state_size + XDELTA_BOUND(state_size);
+    if(budget <= fixed) return NULL;
+
+    size_t entry_cap = (budget - fixed) / (BYTES_PER_ENTRY + sizeof(RewindEntry));
+    size_t data_size = entry_cap * BYTES_PER_ENTRY;
+    if(data_size < XDELTA_BOUND(state_size) || data_size > UINT32_MAX) return NULL;
+
+    uint8_t* block = (uint8_t*)malloc(fixed + entry_cap * sizeof(RewindEntry) + data_size);
+    if(!block) return NULL;
+
+    Rewind* r = (Rewind*)block;
+    r->block = block;
+    r->state_size = state_size;
+    r->entries = (RewindEntry*)(block + sizeof(Rewind));
+    r->entry_cap = (uint32_t)entry_cap;
+    r->newest = (uint8_t*)(r->entries + entry_cap);
+    r->scratch = r->newest + state_size;
+    r->encoded = r->scratch + state_size;
+    r->data = r->encoded + XDELTA_BOUND(state_size);
+    r->data_size = data_size;
+    rewind_clear(r);
+    return r;
+}
+
+void rewind_destroy(Rewind* r){
+    if(!r) return;
+    free(r->block);
+}
+
+void rewind_clear(Rewind* r){
+    r->have_newest = 0;
+    r->head = 0;
+    r->used = 0;
+    r->first = 0;
+    r->count = 0;
+}
+
+static RewindEntry* entry_at(Rewind* r, uint32_t i){
+    return &r->entries[(r->first + i) % r->entry_cap];
+}
+
+static void drop_oldest(Rewind* r){
+    r->used -= r->entries[r->first].size;
+    r->first = (r->first + 1) % r->entry_cap;
+    r->count--;
+}
+
+// 给一条 need 字节的差分腾出连续空间，返回写入位置
+static size_t reserve(Rewind* r, size_t need){
+    size_t start = r->head;
+    if(start + need > r->data_size){
+        // 回到开头：上一圈留在尾部的都是最早的条目，全部作废
+        while(r->count && entry_at(r, 0)->offset >= start){
+            drop_oldest(r);
+        }
+        start = 0;
+    }
+    // 前方紧挨着的就是最早的条目，和要写的区域重叠就丢掉
+    while(r->count){
+        RewindEntry* old = entry_at(r, 0);
+        int overlaps = old->offset < start + need && old->offset + old->size > start;
+        if(!overlaps && r->count < r->entry_cap) break;
+        drop_oldest(r);
+    }
+    return start;
+}
+
+int rewind_push(Rewind* r, Machine* m){
+    if(!savestate_save(m, r->scratch, r->state_size)) return 0;
+
+    if(r->have_newest){
+        // 记下"新帧 -> 上一帧"的差分，倒退时异或回去。
+        // 按实际长度占位：按最坏长度占位的话，写入位置永远到不了后半段，每一圈都把缓冲区清空
+        size_t size = xdelta_encode(r->scratch, r->newest, r->state_size, r->encoded);
+        size_t start = reserve(r, size);
+        memcpy(r->data + start, r->encoded, size);
+        RewindEntry* e = &r->entries[(r->first + r->count) % r->entry_cap];
+        e->offset = (uint32_t)start;
+        e->size = (uint32_t)size;
+        r->count++;
+        r->head = start + size;
+        r->used += size;
+    }
+
+    uint8_t* t = r->newest;
+    r->newest = r->scratch;
+    r->scratch = t;
+    r->have_newest = 1;
+    return 1;
+}
+
+int rewind_step_back(Rewind* r, Machine* m){
+    if(r->count == 0) return 0;
+
+    RewindEntry* e = entry_at(r, r->count - 1);
+    if(!xdelta_apply(r->newest, r->state_size, r->data + e->offset, e->size)){
+        rewind_clear(r);
+        return 0;
+    }
+    r->count--;
+    r->used -= e->size;
+    r->head = e->offset;
+    return savestate_load(m, r->newest, r->state_size);
+}
+
+uint32_t rewind_frames(const Rewind* r){
+    return r->count;
+}
+
+size_t rewind_used_bytes(const Rewind* r){
+    return r->used;
+}
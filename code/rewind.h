@@ -0,0 +1,35 @@
+// rewind.h
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "machine.h"
+
+// 倒带：每帧记一份存档，保存在固定大小的环形缓冲区里，内存用满时丢掉最早的帧。
+//
+// 只有最新一帧保留完整存档，其余每一帧都存成"它和后一帧的 XOR 差分"并压缩 (xdelta.h)。
+// 倒退一帧 = 把最新的差分异或回完整存档再恢复，每帧的代价是固定的，与已经记了多少帧无关。
+// 60fps 下典型的一帧差分只有几百字节，几 MB 的预算就能记下好几分钟。
+//
+// 记录和倒退都通过完整存档进行，所以会顺带把增量存档的基准 (savestate.h) 移到那一帧。
+
+typedef struct Rewind Rewind;
+
+// budget 是总内存上限（两份完整存档 + 一条差分的编码缓冲 + 索引 + 差分数据全部算在内），
+// 创建时一次性分配好；预算连一帧差分都放不下时返回 NULL
+Rewind* rewind_create(const Machine* m, size_t budget);
+void rewind_destroy(Rewind* r);
+
+// 每帧结束后调用，记下机器的当前状态；成功返回 1
+int rewind_push(Rewind* r, Machine* m);
+
+// 倒退一帧：丢掉最新记下的那一帧，把机器恢复到它的前一帧。
+// 没有更早的帧时返回 0，机器不变
+int rewind_step_back(Rewind* r, Machine* m);
+
+// 丢掉所有记录
+void rewind_clear(Rewind* r);
+
+// 还能倒退的帧数
+uint32_t rewind_frames(const Rewind* r);
+// 差分数据实际占用的字节数
+size_t rewind_used_bytes(const Rewind* r);
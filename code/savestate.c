@@ -0,0 +1,442 @@
+// savestate.c
+#include "savestate.h"
+#include "hash.h"
+#include <string.h>
+
+enum{ MODE_MEASURE, MODE_SAVE, MODE_LOAD };
+
+// 每个字段在存档里的位置由它在 transfer() 里出现的顺序决定。
+// 保存和恢复走同一个函数，两边的布局不可能写得不一致；
+// 字段大小都是编译期常量，memcpy 会被编译成一两条 mov
+#define FIELD(x) do{ \
+        if(mode == MODE_SAVE) memcpy(p, &(x), sizeof(x)); \
+        else if(mode == MODE_LOAD) memcpy(&(x), p, sizeof(x)); \
+        p += sizeof(x); \
+    }while(0)
+
+// 经指针访问的一块存储：PRG-RAM 可能映射在电池存档文件里 (battery.h)
+#define BYTES(ptr, size) do{ \
+        if(mode == MODE_SAVE) memcpy(p, (ptr), (size)); \
+        else if(mode == MODE_LOAD) memcpy((ptr), p, (size)); \
+        p += (size); \
+    }while(0)
+
+// CHR-RAM/CIRAM 按存储页搬运：写时复制的共享页 (machine_fork) 也能直接保存
+#define PAGES(ppu, first, count) do{ \
+        for(int n_ = (first); n_ < (first) + (count); n_++){ \
+            uint8_t* page_ = ppu_store_page((ppu), n_); \
+            if(mode == MODE_SAVE) memcpy(p, page_, PPU_PAGE_SIZE); \
+            else if(mode == MODE_LOAD) memcpy(page_, p, PPU_PAGE_SIZE); \
+            p += PPU_PAGE_SIZE; \
+        } \
+    }while(0)
+
+// 段的起点（状态哈希按部件分段）
+#define MARK(section) do{ \
+        if(marks) marks[section] = (size_t)(p - base); \
+    }while(0)
+
+static void transfer_envelope(ApuEnvelope* env, uint8_t** pp, const int mode){
+    uint8_t* p = *pp;
+    FIELD(env->start);
+    FIELD(env->loop);
+    FIELD(env->constant);
+    FIELD(env->volume);
+    FIELD(env->divider);
+    FIELD(env->decay);
+    *pp = p;
+}
+
+// CPU 看得到的 APU 状态：寄存器、长度/线性计数器、包络、扫频、帧计数器、DMC 取样、IRQ。
+// 关掉音频合成时这些照常推进，和打开时逐周期一致
+static void transfer_apu(APU* apu, uint8_t** pp, const int mode){
+    uint8_t* p = *pp;
+    for(int i = 0; i < 2; i++){
+        ApuPulse* pulse = &apu->pulse[i];
+        transfer_envelope(&pulse->env, &p, mode);
+        FIELD(pulse->enabled);
+        FIELD(pulse->length);
+        FIELD(pulse->duty);
+        FIELD(pulse->period);
+        FIELD(pulse->sweep_enabled);
+        FIELD(pulse->sweep_period);
+        FIELD(pulse->sweep_negate);
+        FIELD(pulse->sweep_shift);
+        FIELD(pulse->sweep_reload);
+        FIELD(pulse->sweep_divider);
+        FIELD(pulse->ones_complement);
+    }
+
+    ApuTriangle* tri = &apu->triangle;
+    FIELD(tri->enabled);
+    FIELD(tri->length);
+    FIELD(tri->control);
+    FIELD(tri->linear_reload);
+    FIELD(tri->linear);
+    FIELD(tri->reload_flag);
+    FIELD(tri->period);
+
+    ApuNoise* noise = &apu->noise;
+    transfer_envelope(&noise->env, &p, mode);
+    FIELD(noise->enabled);
+    FIELD(noise->length);
+    FIELD(noise->mode);
+    FIELD(noise->period_index);
+
+    ApuDmc* dmc = &apu->dmc;
+    FIELD(dmc->irq_enabled);
+    FIELD(dmc->loop);
+    FIELD(dmc->rate_index);
+    FIELD(dmc->sample_addr);
+    FIELD(dmc->sample_length);
+    FIELD(dmc->addr);
+    FIELD(dmc->remaining);
+    FIELD(dmc->buffer);
+    FIELD(dmc->buffer_full);
+    FIELD(dmc->bits);
+    FIELD(dmc->silence);
+    FIELD(dmc->next);
+
+    FIELD(apu->frame_mode);
+    FIELD(apu->irq_inhibit);
+    FIELD(apu->frame_step);
+    FIELD(apu->frame_next);
+    FIELD(apu->frame_irq);
+    FIELD(apu->dmc_irq);
+    FIELD(apu->dma_stall);
+    FIELD(apu->clock);
+    FIELD(apu->frame_start);
+    *pp = p;
+}
+
+// 只决定波形的状态：方波/三角的序列位置、噪声移位寄存器、它们的定时器，DMC 的输出电平和移位寄存器。
+// 关掉音频合成时这些不走 (apu_set_audio)，所以放在所有部件之后，状态哈希不算它们。
+// 声道的输出电平 (amp) 不保存：它描述的是 blip 里已经合成的波形，
+// 恢复后第一次变化时会自动补一个跳变到新的电平
+static void transfer_apu_synth(APU* apu, uint8_t** pp, const int mode){
+    uint8_t* p = *pp;
+    for(int i = 0; i < 2; i++){
+        FIELD(apu->pulse[i].step);
+        FIELD(apu->pulse[i].next);
+    }
+    FIELD(apu->triangle.step);
+    FIELD(apu->triangle.next);
+    FIELD(apu->noise.lfsr);
+    FIELD(apu->noise.next);
+    FIELD(apu->dmc.level);
+    FIELD(apu->dmc.shift);
+    *pp = p;
+}
+
+// 按固定顺序搬运所有状态，返回搬运的字节数（不含文件头）。
+// full = 0 时跳过按页追踪的大块存储器 (RAM/PRG-RAM/CHR-RAM/CIRAM)，由增量存档按页处理。
+// marks 不为 NULL 时记下每一段的起点（enum StateSection），给状态哈希按部件分段
+static inline size_t transfer(Machine* m, uint8_t* base, const int mode, const int full, size_t* marks){
+    uint8_t* p = base;
+
+    // 1. CPU
+    MARK(STATE_SECTION_CPU);
+    CPU* cpu = &m->cpu;
+    FIELD(cpu->a);
+    FIELD(cpu->x);
+    FIELD(cpu->y);
+    FIELD(cpu->stkp);
+    FIELD(cpu->pc);
+    FIELD(cpu->status);
+    FIELD(cpu->jammed);
+    // fetched_data / addr_abs / addr_rel / opcode / cycles 是指令内部的临时量：
+    // 每条指令都先由取指和寻址写好再用，跨指令不留信息，不保存（锁步核心也不维护它们）
+
+    // 2. 总线：RAM、PRG-RAM、主时钟、手柄
+    Bus* bus = &m->bus;
+    MARK(STATE_SECTION_RAM);
+    if(full) FIELD(bus->ram);
+    if(full) BYTES(bus->prg_ram, BUS_PRG_RAM_SIZE);
+    MARK(STATE_SECTION_BUS);
+    FIELD(bus->cycles);
+    FIELD(bus->controller);
+    FIELD(bus->controller_shift);
+    FIELD(bus->controller_strobe);
+    FIELD(bus->input_polled);
+
+    // 3. PPU：寄存器、存储器、时序
+    PPU* ppu = &m->ppu;
+    MARK(STATE_SECTION_PPU);
+    FIELD(ppu->ctrl);
+    FIELD(ppu->mask);
+    FIELD(ppu->status);
+    FIELD(ppu->oam_addr);
+    FIELD(ppu->v);
+    FIELD(ppu->t);
+    FIELD(ppu->x);
+    FIELD(ppu->w);
+    FIELD(ppu->read_buffer);
+    if(full) PAGES(ppu, 8, 4); // CIRAM
+    FIELD(ppu->palette);
+    FIELD(ppu->oam);
+    if(full) PAGES(ppu, 0, 8); // CHR-RAM
+    FIELD(ppu->scanline);
+    FIELD(ppu->dot);
+    FIELD(ppu->clock);
+    FIELD(ppu->frame_count);
+    FIELD(ppu->nmi_pending);
+    FIELD(ppu->frame_complete);
+
+    // 4. Mapper：CHR bank 与镜像方式（页表由它们推导）
+    MARK(STATE_SECTION_MAPPER);
+    FIELD(ppu->chr_bank);
+    FIELD(ppu->mirroring);
+
+    // 5. APU
+    MARK(STATE_SECTION_APU);
+    transfer_apu(&m->apu, &p, mode);
+
+    // 6. 录像回放位置、延迟帧
+    MARK(STATE_SECTION_MACHINE);
+    FIELD(m->movie_frame);
+    FIELD(m->lag);
+    FIELD(m->lag_frames);
+    MARK(STATE_SECTIONS);
+
+    // 7. 声道波形（不属于任何部件）
+    transfer_apu_synth(&m->apu, &p, mode);
+
+    return (size_t)(p - base);
+}
+
+#undef FIELD
+#undef PAGES
+#undef BYTES
+#undef MARK
+
+static uint32_t read_u32(const uint8_t* p){
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write_u32(uint8_t* p, uint32_t v){
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static void write_u16(uint8_t* p, uint16_t v){
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+static void write_u64(uint8_t* p, uint64_t v){
+    write_u32(p, (uint32_t)v);
+    write_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t read_u16(const uint8_t* p){
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint64_t read_u64(const uint8_t* p){
+    return read_u32(p) | ((uint64_t)read_u32(p + 4) << 32);
+}
+
+static void write_header(uint8_t* header, const char* magic, size_t total, uint64_t base_id){
+    memcpy(header, magic, 4);
+    write_u16(header + 4, SAVESTATE_VERSION);
+    write_u16(header + 6, 0);
+    write_u32(header + 8, (uint32_t)total);
+    write_u32(header + 12, 0);
+    write_u64(header + 16, base_id);
+}
+
+static int check_header(const uint8_t* header, size_t size, const char* magic){
+    return size >= SAVESTATE_HEADER_SIZE && memcmp(header, magic, 4) == 0 &&
+           read_u16(header + 4) == SAVESTATE_VERSION && read_u32(header + 8) <= size;
+}
+
+// 增量存档里的页：RAM 按 256 字节，PRG-RAM 按 1KB，VRAM 按 1KB（第 0-7 位 CHR-RAM，第 8-11 位 CIRAM）
+#define RAM_PAGE_SIZE 256
+#define PRG_RAM_PAGE_SIZE 1024
+
+static uint8_t* vram_page(Machine* m, int bit){
+    return ppu_store_page(&m->ppu, bit);
+}
+
+static int popcount16(uint16_t v){
+    int n = 0;
+    for(; v; v &= v - 1) n++;
+    return n;
+}
+
+// 渲染线程的 PPU 副本要从恢复后的状态重新开始
+static int restore_begin(Machine* m){
+    int threaded = m->ppu.worker != NULL;
+    if(threaded){
+        machine_stop_render_thread(m);
+    }
+    // 存储器马上被整体覆盖，共享页直接放弃
+    ppu_unshare(&m->ppu, 0);
+    return threaded;
+}
+
+static void restore_end(Machine* m, int threaded){
+    // 页表按恢复的 bank/镜像方式重新指向
+    ppu_relink(&m->ppu);
+
+    // 截止时间由恢复的状态直接推出，不追赶（追赶会让状态和保存时不一样）
+    Bus* bus = &m->bus;
+    uint64_t next = ppu_next_event(&m->ppu);
+    bus->ppu_deadline = (next + PPU_DOTS_PER_CPU_CYCLE - 1) / PPU_DOTS_PER_CPU_CYCLE;
+    bus->apu_deadline = apu_next_event(&m->apu);
+
+    if(threaded){
+        machine_start_render_thread(m);
+    }
+}
+
+// 机器与刚保存/恢复的完整存档一致，以它为新的基准（id 是那份存档的标识）
+static void set_base(Machine* m, uint64_t id){
+    m->state_base = id;
+    m->bus.ram_dirty = 0;
+    m->bus.prg_ram_dirty = 0;
+    m->ppu.vram_dirty = 0;
+}
+
+size_t savestate_size(const Machine* m){
+    // 测量模式只累加 sizeof，不读写任何字段
+    return SAVESTATE_HEADER_SIZE + transfer((Machine*)m, NULL, MODE_MEASURE, 1, NULL);
+}
+
+size_t savestate_save(Machine* m, void* buf, size_t size){
+    size_t total = savestate_size(m);
+    if(size < total) return 0;
+
+    uint8_t* header = (uint8_t*)buf;
+    transfer(m, header + SAVESTATE_HEADER_SIZE, MODE_SAVE, 1, NULL);
+    write_header(header, "NESS", total, 0);
+    set_base(m, 0);
+    return total;
+}
+
+// 基准标识是正文的哈希：只有内容完全相同的两份存档才能互换着做基准。0 留给"没有标识"
+static uint64_t base_id(const uint8_t* header, size_t total){
+    uint64_t id = hash64(header + SAVESTATE_HEADER_SIZE, total - SAVESTATE_HEADER_SIZE, 0);
+    return id ? id : 1;
+}
+
+size_t savestate_save_base(Machine* m, void* buf, size_t size){
+    size_t total = savestate_save(m, buf, size);
+    if(!total) return 0;
+    uint64_t id = base_id((const uint8_t*)buf, total);
+    write_u64((uint8_t*)buf + 16, id);
+    set_base(m, id);
+    return total;
+}
+
+int savestate_load(Machine* m, const void* buf, size_t size){
+    const uint8_t* header = (const uint8_t*)buf;
+    if(!check_header(header, size, "NESS") || read_u32(header + 8) != savestate_size(m)) return 0;
+
+    int threaded = restore_begin(m);
+    transfer(m, (uint8_t*)header + SAVESTATE_HEADER_SIZE, MODE_LOAD, 1, NULL);
+    restore_end(m, threaded);
+    set_base(m, read_u64(header + 16));
+    return 1;
+}
+
+size_t savestate_save_sections(Machine* m, void* buf, size_t size, size_t marks[STATE_SECTIONS + 1]){
+    size_t total = transfer(m, NULL, MODE_MEASURE, 1, NULL);
+    if(size < total) return 0;
+    transfer(m, (uint8_t*)buf, MODE_SAVE, 1, marks);
+    return total;
+}
+
+size_t savestate_delta_size(const Machine* m){
+    return SAVESTATE_HEADER_SIZE + transfer((Machine*)m, NULL, MODE_MEASURE, 0, NULL) +
+           popcount16(m->bus.ram_dirty) * RAM_PAGE_SIZE + popcount16(m->bus.prg_ram_dirty) * PRG_RAM_PAGE_SIZE +
+           popcount16(m->ppu.vram_dirty) * PPU_PAGE_SIZE;
+}
+
+size_t savestate_save_delta(const Machine* m, void* buf, size_t size){
+    size_t total = savestate_delta_size(m);
+    if(size < total || !m->state_base) return 0;
+
+    uint8_t* header = (uint8_t*)buf;
+    uint8_t ram_mask = m->bus.ram_dirty;
+    uint8_t prg_ram_mask = m->bus.prg_ram_dirty;
+    uint16_t vram_mask = m->ppu.vram_dirty;
+    write_header(header, "NESD", total, m->state_base);
+    header[12] = ram_mask;
+    header[13] = prg_ram_mask;
+    write_u16(header + 14, vram_mask);
+
+    uint8_t* p = header + SAVESTATE_HEADER_SIZE;
+    p += transfer((Machine*)m, p, MODE_SAVE, 0, NULL);
+    for(int i = 0; i < 8; i++){
+        if(ram_mask & (1 << i)){
+            memcpy(p, m->bus.ram + i * RAM_PAGE_SIZE, RAM_PAGE_SIZE);
+            p += RAM_PAGE_SIZE;
+        }
+    }
+    for(int i = 0; i < 8; i++){
+        if(prg_ram_mask & (1 << i)){
+            memcpy(p, m->bus.prg_ram + i * PRG_RAM_PAGE_SIZE, PRG_RAM_PAGE_SIZE);
+            p += PRG_RAM_PAGE_SIZE;
+        }
+    }
+    for(int i = 0; i < 12; i++){
+        if(vram_mask & (1 << i)){
+            memcpy(p, vram_page((Machine*)m, i), PPU_PAGE_SIZE);
+            p += PPU_PAGE_SIZE;
+        }
+    }
+    return total;
+}
+
+int savestate_load_delta(Machine* m, const void* base, size_t base_size, const void* delta, size_t delta_size){
+    const uint8_t* bh = (const uint8_t*)base;
+    const uint8_t* dh = (const uint8_t*)delta;
+    if(!check_header(bh, base_size, "NESS") || read_u32(bh + 8) != savestate_size(m)) return 0;
+    uint64_t id = read_u64(bh + 16);
+    if(!check_header(dh, delta_size, "NESD") || !id || read_u64(dh + 16) != id) return 0;
+    // 基准的标识要和它的内容对得上，改过的基准不能用；机器已经记着这个基准时就不用再算
+    if(id != m->state_base && base_id(bh, read_u32(bh + 8)) != id) return 0;
+
+    uint8_t ram_mask = dh[12];
+    uint8_t prg_ram_mask = dh[13];
+    uint16_t vram_mask = read_u16(dh + 14) & 0x0FFF;
+    size_t expected = SAVESTATE_HEADER_SIZE + transfer(m, NULL, MODE_MEASURE, 0, NULL) +
+                      popcount16(ram_mask) * RAM_PAGE_SIZE + popcount16(prg_ram_mask) * PRG_RAM_PAGE_SIZE +
+                      popcount16(vram_mask) * PPU_PAGE_SIZE;
+    if(read_u32(dh + 8) != expected) return 0;
+
+    int threaded = restore_begin(m);
+    transfer(m, (uint8_t*)bh + SAVESTATE_HEADER_SIZE, MODE_LOAD, 1, NULL);
+
+    const uint8_t* p = dh + SAVESTATE_HEADER_SIZE;
+    p += transfer(m, (uint8_t*)p, MODE_LOAD, 0, NULL);
+    for(int i = 0; i < 8; i++){
+        if(ram_mask & (1 << i)){
+            memcpy(m->bus.ram + i * RAM_PAGE_SIZE, p, RAM_PAGE_SIZE);
+            p += RAM_PAGE_SIZE;
+        }
+    }
+    for(int i = 0; i < 8; i++){
+        if(prg_ram_mask & (1 << i)){
+            memcpy(m->bus.prg_ram + i * PRG_RAM_PAGE_SIZE, p, PRG_RAM_PAGE_SIZE);
+            p += PRG_RAM_PAGE_SIZE;
+        }
+    }
+    for(int i = 0; i < 12; i++){
+        if(vram_mask & (1 << i)){
+            memcpy(vram_page(m, i), p, PPU_PAGE_SIZE);
+            p += PPU_PAGE_SIZE;
+        }
+    }
+    restore_end(m, threaded);
+
+    // 基准仍然是 base，机器与它相差的正是 delta 里的这些页
+    m->state_base = read_u64(bh + 16);
+    m->bus.ram_dirty = ram_mask;
+    m->bus.prg_ram_dirty = prg_ram_mask;
+    m->ppu.vram_dirty = vram_mask;
+    return 1;
+}
@@ -0,0 +1,83 @@
+// savestate.h
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "machine.h"
+
+// 即时存档：把整台机器（CPU 寄存器、RAM、PPU、APU、Mapper 状态）
+// 序列化进调用方提供的缓冲区，或者从缓冲区恢复。全程不分配内存。
+//
+// 格式（固定布局；文件头是小端，各段按主机字节序直接拷贝）：
+//   0  "NESS"
+//   4  版本号 (uint16, SAVESTATE_VERSION)
+//   6  保留 (uint16)
+//   8  整个存档的字节数 (uint32，含文件头)
+//   12 保留 (uint32)
+//   16 基准标识 (uint64)：savestate_save_base 写正文的哈希，增量存档用它认出自己的基准；
+//      savestate_save 写 0（不算哈希，不能做基准）
+//   24 CPU、总线、PPU、APU、Machine 各段，按 savestate.c 里 transfer() 的顺序紧密排列
+//
+// 不保存的东西：
+//   - CPU 指令内部的临时量（取到的操作数、有效地址、操作码、周期数）：下一条指令开始时重新算出
+//   - 指针（总线、卡带、页表）：恢复后按保存下来的 bank/镜像方式重新连接
+//   - 输出画面 (PpuFrame)：恢复后下一帧渲染完成时自然更新
+//   - 音频合成/重采样的缓冲和采样率等设置：属于输出端，不影响模拟结果
+// 存档在两帧之间（machine_run_frame 返回后）保存和恢复；恢复后模拟结果与保存时逐周期一致。
+//
+// 增量存档：每次完整存档/恢复都成为新的"基准"，之后总线和 PPU 按页记录写入
+// （RAM 按 256 字节页，PRG-RAM、CHR-RAM、CIRAM 按 1KB 页）。增量存档只包含寄存器等小状态
+// 和基准之后被写过的页，大小和耗时只取决于改了多少内存，适合每帧都存一份。
+//   0  "NESD"
+//   4  版本号 (uint16)
+//   6  保留 (uint16)
+//   8  整个增量存档的字节数 (uint32)
+//   12 RAM 页掩码 (uint8)，13 PRG-RAM 页掩码 (uint8)，14 VRAM 页掩码 (uint16，位定义同 PPU.vram_dirty)
+//   16 基准存档的标识 (uint64)：只能叠加在标识相同的完整存档上
+//   24 除 RAM/PRG-RAM/CHR-RAM/CIRAM 以外的全部状态，然后是 RAM、PRG-RAM、VRAM 的页，各自按掩码位顺序排列
+
+#define SAVESTATE_VERSION 8
+#define SAVESTATE_HEADER_SIZE 24
+
+// 存档的字节数：同一个 SAVESTATE_VERSION 下是固定值，与机器当前状态无关
+size_t savestate_size(const Machine* m);
+
+// 保存到 buf，返回写入的字节数；缓冲区不够大时返回 0。
+// 只是定长拷贝（回退、预跑、搜索每帧都在用）；写入追踪从这里重新开始，
+// 但这份存档没有标识，之后要保存增量存档得先 savestate_save_base
+size_t savestate_save(Machine* m, void* buf, size_t size);
+
+// 同 savestate_save，再对正文算一遍哈希作为标识：这份存档成为之后增量存档的基准
+size_t savestate_save_base(Machine* m, void* buf, size_t size);
+
+// 从 buf 恢复，成功返回 1；格式或版本不对时返回 0，机器保持不变。
+// 恢复的存档带标识时（savestate_save_base 保存的）成为之后增量存档的基准
+int savestate_load(Machine* m, const void* buf, size_t size);
+
+// 存档里各段的顺序，也是状态哈希 (statehash.h) 的部件
+enum StateSection{
+    STATE_SECTION_CPU,
+    STATE_SECTION_RAM,      // 主机 RAM、PRG-RAM
+    STATE_SECTION_BUS,      // 主时钟、手柄
+    STATE_SECTION_PPU,      // 寄存器、VRAM、OAM、时序
+    STATE_SECTION_MAPPER,
+    STATE_SECTION_APU,      // CPU 看得到的部分；声道波形在所有部件之后，不算部件
+    STATE_SECTION_MACHINE,  // 录像回放位置、延迟帧计数
+    STATE_SECTIONS
+};
+
+// 只写存档正文（没有文件头，不改变增量存档的基准），marks[i] 是第 i 段的起点，
+// marks[STATE_SECTIONS] 是最后一段的结尾，后面是只影响音频的声道波形状态。返回写入的字节数，缓冲区不够大时返回 0
+size_t savestate_save_sections(Machine* m, void* buf, size_t size, size_t marks[STATE_SECTIONS + 1]);
+
+// 现在保存增量存档需要的字节数（不超过 savestate_size）
+size_t savestate_delta_size(const Machine* m);
+
+// 保存相对基准的增量存档，返回写入的字节数；缓冲区不够大，
+// 或者最近一次完整存档/恢复没有标识（不是基准）时返回 0。
+// 不改变基准：连续保存的增量存档都只依赖同一个基准
+size_t savestate_save_delta(const Machine* m, void* buf, size_t size);
+
+// 先恢复基准 base，再叠加增量 delta，成功返回 1；
+// 两者不配套（delta 不是基于 base 保存的）、base 的内容和标识对不上或格式不对时返回 0，机器保持不变。
+// 机器记录的基准就是这个标识时（刚存过/恢复过它）不再校验 base 的内容
+int savestate_load_delta(Machine* m, const void* base, size_t base_size, const void* delta, size_t delta_size);
@@ -0,0 +1,358 @@
+// search.c
+#include "search.h"
+#include "savestate.h"
+#include "hash.h"
+#include "aligned.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 一个候选状态：父节点在 history 里的位置，这一步的按键，以及线程池算出来的结果
+typedef struct Candidate{
+    int parent;         // 父节点的 history 下标，-1 = 起点
+    uint8_t action;
+    uint8_t goal;
+    int frames;         // 这一步跑了几帧
+    uint64_t hash;      // RAM 的哈希
+    double score;
+} Candidate;
+
+// 走过的路：每个保留下来的节点一条，用来倒推按键序列
+typedef struct Step{
+    int parent;
+    uint8_t action;
+} Step;
+
+typedef struct Search{
+    const SearchConfig* config;
+    size_t state_size;
+    Machine** workers;      // 每个线程一台
+    int worker_count;
+
+    // 当前这一层
+    uint8_t* frontier;      // 每个状态 state_size 字节
+    int* frontier_step;     // 对应的 history 下标
+    int frontier_count;
+
+    // 下一层的候选：第 i 个是 frontier[i / action_count] 按 actions[i % action_count]
+    uint8_t* children;
+    Candidate* candidates;
+    int candidate_count;
+
+    Step* history;
+    int history_count;
+    int history_capacity;
+
+    // 见过的 RAM 哈希：开放寻址，0 表示空位
+    uint64_t* seen;
+    size_t seen_capacity;
+    size_t seen_count;
+
+    // RANDOM：每条序列的按键和达成目标的步数（0 = 没达成）
+    uint8_t* rollout_actions;
+    int* rollout_steps;
+    uint64_t* rollout_frames;
+} Search;
+
+static double now_seconds(void){
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t ram_hash(const Machine* m){
+    uint64_t h = hash64(m->bus.ram, sizeof(m->bus.ram), 0);
+    return h ? h : 1;
+}
+
+// 把哈希插进集合；已经在里面时返回 0
+static int seen_insert(Search* s, uint64_t h){
+    if((s->seen_count + 1) * 2 > s->seen_capacity){
+        size_t capacity = s->seen_capacity ? s->seen_capacity * 2 : 4096;
+        uint64_t* table = (uint64_t*)calloc(capacity, sizeof(uint64_t));
+        if(!table) return 1; // 内存不够就不去重
+        for(size_t i = 0; i < s->seen_capacity; i++){
+            uint64_t v = s->seen[i];
+            if(!v) continue;
+            size_t j = v & (capacity - 1);
+            while(table[j]) j = (j + 1) & (capacity - 1);
+            table[j] = v;
+        }
+        free(s->seen);
+        s->seen = table;
+        s->seen_capacity = capacity;
+    }
+    size_t mask = s->seen_capacity - 1;
+    size_t i = h & mask;
+    while(s->seen[i]){
+        if(s->seen[i] == h) return 0;
+        i = (i + 1) & mask;
+    }
+    s->seen[i] = h;
+    s->seen_count++;
+    return 1;
+}
+
+static int push_step(Search* s, int parent, uint8_t action){
+    if(s->history_count == s->history_capacity){
+        int capacity = s->history_capacity ? s->history_capacity * 2 : 1024;
+        Step* grown = (Step*)realloc(s->history, (size_t)capacity * sizeof(Step));
+        if(!grown) return -1;
+        s->history = grown;
+        s->history_capacity = capacity;
+    }
+    s->history[s->history_count].parent = parent;
+    s->history[s->history_count].action = action;
+    return s->history_count++;
+}
+
+// 从第 step 个节点倒推出按键序列
+static void build_path(Search* s, int step, SearchResult* result){
+    int steps = 0;
+    for(int i = step; i >= 0; i = s->history[i].parent) steps++;
+    result->steps = steps;
+    result->actions = (uint8_t*)malloc(steps > 0 ? (size_t)steps : 1);
+    if(!result->actions) return;
+    for(int i = step, n = steps; i >= 0; i = s->history[i].parent){
+        result->actions[--n] = s->history[i].action;
+    }
+}
+
+// 按住 action 跑一步，返回跑了几帧
+static int run_step(Machine* m, uint8_t action, const SearchConfig* c){
+    machine_set_input(m, 0, action);
+    for(int f = 0; f < c->frames_per_step; f++){
+        machine_run_frame(m);
+    }
+    return c->frames_per_step + machine_skip_lag(m, c->skip_lag);
+}
+
+// 线程池任务：恢复父状态，跑一步，保存子状态并填好候选
+static void expand_one(void* arg, int index, int worker){
+    Search* s = (Search*)arg;
+    const SearchConfig* c = s->config;
+    Machine* m = s->workers[worker];
+    int parent = index / c->action_count;
+    uint8_t action = c->actions[index % c->action_count];
+
+    savestate_load(m, s->frontier + (size_t)parent * s->state_size, s->state_size);
+    int frames = run_step(m, action, c);
+    savestate_save(m, s->children + (size_t)index * s->state_size, s->state_size);
+
+    Candidate* cand = &s->candidates[index];
+    cand->parent = s->frontier_step[parent];
+    cand->action = action;
+    cand->goal = c->goal(c->user, m) != 0;
+    cand->frames = frames;
+    cand->hash = ram_hash(m);
+    cand->score = c->score ? c->score(c->user, m) : 0.0;
+}
+
+// BEAM 排序：分数高的在前，同分按生成顺序
+typedef struct Ranked{
+    double score;
+    int index;
+} Ranked;
+
+static int compare_score(const void* a, const void* b){
+    const Ranked* x = (const Ranked*)a;
+    const Ranked* y = (const Ranked*)b;
+    if(x->score != y->score) return x->score < y->score ? 1 : -1;
+    return x->index - y->index;
+}
+
+static int tree_search(Search* s, ThreadPool* pool, SearchResult* result){
+    const SearchConfig* c = s->config;
+    int width = c->width;
+    size_t max_candidates = (size_t)width * (size_t)c->action_count;
+    s->frontier = (uint8_t*)malloc((size_t)width * s->state_size);
+    s->frontier_step = (int*)malloc((size_t)width * sizeof(int));
+    s->children = (uint8_t*)malloc(max_candidates * s->state_size);
+    s->candidates = (Candidate*)malloc(max_candidates * sizeof(Candidate));
+    Ranked* keep = (Ranked*)malloc(max_candidates * sizeof(Ranked));
+    if(!s->frontier || !s->frontier_step || !s->children || !s->candidates || !keep){
+        free(keep);
+        return 0;
+    }
+
+    // 第 0 层只有起点
+    savestate_save(s->workers[0], s->frontier, s->state_size);
+    s->frontier_step[0] = -1;
+    s->frontier_count = 1;
+    seen_insert(s, ram_hash(s->workers[0]));
+
+    for(int depth = 0; depth < c->max_depth && s->frontier_count > 0; depth++){
+        // 1. 并行展开
+        s->candidate_count = s->frontier_count * c->action_count;
+        if(pool){
+            thread_pool_run(pool, s->candidate_count, expand_one, s);
+        } else {
+            for(int i = 0; i < s->candidate_count; i++){
+                expand_one(s, i, 0);
+            }
+        }
+        result->nodes += (uint64_t)s->candidate_count;
+        for(int i = 0; i < s->candidate_count; i++){
+            result->frames += (uint64_t)s->candidates[i].frames;
+        }
+
+        // 2. 按生成顺序去重、找目标
+        int kept = 0;
+        for(int i = 0; i < s->candidate_count; i++){
+            Candidate* cand = &s->candidates[i];
+            if(cand->goal){
+                int step = push_step(s, cand->parent, cand->action);
+                if(step < 0) break;
+                result->found = 1;
+                build_path(s, step, result);
+                free(keep);
+                return 1;
+            }
+            if(!seen_insert(s, cand->hash)){
+                result->duplicates++;
+                continue;
+            }
+            keep[kept].score = cand->score;
+            keep[kept].index = i;
+            kept++;
+        }
+
+        // 3. 挑出下一层
+        if(c->mode == SEARCH_BEAM){
+            qsort(keep, (size_t)kept, sizeof(Ranked), compare_score);
+        }
+        if(kept > width) kept = width;
+        for(int k = 0; k < kept; k++){
+            int i = keep[k].index;
+            int step = push_step(s, s->candidates[i].parent, s->candidates[i].action);
+            if(step < 0){
+                kept = k;
+                break;
+            }
+            memcpy(s->frontier + (size_t)k * s->state_size, s->children + (size_t)i * s->state_size, s->state_size);
+            s->frontier_step[k] = step;
+        }
+        s->frontier_count = kept;
+    }
+    free(keep);
+    return 1;
+}
+
+static uint64_t splitmix64(uint64_t* x){
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// 线程池任务：从起点跑一条随机序列
+static void rollout_one(void* arg, int index, int worker){
+    Search* s = (Search*)arg;
+    const SearchConfig* c = s->config;
+    Machine* m = s->workers[worker];
+    uint8_t* actions = s->rollout_actions + (size_t)index * c->max_depth;
+    uint64_t rng = c->seed ^ ((uint64_t)index * 0xD1B54A32D192ED03ULL);
+
+    savestate_load(m, s->frontier, s->state_size);
+    s->rollout_steps[index] = 0;
+    s->rollout_frames[index] = 0;
+    for(int d = 0; d < c->max_depth; d++){
+        actions[d] = c->actions[splitmix64(&rng) % (uint64_t)c->action_count];
+        s->rollout_frames[index] += (uint64_t)run_step(m, actions[d], c);
+        if(c->goal(c->user, m)){
+            s->rollout_steps[index] = d + 1;
+            return;
+        }
+    }
+}
+
+static int random_search(Search* s, ThreadPool* pool, SearchResult* result){
+    const SearchConfig* c = s->config;
+    int count = c->width;
+    s->frontier = (uint8_t*)malloc(s->state_size);
+    s->rollout_actions = (uint8_t*)malloc((size_t)count * (size_t)c->max_depth);
+    s->rollout_steps = (int*)malloc((size_t)count * sizeof(int));
+    s->rollout_frames = (uint64_t*)malloc((size_t)count * sizeof(uint64_t));
+    if(!s->frontier || !s->rollout_actions || !s->rollout_steps || !s->rollout_frames) return 0;
+    savestate_save(s->workers[0], s->frontier, s->state_size);
+
+    if(pool){
+        thread_pool_run(pool, count, rollout_one, s);
+    } else {
+        for(int i = 0; i < count; i++){
+            rollout_one(s, i, 0);
+        }
+    }
+
+    // 最短的那条；一样长取编号小的
+    int best = -1;
+    for(int i = 0; i < count; i++){
+        int steps = s->rollout_steps[i];
+        result->nodes += (uint64_t)(steps ? steps : c->max_depth);
+        result->frames += s->rollout_frames[i];
+        if(steps && (best < 0 || steps < s->rollout_steps[best])) best = i;
+    }
+    if(best >= 0){
+        result->found = 1;
+        result->steps = s->rollout_steps[best];
+        result->actions = (uint8_t*)malloc((size_t)result->steps);
+        if(result->actions){
+            memcpy(result->actions, s->rollout_actions + (size_t)best * c->max_depth, (size_t)result->steps);
+        }
+    }
+    return 1;
+}
+
+int search_run(Machine* start, const SearchConfig* config, ThreadPool* pool, SearchResult* result){
+    memset(result, 0, sizeof(*result));
+    const SearchConfig* c = config;
+    if(start->ppu.worker || !c->goal || !c->actions || c->action_count <= 0 || c->frames_per_step < 1 || c->skip_lag < 0 ||
+       c->max_depth < 1 || c->width < 1 || (c->mode == SEARCH_BEAM && !c->score)){
+        return 0;
+    }
+    double t0 = now_seconds();
+
+    // 起点本身就满足
+    if(c->goal(c->user, start)){
+        result->found = 1;
+        result->actions = (uint8_t*)malloc(1);
+        result->seconds = now_seconds() - t0;
+        return 1;
+    }
+
+    Search s;
+    memset(&s, 0, sizeof(s));
+    s.config = c;
+    s.state_size = savestate_size(start);
+    s.worker_count = pool ? thread_pool_size(pool) : 1;
+    s.workers = (Machine**)calloc((size_t)s.worker_count, sizeof(Machine*));
+    int ok = s.workers != NULL;
+    for(int i = 0; ok && i < s.worker_count; i++){
+        s.workers[i] = (Machine*)aligned_calloc(_Alignof(Machine), sizeof(Machine));
+        ok = s.workers[i] && machine_fork(start, s.workers[i]);
+        if(ok) s.workers[i]->ppu.skip_render = 1;
+    }
+
+    if(ok){
+        ok = c->mode == SEARCH_RANDOM ? random_search(&s, pool, result) : tree_search(&s, pool, result);
+    }
+
+    for(int i = 0; s.workers && i < s.worker_count; i++){
+        if(s.workers[i]){
+            machine_release(s.workers[i]);
+            aligned_free(s.workers[i]);
+        }
+    }
+    free(s.workers);
+    free(s.frontier);
+    free(s.frontier_step);
+    free(s.children);
+    free(s.candidates);
+    free(s.history);
+    free(s.seen);
+    free(s.rollout_actions);
+    free(s.rollout_steps);
+    free(s.rollout_frames);
+    result->seconds = now_seconds() - t0;
+    return ok;
+}
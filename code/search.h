@@ -0,0 +1,56 @@
+// search.h
+#pragma once
+#include <stdint.h>
+#include "machine.h"
+#include "thread_pool.h"
+
+// 输入搜索（TAS 找路线、复现 bug）：从一个起始状态出发，每一步从候选按键里选一个按住 frames_per_step 帧，
+// 找到让目标谓词成立的最短（或者评分最高的）输入序列。
+//
+// 状态都存成即时存档 (savestate.h)，不是整台机器：每个线程有一台自己的机器，
+// 一个任务 = 恢复父状态、按一个按键跑一步、检查目标、保存子状态。这一步全在线程池上并行；
+// 按 RAM 的哈希去重、挑选下一层都在调用线程上按固定顺序做，所以结果与线程数无关。
+// 搜索期间不画画面、不合成音频，目标和评分只应该看 RAM 这类 CPU 可见的状态。
+//
+//   BFS:    逐层展开，每层按生成顺序最多保留 width 个状态，找到的是步数最少的序列
+//   BEAM:   逐层展开，每层按 score 从高到低保留 width 个
+//   RANDOM: width 条互相独立的随机序列（种子 seed），取最早达成目标的那条；不去重
+
+enum SearchMode{
+    SEARCH_BFS,
+    SEARCH_BEAM,
+    SEARCH_RANDOM,
+};
+
+// 目标：返回非 0 表示找到了
+typedef int (*SearchGoal)(void* user, const Machine* m);
+// 评分：BEAM 保留分数高的
+typedef double (*SearchScore)(void* user, const Machine* m);
+
+typedef struct SearchConfig{
+    int mode;                   // enum SearchMode
+    const uint8_t* actions;     // 每一步可选的手柄 1 按键
+    int action_count;
+    int frames_per_step;        // 每一步按住多少帧 (>= 1)
+    int skip_lag;               // 之后遇到延迟帧就接着按住，最多再跑几帧 (machine_skip_lag)；0 = 不跳
+    int max_depth;              // 最多多少步
+    int width;                  // 见上面各模式的说明
+    uint64_t seed;              // RANDOM 用
+    SearchGoal goal;
+    SearchScore score;          // BEAM 必须给；其他模式可以为 NULL
+    void* user;
+} SearchConfig;
+
+typedef struct SearchResult{
+    int found;
+    int steps;                  // 找到的序列有多少步
+    uint8_t* actions;           // 每一步的按键（调用方 free）；没找到时为 NULL
+    uint64_t nodes;             // 模拟过的步数（状态数）
+    uint64_t duplicates;        // 因为 RAM 和已经见过的状态相同而丢掉的
+    uint64_t frames;            // 模拟的帧数（包括跳过的延迟帧）
+    double seconds;
+} SearchResult;
+
+// start 处于渲染线程模式、配置不合法或者内存不够时返回 0；否则返回 1，结果在 result 里。
+// start 本身不变（只是被分支过，丢弃之前照常 machine_release）
+int search_run(Machine* start, const SearchConfig* config, ThreadPool* pool, SearchResult* result);
@@ -0,0 +1,160 @@
+// statehash.c
+#include "statehash.h"
+#include "hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct StateHashLog{
+    StateHash* records;
+    int count;
+    int capacity;
+
+    // 存档正文的暂存区，第一次追加时按机器的存档大小分配
+    uint8_t* scratch;
+    size_t scratch_size;
+};
+
+static const char* part_names[STATE_SECTIONS] = {
+    [STATE_SECTION_CPU] = "cpu",
+    [STATE_SECTION_RAM] = "ram",
+    [STATE_SECTION_BUS] = "bus",
+    [STATE_SECTION_PPU] = "ppu",
+    [STATE_SECTION_MAPPER] = "mapper",
+    [STATE_SECTION_APU] = "apu",
+    [STATE_SECTION_MACHINE] = "machine",
+};
+
+static void hash_sections(Machine* m, uint8_t* buf, size_t size, StateHash* out){
+    size_t marks[STATE_SECTIONS + 1];
+    savestate_save_sections(m, buf, size, marks);
+    out->cycles = m->bus.cycles;
+    for(int i = 0; i < STATE_SECTIONS; i++){
+        out->part[i] = hash64(buf + marks[i], marks[i + 1] - marks[i], (uint64_t)i);
+    }
+}
+
+void statehash_compute(Machine* m, StateHash* out){
+    size_t size = savestate_size(m);
+    uint8_t* buf = (uint8_t*)malloc(size);
+    if(!buf){
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    hash_sections(m, buf, size, out);
+    free(buf);
+}
+
+uint64_t statehash_digest(Machine* m){
+    StateHash h;
+    statehash_compute(m, &h);
+    uint64_t digest = h.cycles;
+    for(int i = 0; i < STATE_SECTIONS; i++){
+        digest = hash64_combine(digest, h.part[i]);
+    }
+    return digest;
+}
+
+StateHashLog* statehash_log_create(void){
+    return (StateHashLog*)calloc(1, sizeof(StateHashLog));
+}
+
+void statehash_log_destroy(StateHashLog* log){
+    if(!log) return;
+    free(log->records);
+    free(log->scratch);
+    free(log);
+}
+
+void statehash_log_clear(StateHashLog* log){
+    log->count = 0;
+}
+
+static int reserve(StateHashLog* log, int count){
+    if(count <= log->capacity) return 1;
+    int capacity = log->capacity ? log->capacity : 1024;
+    while(capacity < count) capacity *= 2;
+    StateHash* records = (StateHash*)realloc(log->records, (size_t)capacity * sizeof(StateHash));
+    if(!records) return 0;
+    log->records = records;
+    log->capacity = capacity;
+    return 1;
+}
+
+int statehash_log_append(StateHashLog* log, Machine* m){
+    size_t size = savestate_size(m);
+    if(log->scratch_size < size){
+        uint8_t* scratch = (uint8_t*)realloc(log->scratch, size);
+        if(!scratch) return 0;
+        log->scratch = scratch;
+        log->scratch_size = size;
+    }
+    if(!reserve(log, log->count + 1)) return 0;
+    hash_sections(m, log->scratch, log->scratch_size, &log->records[log->count++]);
+    return 1;
+}
+
+int statehash_log_count(const StateHashLog* log){
+    return log->count;
+}
+
+const StateHash* statehash_log_get(const StateHashLog* log, int frame){
+    if(frame < 0 || frame >= log->count) return NULL;
+    return &log->records[frame];
+}
+
+int statehash_log_save(const StateHashLog* log, const char* path){
+    FILE* fp = fopen(path, "wb");
+    if(!fp) return 0;
+    uint8_t header[STATEHASH_HEADER_SIZE] = { 'N', 'E', 'S', 'H' };
+    header[4] = STATEHASH_VERSION & 0xFF;
+    header[5] = STATEHASH_VERSION >> 8;
+    header[6] = STATE_SECTIONS & 0xFF;
+    header[7] = STATE_SECTIONS >> 8;
+    uint32_t count = (uint32_t)log->count;
+    for(int i = 0; i < 4; i++){
+        header[8 + i] = (uint8_t)(count >> (8 * i));
+    }
+    int ok = fwrite(header, 1, sizeof(header), fp) == sizeof(header) &&
+             fwrite(log->records, sizeof(StateHash), (size_t)log->count, fp) == (size_t)log->count;
+    return (fclose(fp) == 0) && ok;
+}
+
+int statehash_log_load(StateHashLog* log, const char* path){
+    FILE* fp = fopen(path, "rb");
+    if(!fp) return 0;
+    uint8_t header[STATEHASH_HEADER_SIZE];
+    if(fread(header, 1, sizeof(header), fp) != sizeof(header) || memcmp(header, "NESH", 4) != 0 ||
+       (header[4] | header[5] << 8) != STATEHASH_VERSION || (header[6] | header[7] << 8) != STATE_SECTIONS){
+        fclose(fp);
+        return 0;
+    }
+    uint32_t count = (uint32_t)header[8] | (uint32_t)header[9] << 8 |
+                     (uint32_t)header[10] << 16 | (uint32_t)header[11] << 24;
+    int ok = count <= INT32_MAX && reserve(log, (int)count) &&
+             fread(log->records, sizeof(StateHash), count, fp) == count;
+    fclose(fp);
+    log->count = ok ? (int)count : 0;
+    return ok;
+}
+
+int statehash_log_compare(const StateHashLog* a, const StateHashLog* b, int* part){
+    int n = a->count < b->count ? a->count : b->count;
+    for(int f = 0; f < n; f++){
+        const StateHash* x = &a->records[f];
+        const StateHash* y = &b->records[f];
+        for(int i = 0; i < STATE_SECTIONS; i++){
+            if(x->part[i] != y->part[i]){
+                if(part) *part = i;
+                return f;
+            }
+        }
+    }
+    if(part) *part = -1;
+    return a->count == b->count ? -1 : n;
+}
+
+const char* statehash_part_name(int part){
+    if(part < 0 || part >= STATE_SECTIONS) return "length";
+    return part_names[part];
+}
@@ -0,0 +1,54 @@
+// statehash.h
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "savestate.h"
+
+// 逐帧状态哈希：查不同构建、不同线程数、不同执行方式之间的不确定性。
+// 每帧结束时把整台机器按存档的各段 (enum StateSection) 分别做 XXH64，追加到一个日志里；
+// 两份日志一比，就能指出第一次分叉的帧和部件。
+// 哈希的就是存档正文的字节（不含画面和音频输出），一帧大约十几 KB，开销在 1% 以内，批量运行时也可以一直开着。
+// 声道的波形状态不算（关掉音频合成时它不走），所以打开和关闭音频的运行可以直接比较。
+//
+// 日志文件格式（固定布局；文件头是小端，记录按主机字节序直接拷贝）：
+//   0  "NESH"
+//   4  版本号 (uint16, STATEHASH_VERSION)
+//   6  每条记录的部件数 (uint16, STATE_SECTIONS)
+//   8  记录条数 (uint32)
+//   12 保留 (uint32)
+//   16 记录：每帧一条 StateHash，第 f 帧在 16 + f * sizeof(StateHash)
+
+#define STATEHASH_VERSION 1
+#define STATEHASH_HEADER_SIZE 16
+
+typedef struct StateHash{
+    uint64_t cycles;                  // 这一帧结束时的主时钟
+    uint64_t part[STATE_SECTIONS];    // 各部件的哈希
+} StateHash;
+
+typedef struct StateHashLog StateHashLog;
+
+// 当前状态的各部件哈希
+void statehash_compute(Machine* m, StateHash* out);
+// 各部件哈希和主时钟合成一个 64 位摘要：只问两台机器是否一致、不关心哪里不同时用
+uint64_t statehash_digest(Machine* m);
+
+StateHashLog* statehash_log_create(void);
+void statehash_log_destroy(StateHashLog* log);
+void statehash_log_clear(StateHashLog* log);
+
+// 追加 m 当前状态的一条记录（machine_attach_hash_log 之后每帧自动调用），成功返回 1
+int statehash_log_append(StateHashLog* log, Machine* m);
+int statehash_log_count(const StateHashLog* log);
+const StateHash* statehash_log_get(const StateHashLog* log, int frame);
+
+// 写到文件 / 从文件读入（覆盖原有记录），成功返回 1
+int statehash_log_save(const StateHashLog* log, const char* path);
+int statehash_log_load(StateHashLog* log, const char* path);
+
+// 第一次分叉的帧：*part 是那一帧第一个不同的部件 (enum StateSection)。
+// 两份日志完全一致返回 -1；前面都一致只是长度不同时返回较短的那份的条数，*part 为 -1
+int statehash_log_compare(const StateHashLog* a, const StateHashLog* b, int* part);
+
+// 部件名，用于报告
+const char* statehash_part_name(int part);
@@ -0,0 +1,211 @@
+// testrom.c
+#include "testrom.h"
+#include "machine.h"
+#include "aligned.h"
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 收到 0x81 之后等多少帧再复位（约 170ms）
+#define RESET_DELAY_FRAMES 10
+
+static double now_seconds(void){
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const char* base_name(const char* path){
+    const char* name = path;
+    for(const char* p = path; *p; p++){
+        if(*p == '/' || *p == '\\') name = p + 1;
+    }
+    return name;
+}
+
+static int has_signature(const Bus* bus){
+    return bus->prg_ram[1] == 0xDE && bus->prg_ram[2] == 0xB0 && bus->prg_ram[3] == 0x61;
+}
+
+static void read_text(const Bus* bus, char* text){
+    int n = 0;
+    while(n < TESTROM_TEXT_MAX - 1 && 4 + n < BUS_PRG_RAM_SIZE && bus->prg_ram[4 + n]){
+        text[n] = (char)bus->prg_ram[4 + n];
+        n++;
+    }
+    text[n] = '\0';
+}
+
+// 跑到结束或超时
+static void run_machine(Machine* m, int timeout_frames, TestRomResult* out){
+    Bus* bus = &m->bus;
+    int reset_at = -1;
+    out->status = TESTROM_TIMEOUT;
+    for(int f = 0; f < timeout_frames; f++){
+        if(f == reset_at){
+            machine_reset(m);
+            reset_at = -1;
+        }
+        machine_run_frame(m);
+        out->frames = (uint32_t)f + 1;
+
+        if(!has_signature(bus)) continue;
+        out->protocol = 1;
+        uint8_t status = bus->prg_ram[0];
+        if(status == 0x81){
+            if(reset_at < 0) reset_at = f + RESET_DELAY_FRAMES;
+        } else if(status < 0x80){
+            out->code = status;
+            out->status = status == 0 ? TESTROM_PASS : TESTROM_FAIL;
+            break;
+        }
+    }
+    if(out->protocol) read_text(bus, out->text);
+    out->cycles = bus->cycles;
+}
+
+void testrom_run(const char* path, int timeout_frames, TestRomResult* out){
+    memset(out, 0, sizeof(*out));
+    snprintf(out->name, sizeof(out->name), "%s", base_name(path));
+    out->code = -1;
+    double t0 = now_seconds();
+
+    NesRom* rom = load_nes_rom(path);
+    if(!rom){
+        out->status = TESTROM_LOAD_ERROR;
+        return;
+    }
+    if(rom->mapper_id != 0){
+        out->status = TESTROM_UNSUPPORTED;
+        free_nes_rom(rom);
+        return;
+    }
+
+    Machine* m = (Machine*)aligned_calloc(_Alignof(Machine), sizeof(Machine));
+    if(!m){
+        out->status = TESTROM_LOAD_ERROR;
+        free_nes_rom(rom);
+        return;
+    }
+    machine_init(m, rom);
+    machine_set_audio(m, 0);
+    run_machine(m, timeout_frames, out);
+    machine_release(m);
+    aligned_free(m);
+    free_nes_rom(rom);
+    out->seconds = now_seconds() - t0;
+}
+
+typedef struct SuiteJob{
+    char** paths;
+    int timeout_frames;
+    TestRomResult* results;
+} SuiteJob;
+
+static void run_one(void* arg, int index, int worker){
+    (void)worker;
+    SuiteJob* job = (SuiteJob*)arg;
+    testrom_run(job->paths[index], job->timeout_frames, &job->results[index]);
+}
+
+static int is_nes_file(const char* name){
+    size_t n = strlen(name);
+    if(n < 4) return 0;
+    const char* ext = name + n - 4;
+    return ext[0] == '.' && (ext[1] | 0x20) == 'n' && (ext[2] | 0x20) == 'e' && (ext[3] | 0x20) == 's';
+}
+
+static int compare_names(const void* a, const void* b){
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+int testrom_run_dir(ThreadPool* pool, const char* dir, int timeout_frames, TestRomResult** results){
+    *results = NULL;
+    DIR* d = opendir(dir);
+    if(!d) return -1;
+
+    // 1. 收集文件名
+    char** names = NULL;
+    int count = 0, capacity = 0;
+    struct dirent* entry;
+    while((entry = readdir(d)) != NULL){
+        if(!is_nes_file(entry->d_name)) continue;
+        if(count == capacity){
+            capacity = capacity ? capacity * 2 : 16;
+            char** grown = (char**)realloc(names, (size_t)capacity * sizeof(char*));
+            if(!grown) break;
+            names = grown;
+        }
+        size_t len = strlen(dir) + 1 + strlen(entry->d_name) + 1;
+        names[count] = (char*)malloc(len);
+        if(!names[count]) break;
+        snprintf(names[count], len, "%s/%s", dir, entry->d_name);
+        count++;
+    }
+    closedir(d);
+    qsort(names, (size_t)count, sizeof(char*), compare_names);
+
+    // 2. 并行运行，每个 ROM 独占一台机器
+    TestRomResult* out = (TestRomResult*)calloc(count > 0 ? (size_t)count : 1, sizeof(TestRomResult));
+    if(out){
+        SuiteJob job = {names, timeout_frames, out};
+        if(pool){
+            thread_pool_run(pool, count, run_one, &job);
+        } else {
+            for(int i = 0; i < count; i++){
+                run_one(&job, i, 0);
+            }
+        }
+    }
+
+    for(int i = 0; i < count; i++){
+        free(names[i]);
+    }
+    free(names);
+    if(!out) return -1;
+    *results = out;
+    return count;
+}
+
+const char* testrom_status_name(int status){
+    switch(status){
+        case TESTROM_PASS: return "PASS";
+        case TESTROM_FAIL: return "FAIL";
+        case TESTROM_TIMEOUT: return "TIMEOUT";
+        case TESTROM_UNSUPPORTED: return "UNSUPPORTED";
+        case TESTROM_LOAD_ERROR: return "LOAD_ERROR";
+    }
+    return "?";
+}
+
+void testrom_print_matrix(const TestRomResult* results, int count, FILE* out){
+    int totals[TESTROM_LOAD_ERROR + 1] = {0};
+    double wall = 0.0;
+    fprintf(out, "%-11s %4s %7s %12s %9s  %s\n", "status", "code", "frames", "cycles", "ms", "rom");
+    for(int i = 0; i < count; i++){
+        const TestRomResult* r = &results[i];
+        totals[r->status]++;
+        wall += r->seconds;
+
+        // 文字压成一行：换行变空格，去掉首尾空白，太长的截断
+        char line[64];
+        int n = 0;
+        for(const char* t = r->text; *t && n < (int)sizeof(line) - 1; t++){
+            char c = (*t == '\n' || *t == '\r') ? ' ' : *t;
+            if(c == ' ' && (n == 0 || line[n - 1] == ' ')) continue;
+            line[n++] = c;
+        }
+        while(n > 0 && line[n - 1] == ' ') n--;
+        line[n] = '\0';
+
+        char code[12] = "-";
+        if(r->code >= 0) snprintf(code, sizeof(code), "%d", r->code);
+        fprintf(out, "%-11s %4s %7u %12llu %9.1f  %s%s%s\n", testrom_status_name(r->status), code, r->frames,
+                (unsigned long long)r->cycles, r->seconds * 1000.0, r->name,
+                n ? "  " : (r->status == TESTROM_TIMEOUT && !r->protocol ? "  (no $6000 output)" : ""), line);
+    }
+    fprintf(out, "%d roms: %d pass, %d fail, %d timeout, %d unsupported, %d load error; %.1f ms total\n", count,
+            totals[TESTROM_PASS], totals[TESTROM_FAIL], totals[TESTROM_TIMEOUT],
+            totals[TESTROM_UNSUPPORTED], totals[TESTROM_LOAD_ERROR], wall * 1000.0);
+}
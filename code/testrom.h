@@ -0,0 +1,45 @@
+// testrom.h
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include "thread_pool.h"
+
+// 测试 ROM 批量运行：一个目录里的 .nes 全部在线程池上并行跑，按 blargg 测试 ROM 的约定从 PRG-RAM 读结果：
+//   $6001-$6003  DE B0 61，表示下面的内容有效
+//   $6000        状态：0x80 = 还在跑，0x81 = 要求按一下复位键（至少等 100ms），0x00-0x7F = 结束，0 为通过，其他是错误码
+//   $6004        以 0 结尾的说明文字
+// 每帧结束时看一次状态；超过 timeout_frames 帧还没结束就算超时。
+// 目前总线只实现了 Mapper 0，其他 Mapper 的 ROM 直接记为不支持，不运行
+
+enum TestRomStatus{
+    TESTROM_PASS,
+    TESTROM_FAIL,         // 报告了非 0 的结果码
+    TESTROM_TIMEOUT,      // 超时（protocol 为 0 时表示从来没有写过 $6000）
+    TESTROM_UNSUPPORTED,  // Mapper 不支持
+    TESTROM_LOAD_ERROR,   // 读不了或者不是 iNES 文件
+};
+
+#define TESTROM_TEXT_MAX 256
+
+typedef struct TestRomResult{
+    char name[256];                 // 文件名（不含目录）
+    int status;                     // enum TestRomStatus
+    int code;                       // $6000 的结果码，没有时为 -1
+    int protocol;                   // 是否出现过 $6001 的签名
+    char text[TESTROM_TEXT_MAX];    // $6004 的文字
+    uint32_t frames;                // 跑了多少帧
+    uint64_t cycles;                // 跑了多少 CPU 周期
+    double seconds;                 // 墙上时间
+} TestRomResult;
+
+// 跑一个 ROM 文件，结果写进 out（name 取 path 的文件名部分）
+void testrom_run(const char* path, int timeout_frames, TestRomResult* out);
+
+// 目录里所有 .nes 文件（按文件名排序）在 pool 上并行跑；pool 为 NULL 时在调用线程上逐个跑。
+// 成功时 *results 指向 malloc 出来的结果数组（调用方 free），返回 ROM 个数；目录打不开返回 -1
+int testrom_run_dir(ThreadPool* pool, const char* dir, int timeout_frames, TestRomResult** results);
+
+// 输出结果表：每个 ROM 一行（状态、结果码、帧数、周期数、毫秒、文件名、压成一行的文字），最后一行是汇总
+void testrom_print_matrix(const TestRomResult* results, int count, FILE* out);
+
+const char* testrom_status_name(int status);
@@ -0,0 +1,198 @@
+// thread_pool.c
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // pthread_setaffinity_np
+#endif
+#include "thread_pool.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+// 每个线程当前这批任务里自己的那一段：next 会被偷任务的线程一起 fetch_add，单独占一个缓存行
+typedef struct WorkerRange{
+    _Alignas(64) _Atomic int next;
+    int end;
+} WorkerRange;
+
+typedef struct Worker{
+    ThreadPool* pool;
+    int index;
+    pthread_t thread;
+} Worker;
+
+struct ThreadPool{
+    int threads;
+    int pin;
+    Worker* workers;
+    WorkerRange* ranges;   // 按缓存行对齐
+    void* ranges_storage;  // malloc 返回的原始指针
+
+    // 每批任务开始和结束时的同步
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint64_t generation;   // 每发一批任务加 1
+    int running;           // 还没做完这一批的线程数
+    int quit;
+
+    ThreadPoolTask task;
+    void* arg;
+};
+
+int thread_pool_cpu_count(void){
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+static void pin_to_cpu(int index){
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % thread_pool_cpu_count(), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)index;
+#endif
+}
+
+// 从一段里一个一个地取任务，直到取完
+static void drain(WorkerRange* r, ThreadPoolTask task, void* arg, int worker){
+    for(;;){
+        int i = atomic_fetch_add_explicit(&r->next, 1, memory_order_relaxed);
+        if(i >= r->end) return;
+        task(arg, i, worker);
+    }
+}
+
+static void* worker_main(void* p){
+    Worker* self = (Worker*)p;
+    ThreadPool* pool = self->pool;
+    if(pool->pin){
+        pin_to_cpu(self->index);
+    }
+
+    uint64_t seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for(;;){
+        while(pool->generation == seen && !pool->quit){
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if(pool->quit) break;
+        seen = pool->generation;
+        ThreadPoolTask task = pool->task;
+        void* arg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        // 先做自己的那段，再按顺序去别的线程那段里偷
+        drain(&pool->ranges[self->index], task, arg, self->index);
+        for(int k = 1; k < pool->threads; k++){
+            drain(&pool->ranges[(self->index + k) % pool->threads], task, arg, self->index);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        if(--pool->running == 0){
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool* thread_pool_create(int threads, int pin){
+    if(threads <= 0){
+        threads = thread_pool_cpu_count();
+    }
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if(!pool) return NULL;
+    pool->threads = threads;
+    pool->pin = pin;
+    pool->workers = (Worker*)calloc((size_t)threads, sizeof(Worker));
+    pool->ranges_storage = malloc((size_t)threads * sizeof(WorkerRange) + 63);
+    if(!pool->workers || !pool->ranges_storage){
+        free(pool->workers);
+        free(pool->ranges_storage);
+        free(pool);
+        return NULL;
+    }
+    pool->ranges = (WorkerRange*)(((uintptr_t)pool->ranges_storage + 63) & ~(uintptr_t)63);
+    for(int i = 0; i < threads; i++){
+        atomic_init(&pool->ranges[i].next, 0);
+        pool->ranges[i].end = 0;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for(int i = 0; i < threads; i++){
+        Worker* w = &pool->workers[i];
+        w->pool = pool;
+        w->index = i;
+        if(pthread_create(&w->thread, NULL, worker_main, w) != 0){
+            // 已经启动的线程照常退出
+            pool->threads = i;
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void thread_pool_destroy(ThreadPool* pool){
+    if(!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for(int i = 0; i < pool->threads; i++){
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->workers);
+    free(pool->ranges_storage);
+    free(pool);
+}
+
+int thread_pool_size(const ThreadPool* pool){
+    return pool->threads;
+}
+
+void thread_pool_run(ThreadPool* pool, int count, ThreadPoolTask task, void* arg){
+    if(count <= 0) return;
+
+    // 平均切段：前 count % threads 个线程各多分一个
+    int per = count / pool->threads;
+    int extra = count % pool->threads;
+    int begin = 0;
+    for(int i = 0; i < pool->threads; i++){
+        int len = per + (i < extra ? 1 : 0);
+        atomic_store_explicit(&pool->ranges[i].next, begin, memory_order_relaxed);
+        pool->ranges[i].end = begin + len;
+        begin += len;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->running = pool->threads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    while(pool->running > 0){
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
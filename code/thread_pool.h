@@ -0,0 +1,30 @@
+// thread_pool.h
+#pragma once
+
+// 固定大小的线程池，用来把成千上万个互相独立的任务（每台机器跑几帧）摊到所有核上。
+//
+// 每次 thread_pool_run 把 [0, count) 平均切成每个线程一段，线程先从自己那段的开头依次取任务；
+// 做完了就去别的线程那段里偷（同样从开头取，一次一个），所以某些机器跑得慢也不会让整批被最慢的线程拖住。
+// 取任务只是对一个原子计数器做 fetch_add，没有锁；每批任务只有开始和结束时各同步一次。
+//
+// 模拟核心是可重入的（没有全局可变状态），不同线程可以同时运行不同的机器；
+// 同一台机器同一时刻只能在一个线程上运行。
+
+typedef struct ThreadPool ThreadPool;
+
+// 任务函数：index 是任务编号，worker 是执行它的线程编号 (0 .. threads-1)，可用来索引线程私有的数据
+typedef void (*ThreadPoolTask)(void* arg, int index, int worker);
+
+// threads <= 0 时按在线的 CPU 核数创建；pin = 1 时第 n 个线程绑到第 n 个核上（只在 Linux 上生效）。
+// 失败返回 NULL
+ThreadPool* thread_pool_create(int threads, int pin);
+void thread_pool_destroy(ThreadPool* pool);
+
+int thread_pool_size(const ThreadPool* pool);
+
+// 并行执行 task(arg, i, worker)，i = 0 .. count-1；全部完成后才返回。
+// 同一个线程池同一时刻只能有一个调用者
+void thread_pool_run(ThreadPool* pool, int count, ThreadPoolTask task, void* arg);
+
+// 在线的 CPU 核数
+int thread_pool_cpu_count(void);
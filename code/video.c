@@ -0,0 +1,108 @@
+// video.c
+#include "video.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// NES 系统调色板：64 种颜色 (0xRRGGBB)
+static const uint32_t nes_palette[64] = {
+    0x666666, 0x002A88, 0x1412A7, 0x3B00A4, 0x5C007E, 0x6E0040, 0x6C0600, 0x561D00,
+    0x333500, 0x0B4800, 0x005200, 0x004F08, 0x00404D, 0x000000, 0x000000, 0x000000,
+    0xADADAD, 0x155FD9, 0x4240FF, 0x7527FE, 0xA01ACC, 0xB71E7B, 0xB53120, 0x994E00,
+    0x6B6D00, 0x388700, 0x0C9300, 0x008F32, 0x007C8D, 0x000000, 0x000000, 0x000000,
+    0xFFFEFF, 0x64B0FF, 0x9290FF, 0xC676FF, 0xF36AFF, 0xFE6ECC, 0xFE8170, 0xEA9E22,
+    0xBCBE00, 0x88D800, 0x5CE430, 0x45E082, 0x48CDDE, 0x4F4F4F, 0x000000, 0x000000,
+    0xFFFEFF, 0xC0DFFF, 0xD3D2FF, 0xE8C8FF, 0xFBC2FF, 0xFEC4EA, 0xFECCC5, 0xF7D8A5,
+    0xE4E594, 0xCFEF96, 0xBDF4AB, 0xB3F3CC, 0xB5EBF2, 0xB8B8B8, 0x000000, 0x000000,
+};
+
+static uint8_t clamp_u8(int value){
+    if(value < 0) return 0;
+    if(value > 255) return 255;
+    return (uint8_t)value;
+}
+
+void video_palette_init(VideoPalette* pal){
+    for(int e = 0; e < 8; e++){
+        for(int c = 0; c < 64; c++){
+            int r = (nes_palette[c] >> 16) & 0xFF;
+            int g = (nes_palette[c] >> 8) & 0xFF;
+            int b = nes_palette[c] & 0xFF;
+
+            // 颜色强调：被强调的通道保持不变，其余通道衰减到约 81.6%
+            // e 的 bit 0/1/2 分别对应 PPUMASK 的 bit 5/6/7 (红/绿/蓝)
+            if(e & 0x01){ g = g * 209 / 256; b = b * 209 / 256; }
+            if(e & 0x02){ r = r * 209 / 256; b = b * 209 / 256; }
+            if(e & 0x04){ r = r * 209 / 256; g = g * 209 / 256; }
+
+            pal->rgba[e][c] = 0xFF000000u | ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+            pal->rgb565[e][c] = (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+
+            // BT.601 limited range，定点系数放大 256 倍
+            pal->y[e][c] = clamp_u8(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            pal->u[e][c] = clamp_u8(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            pal->v[e][c] = clamp_u8(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+void video_to_rgba(const VideoPalette* pal, const PpuFrame* frame, uint32_t* out, int pitch){
+    for(int line = 0; line < PPU_HEIGHT; line++){
+        const uint32_t* lut = pal->rgba[frame->emphasis[line]];
+        const uint8_t* src = &frame->pixels[line * PPU_WIDTH];
+        uint32_t* dst = &out[line * pitch];
+        int x = 0;
+#if defined(__AVX2__)
+        // 一次查 8 个像素：索引零扩展到 32 位后用 gather 取表
+        for(; x + 8 <= PPU_WIDTH; x += 8){
+            __m128i idx8 = _mm_loadl_epi64((const __m128i*)(src + x));
+            __m256i idx = _mm256_cvtepu8_epi32(idx8);
+            __m256i rgba = _mm256_i32gather_epi32((const int*)lut, idx, 4);
+            _mm256_storeu_si256((__m256i*)(dst + x), rgba);
+        }
+#endif
+        for(; x < PPU_WIDTH; x++){
+            dst[x] = lut[src[x]];
+        }
+    }
+}
+
+void video_to_rgb565(const VideoPalette* pal, const PpuFrame* frame, uint16_t* out, int pitch){
+    for(int line = 0; line < PPU_HEIGHT; line++){
+        const uint16_t* lut = pal->rgb565[frame->emphasis[line]];
+        const uint8_t* src = &frame->pixels[line * PPU_WIDTH];
+        uint16_t* dst = &out[line * pitch];
+        for(int x = 0; x < PPU_WIDTH; x++){
+            dst[x] = lut[src[x]];
+        }
+    }
+}
+
+void video_to_yuv420(const VideoPalette* pal, const PpuFrame* frame, uint8_t* y, uint8_t* u, uint8_t* v){
+    // 1. 亮度：逐行查表
+    for(int line = 0; line < PPU_HEIGHT; line++){
+        const uint8_t* lut = pal->y[frame->emphasis[line]];
+        const uint8_t* src = &frame->pixels[line * PPU_WIDTH];
+        uint8_t* dst = &y[line * PPU_WIDTH];
+        for(int x = 0; x < PPU_WIDTH; x++){
+            dst[x] = lut[src[x]];
+        }
+    }
+
+    // 2. 色度：每 2x2 像素取平均（两行可能有不同的强调位）
+    for(int line = 0; line < PPU_HEIGHT; line += 2){
+        const uint8_t* u0 = pal->u[frame->emphasis[line]];
+        const uint8_t* u1 = pal->u[frame->emphasis[line + 1]];
+        const uint8_t* v0 = pal->v[frame->emphasis[line]];
+        const uint8_t* v1 = pal->v[frame->emphasis[line + 1]];
+        const uint8_t* a = &frame->pixels[line * PPU_WIDTH];
+        const uint8_t* b = a + PPU_WIDTH;
+        uint8_t* du = &u[(line / 2) * (PPU_WIDTH / 2)];
+        uint8_t* dv = &v[(line / 2) * (PPU_WIDTH / 2)];
+        for(int x = 0; x < PPU_WIDTH / 2; x++){
+            int i = x * 2;
+            du[x] = (uint8_t)((u0[a[i]] + u0[a[i + 1]] + u1[b[i]] + u1[b[i + 1]] + 2) >> 2);
+            dv[x] = (uint8_t)((v0[a[i]] + v0[a[i + 1]] + v1[b[i]] + v1[b[i + 1]] + 2) >> 2);
+        }
+    }
+}
@@ -0,0 +1,25 @@
+// video.h
+#pragma once
+#include <stdint.h>
+#include "ppu.h"
+
+// PPU 原生输出是调色板索引 (PpuFrame)，这里是按需调用的颜色转换。
+// 每种格式都预先算好 8 种强调组合 x 64 种颜色的查找表，
+// 转换时按行选出一张 64 项的小表，整行做查表。
+typedef struct VideoPalette{
+    uint32_t rgba[8][64];   // 0xAARRGGBB
+    uint16_t rgb565[8][64];
+    uint8_t y[8][64];       // BT.601 limited range
+    uint8_t u[8][64];
+    uint8_t v[8][64];
+} VideoPalette;
+
+// 用内置的 NES 系统调色板生成全部查找表
+void video_palette_init(VideoPalette* pal);
+
+// pitch 单位都是"像素"，方便直接写进窗口/纹理缓冲
+void video_to_rgba(const VideoPalette* pal, const PpuFrame* frame, uint32_t* out, int pitch);
+void video_to_rgb565(const VideoPalette* pal, const PpuFrame* frame, uint16_t* out, int pitch);
+
+// I420：y 为 256x240，u/v 为 128x120（2x2 取平均）
+void video_to_yuv420(const VideoPalette* pal, const PpuFrame* frame, uint8_t* y, uint8_t* u, uint8_t* v);
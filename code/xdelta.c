@@ -0,0 +1,96 @@
+// xdelta.c
+#include "xdelta.h"
+#include <string.h>
+
+// 短于这个长度的相同段直接并进字面量：单独开一个序列反而更长
+#define MIN_RUN 4
+
+// 从 i 开始 a、b 连续相同的字节数，先按 8 字节比较
+static size_t same_run(const uint8_t* a, const uint8_t* b, size_t i, size_t n){
+    size_t j = i;
+    while(j + 8 <= n){
+        uint64_t x, y;
+        memcpy(&x, a + j, 8);
+        memcpy(&y, b + j, 8);
+        if(x != y) break;
+        j += 8;
+    }
+    while(j < n && a[j] == b[j]) j++;
+    return j - i;
+}
+
+// 长度 >= 15 时 token 里放不下，剩下的部分写成扩展字节
+static uint8_t* put_length(uint8_t* p, size_t len){
+    len -= 15;
+    while(len >= 255){
+        *p++ = 255;
+        len -= 255;
+    }
+    *p++ = (uint8_t)len;
+    return p;
+}
+
+static int get_length(const uint8_t** pp, const uint8_t* end, size_t* len){
+    uint8_t byte;
+    do{
+        if(*pp >= end) return 0;
+        byte = *(*pp)++;
+        *len += byte;
+    }while(byte == 255);
+    return 1;
+}
+
+size_t xdelta_encode(const uint8_t* a, const uint8_t* b, size_t n, uint8_t* out){
+    uint8_t* p = out;
+    size_t i = 0;
+    while(i < n){
+        // 字面量一直延伸到下一个足够长的零段（或者数据末尾）
+        size_t lit_start = i;
+        size_t run = 0;
+        while(i < n){
+            if(a[i] != b[i]){
+                i++;
+                continue;
+            }
+            run = same_run(a, b, i, n);
+            if(run >= MIN_RUN || i + run == n) break;
+            i += run;
+            run = 0;
+        }
+        size_t lit = i - lit_start;
+
+        *p++ = (uint8_t)(((lit < 15 ? lit : 15) << 4) | (run < 15 ? run : 15));
+        if(lit >= 15) p = put_length(p, lit);
+        for(size_t k = 0; k < lit; k++){
+            p[k] = a[lit_start + k] ^ b[lit_start + k];
+        }
+        p += lit;
+        if(run >= 15) p = put_length(p, run);
+        i += run;
+    }
+    return (size_t)(p - out);
+}
+
+int xdelta_apply(uint8_t* dst, size_t n, const uint8_t* in, size_t in_size){
+    const uint8_t* p = in;
+    const uint8_t* end = in + in_size;
+    size_t pos = 0;
+    while(p < end){
+        uint8_t token = *p++;
+        size_t lit = token >> 4;
+        size_t run = token & 0x0F;
+
+        if(lit == 15 && !get_length(&p, end, &lit)) return 0;
+        if(lit > (size_t)(end - p) || lit > n - pos) return 0;
+        for(size_t k = 0; k < lit; k++){
+            dst[pos + k] ^= p[k];
+        }
+        p += lit;
+        pos += lit;
+
+        if(run == 15 && !get_length(&p, end, &run)) return 0;
+        if(run > n - pos) return 0;
+        pos += run;
+    }
+    return pos == n;
+}
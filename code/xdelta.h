@@ -0,0 +1,24 @@
+// xdelta.h
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// 两份等长数据之间的 XOR 差分压缩（倒带、存档历史用）。
+//
+// 相邻两帧的存档 XOR 之后几乎全是 0，所以编码格式仿照 LZ4 的序列，
+// 只是把"匹配"换成了"零段"：
+//   token (1 字节)：高 4 位 = 字面量长度 L，低 4 位 = 零段长度 Z
+//   [L == 15 时的扩展字节：每个 255 继续累加，遇到 < 255 的字节结束]
+//   L 个字面量（a XOR b）
+//   [Z == 15 时的扩展字节]
+// 解码时字面量直接异或进目标、零段直接跳过，所以"还原"和"解压"是同一趟循环。
+
+// n 字节数据编码后的最大长度
+#define XDELTA_BOUND(n) ((n) + (n) / 255 + 16)
+
+// 把 a XOR b（各 n 字节）编码进 out（至少 XDELTA_BOUND(n) 字节），返回编码长度
+size_t xdelta_encode(const uint8_t* a, const uint8_t* b, size_t n, uint8_t* out);
+
+// 把编码后的差分异或进 dst（n 字节）：dst 是 a 就得到 b，是 b 就得到 a。
+// 数据损坏（越界）时返回 0，否则返回 1
+int xdelta_apply(uint8_t* dst, size_t n, const uint8_t* in, size_t in_size);
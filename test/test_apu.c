@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../code/apu.h"
+#include "../code/bus.h"
+#include "../code/ines.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+// 一帧 NTSC 大约 29780 个 CPU 周期
+#define FRAME_CYCLES 29780
+
+// 跑 frames 帧，读出所有采样，返回过零次数（顺便统计最大幅度）
+static int run_and_count_crossings(APU* apu, uint64_t* clock, int frames, int* samples, int* peak) {
+    static int16_t buf[BLIP_CAPACITY];
+    int crossings = 0, total = 0, max = 0;
+    int positive = 0;
+    for (int f = 0; f < frames; f++) {
+        *clock += FRAME_CYCLES;
+        apu_end_frame(apu, *clock);
+        int n = apu_read_samples(apu, buf, BLIP_CAPACITY);
+        for (int i = 0; i < n; i++) {
+            int s = buf[i];
+            if (abs(s) > max) max = abs(s);
+            // 带一点迟滞，台阶边缘的振铃不算过零；跳过开头几帧的高通瞬态
+            int now = s > 256 ? 1 : (s < -256 ? 0 : positive);
+            if (f >= 2 && now != positive) crossings++;
+            positive = now;
+        }
+        total += n;
+    }
+    *samples = total;
+    *peak = max;
+    return crossings;
+}
+
+int main() {
+    printf("=== Starting APU Tests ===\n");
+
+    static APU apu;
+
+    // ---------------------------------------------------------
+    // 测试 1: 长度计数器与 $4015
+    // ---------------------------------------------------------
+    apu_init(&apu, 48000);
+    apu_write_register(&apu, 0x4015, 0x01);
+    apu_write_register(&apu, 0x4000, 0x10);   // 固定音量 0，不暂停长度计数
+    apu_write_register(&apu, 0x4003, 0x18);   // 长度表第 3 项 = 2
+    print_result("Length counter loaded", (apu_read_status(&apu) & 0x01) == 0x01);
+
+    // 4 步模式下第 1、3 步是 1/2 帧时钟：14913 之后还剩 1，29829 之后归零
+    apu_run_to(&apu, 14914);
+    print_result("Length counter after one half frame", apu.pulse[0].length == 1);
+    apu_run_to(&apu, 29830);
+    print_result("Length counter expires", (apu_read_status(&apu) & 0x01) == 0);
+
+    apu_write_register(&apu, 0x4015, 0x00);
+    apu_write_register(&apu, 0x4003, 0x08);
+    print_result("Disabled channel ignores length load", apu.pulse[0].length == 0);
+
+    // ---------------------------------------------------------
+    // 测试 2: 帧 IRQ
+    // ---------------------------------------------------------
+    apu_init(&apu, 48000);
+    print_result("Frame IRQ scheduled at 29829", apu_next_event(&apu) == 29829);
+    apu_run_to(&apu, 29828);
+    print_result("No IRQ before step 4", !apu_irq(&apu));
+    apu_run_to(&apu, 29829);
+    print_result("Frame IRQ raised", apu_irq(&apu));
+    print_result("$4015 reports frame IRQ", (apu_read_status(&apu) & 0x40) == 0x40);
+    print_result("Reading $4015 acknowledges IRQ", !apu_irq(&apu));
+
+    apu_write_register(&apu, 0x4017, 0x40);   // 禁止 IRQ
+    print_result("Inhibited frame counter has no deadline", apu_next_event(&apu) == UINT64_MAX);
+    apu_run_to(&apu, 29830 * 3);
+    print_result("Inhibited frame counter raises no IRQ", !apu_irq(&apu));
+
+    // ---------------------------------------------------------
+    // 测试 3: DMC 取样、周期挪用和 IRQ（需要卡带提供采样数据）
+    // ---------------------------------------------------------
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("[\033[33mSKIP\033[0m] DMC Test (Could not load test/nestest.nes)\n");
+    } else {
+        static Bus bus;
+        bus_init(&bus, rom);
+        apu_init(&apu, 48000);
+        bus_connect_apu(&bus, &apu);
+
+        bus_write(&bus, 0x4017, 0x40);
+        bus_write(&bus, 0x4010, 0x8F);   // IRQ 使能，最快速率 (54 周期/位)
+        bus_write(&bus, 0x4013, 0x01);   // 17 字节
+        uint64_t before = bus.cycles;
+        bus_write(&bus, 0x4015, 0x10);
+        print_result("DMC fetches first byte on enable", bus.cycles == before + 4 && apu.dmc.remaining == 16);
+        print_result("DMC status bit set", (bus_read(&bus, 0x4015) & 0x10) == 0x10);
+
+        // 只在截止时间同步，看 IRQ 是否按时到达
+        int syncs = 0;
+        while (!apu_irq(&apu) && syncs < 100) {
+            bus.cycles = bus.apu_deadline;
+            bus_sync_apu(&bus);
+            syncs++;
+        }
+        printf("       DMC finished after %d deadline syncs, %llu cycles\n",
+               syncs, (unsigned long long)(bus.cycles - before));
+        print_result("DMC IRQ after the last byte", apu_irq(&apu) && apu.dmc.remaining == 0);
+        print_result("One deadline per fetched byte", syncs == 16);
+        print_result("$4015 reports DMC IRQ", (bus_read(&bus, 0x4015) & 0x90) == 0x80);
+        bus_write(&bus, 0x4015, 0x00);
+        print_result("Writing $4015 acknowledges DMC IRQ", !apu_irq(&apu));
+    }
+
+    // ---------------------------------------------------------
+    // 测试 3b: 无声模式与完整模式的 CPU 可见行为逐周期一致
+    // ---------------------------------------------------------
+    if (rom) {
+        static Bus buses[2];
+        static APU apus[2];
+        int mismatches = 0;
+        int irq_count[2] = {0, 0};
+
+        for (int i = 0; i < 2; i++) {
+            bus_init(&buses[i], rom);
+            apu_init(&apus[i], 48000);
+            apu_set_audio(&apus[i], i == 0);
+            bus_connect_apu(&buses[i], &apus[i]);
+        }
+
+        // 同一段"程序"：各声道装长度，DMC 循环播放，帧 IRQ 打开；
+        // 每隔 997 个周期写一个寄存器 / 读一次 $4015
+        static const uint16_t regs[] = {0x4015, 0x4000, 0x4003, 0x4004, 0x4007, 0x4008, 0x400B,
+                                        0x400C, 0x400F, 0x4010, 0x4012, 0x4013, 0x4015, 0x4017};
+        static const uint8_t values[] = {0x1F, 0x1F, 0x48, 0x9F, 0x30, 0x20, 0x58,
+                                         0x1F, 0x70, 0x4C, 0x10, 0x03, 0x1F, 0x00};
+        const int nregs = sizeof(regs) / sizeof(regs[0]);
+        for (int step = 0; step < 1200; step++) {
+            for (int i = 0; i < 2; i++) {
+                Bus* b = &buses[i];
+                b->cycles += 997;
+                if (step < nregs) bus_write(b, regs[step], values[step]);
+                // 中途关掉 DMC 循环，让它放完最后一轮并产生 IRQ
+                if (step == 600) bus_write(b, 0x4010, 0x8C);
+                bus_sync_apu(b);
+                if (apu_irq(&apus[i])) irq_count[i]++;
+            }
+            uint8_t s0 = bus_read(&buses[0], 0x4015);
+            uint8_t s1 = bus_read(&buses[1], 0x4015);
+            if (s0 != s1 || buses[0].cycles != buses[1].cycles || apus[0].dmc.remaining != apus[1].dmc.remaining) {
+                mismatches++;
+            }
+        }
+        uint64_t stolen = buses[0].cycles - 1200 * 997;
+        printf("       audio on/off: %d mismatches, %llu stolen cycles, %d IRQ polls\n",
+               mismatches, (unsigned long long)stolen, irq_count[0]);
+        print_result("Audio-off mode matches CPU-visible state", mismatches == 0 && stolen > 0);
+        print_result("Audio-off mode sees the same IRQs", irq_count[0] == irq_count[1] && irq_count[0] > 0);
+        print_result("Audio-off mode synthesizes nothing", apus[1].blip.avail == 0 && apus[1].noise.lfsr == 1);
+    }
+
+    // ---------------------------------------------------------
+    // 测试 4: 音频输出
+    // ---------------------------------------------------------
+    uint64_t clock = 0;
+    int samples, peak;
+
+    apu_init(&apu, 48000);
+    run_and_count_crossings(&apu, &clock, 10, &samples, &peak);
+    print_result("Silence stays silent", peak == 0);
+    printf("       %d samples for 10 frames at 48000 Hz\n", samples);
+    // 重采样滤波器有半个窗口的延迟，开头少出这么多采样
+    print_result("Sample count matches 48 kHz",
+                 abs(samples - (int)(10.0 * FRAME_CYCLES * 48000 / APU_CLOCK_RATE)) <= RESAMPLER_MAX_TAPS / 2);
+
+    // 方波 440Hz：周期寄存器 = 1789773 / (16 * 440) - 1 = 253
+    apu_init(&apu, 44100);
+    clock = 0;
+    apu_write_register(&apu, 0x4015, 0x01);
+    apu_write_register(&apu, 0x4000, 0xBF);   // 50% 占空比，暂停长度，固定音量 15
+    apu_write_register(&apu, 0x4002, 253 & 0xFF);
+    apu_write_register(&apu, 0x4003, 253 >> 8);
+    int crossings = run_and_count_crossings(&apu, &clock, 62, &samples, &peak);
+    // 60 帧 ≈ 0.998 秒，440Hz 每秒过零 880 次
+    printf("       pulse: %d crossings, peak %d\n", crossings, peak);
+    print_result("Pulse tone has the right pitch", crossings > 860 && crossings < 900);
+    print_result("Pulse tone is loud but not clipped", peak > 1000 && peak < 32767);
+
+    // 三角波同样的频率：周期寄存器 = 1789773 / (32 * 440) - 1 = 126
+    apu_init(&apu, 44100);
+    clock = 0;
+    apu_write_register(&apu, 0x4015, 0x04);
+    apu_write_register(&apu, 0x4008, 0xFF);
+    apu_write_register(&apu, 0x400A, 126);
+    apu_write_register(&apu, 0x400B, 0x00);
+    crossings = run_and_count_crossings(&apu, &clock, 62, &samples, &peak);
+    printf("       triangle: %d crossings, peak %d\n", crossings, peak);
+    print_result("Triangle tone has the right pitch", crossings > 860 && crossings < 900);
+
+    // ---------------------------------------------------------
+    // 测试 5: 重采样质量与动态微调
+    // ---------------------------------------------------------
+    static const char* quality_names[3] = {"fast", "medium", "best"};
+    for (int q = RESAMPLE_FAST; q <= RESAMPLE_BEST; q++) {
+        apu_init(&apu, 44100);
+        apu_set_resample_quality(&apu, q);
+        clock = 0;
+        apu_write_register(&apu, 0x4015, 0x01);
+        apu_write_register(&apu, 0x4000, 0xBF);
+        apu_write_register(&apu, 0x4002, 253 & 0xFF);
+        apu_write_register(&apu, 0x4003, 253 >> 8);
+        crossings = run_and_count_crossings(&apu, &clock, 62, &samples, &peak);
+        printf("       %s: %d crossings, %d samples, peak %d\n", quality_names[q], crossings, samples, peak);
+        print_result("Every quality level keeps the pitch", crossings > 860 && crossings < 900 && peak > 1000);
+    }
+
+    // +0.5% / -0.5%：每秒多出或少出约 240 个采样
+    int counts[3];
+    double ratios[3] = {1.0, 1.005, 0.995};
+    for (int i = 0; i < 3; i++) {
+        apu_init(&apu, 48000);
+        apu_set_rate_adjust(&apu, ratios[i]);
+        clock = 0;
+        run_and_count_crossings(&apu, &clock, 60, &counts[i], &peak);
+    }
+    printf("       60 frames: %d / %d / %d samples\n", counts[0], counts[1], counts[2]);
+    print_result("Rate adjust +0.5%", abs(counts[1] - (int)(counts[0] * 1.005)) <= 2);
+    print_result("Rate adjust -0.5%", abs(counts[2] - (int)(counts[0] * 0.995)) <= 2);
+
+    apu_set_rate_adjust(&apu, 1.5);
+    print_result("Rate adjust is clamped", apu.resampler.adjust == 1.0 + RESAMPLER_MAX_ADJUST);
+
+    printf("=== All Tests Completed ===\n");
+    return 0;
+}
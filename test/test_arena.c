@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../code/arena.h"
+#include "../code/hash.h"
+#include "../code/statehash.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+#define CAPACITY 64
+
+// nestest 菜单：第 60-61 帧按 Start 运行第一组测试
+static void run_frames(Machine* m, int count) {
+    for (int f = 0; f < count; f++) {
+        machine_set_input(m, 0, (f == 60 || f == 61) ? 0x08 : 0x00);
+        machine_run_frame(m);
+    }
+}
+
+// 模拟状态的指纹：存档里的全部状态（状态哈希）+ 画面
+static uint64_t state_fingerprint(Machine* m) {
+    return hash64_combine(statehash_digest(m), machine_frame(m)->hash);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main() {
+    printf("=== Starting Arena Tests ===\n");
+
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+
+    // ---------------------------------------------------------
+    // 测试 1: 槽位分配
+    // ---------------------------------------------------------
+    MachineArena* arena = arena_create(rom, CAPACITY, ARENA_HUGE_PAGES);
+    print_result("Create arena", arena != NULL && arena_capacity(arena) == CAPACITY && arena_used(arena) == 0);
+    printf("  huge pages: %s\n", arena_huge_pages(arena) ? "yes" : "no");
+
+    Machine* ms[CAPACITY];
+    int aligned = 1, distinct = 1;
+    for (int i = 0; i < CAPACITY; i++) {
+        ms[i] = arena_alloc(arena);
+        aligned &= ms[i] != NULL && ((uintptr_t)ms[i] % 64) == 0;
+        if (i > 0) distinct &= (uint8_t*)ms[i] >= (uint8_t*)ms[i - 1] + sizeof(Machine);
+    }
+    print_result("Slots are cache-line aligned", aligned);
+    print_result("Slots do not overlap", distinct);
+    print_result("Full arena refuses more", arena_alloc(arena) == NULL && arena_used(arena) == CAPACITY);
+
+    Machine* freed = ms[10];
+    arena_free(arena, freed);
+    ms[10] = arena_alloc(arena);
+    print_result("Freed slot is reused", ms[10] == freed && arena_used(arena) == CAPACITY);
+
+    // ---------------------------------------------------------
+    // 测试 2: 池里的机器和 machine_init 出来的机器跑出一样的结果
+    // ---------------------------------------------------------
+    static Machine reference;
+    machine_init(&reference, rom);
+    machine_set_audio(&reference, 0);
+    run_frames(&reference, 90);
+    uint64_t expected = state_fingerprint(&reference);
+
+    run_frames(ms[0], 90);
+    run_frames(ms[1], 90);
+    print_result("Arena machine matches machine_init", state_fingerprint(ms[0]) == expected);
+    print_result("Machines do not disturb each other", state_fingerprint(ms[1]) == expected);
+
+    // 复位回到上电状态，再跑一遍还是同样的结果
+    arena_reset(arena, ms[0]);
+    print_result("Reset restores power-on state", ms[0]->bus.cycles == ms[2]->bus.cycles &&
+                 memcmp(ms[0]->bus.ram, ms[2]->bus.ram, sizeof(ms[0]->bus.ram)) == 0);
+    run_frames(ms[0], 90);
+    print_result("Reset machine runs the same timeline", state_fingerprint(ms[0]) == expected);
+
+    // ---------------------------------------------------------
+    // 测试 3: 复位的代价
+    // ---------------------------------------------------------
+    const int rounds = 20000;
+    double t0 = now_seconds();
+    for (int i = 0; i < rounds; i++) {
+        arena_reset(arena, ms[i % CAPACITY]);
+    }
+    double t1 = now_seconds();
+    for (int i = 0; i < rounds / 10; i++) {
+        machine_init(&reference, rom);
+    }
+    double t2 = now_seconds();
+    // 时间只打印，机器忙或者开了 sanitizer 时没有意义
+    printf("  arena_reset %.0f ns, machine_init %.0f ns\n", (t1 - t0) / rounds * 1e9, (t2 - t1) / (rounds / 10) * 1e9);
+    // 分出来的机器跑完第一帧之前画面无效 (machine_fork)，只比较模拟状态
+    print_result("Repeated resets still match machine_init", statehash_digest(ms[0]) == statehash_digest(&reference));
+
+    arena_destroy(arena);
+    free_nes_rom(rom);
+    printf("=== All Arena Tests Passed ===\n");
+    return 0;
+}
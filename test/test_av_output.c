@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "../code/av_output.h"
+#include "../code/machine.h"
+#include "../code/hash.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+// 消费者线程：按顺序取画面，检查帧号递增、内容完整（重新算一遍哈希）
+typedef struct Consumer {
+    AvOutput* out;
+    atomic_int done;
+    int frames;
+    int audio_blocks;
+    long samples;
+    int out_of_order;
+    int corrupted;
+} Consumer;
+
+// 和 PPU 渲染时一样逐行重算整帧哈希，槽位被生产者中途改写的话对不上
+static uint64_t frame_content_hash(const PpuFrame* frame) {
+    uint64_t h = 0;
+    for (int line = 0; line < PPU_HEIGHT; line++) {
+        h = hash64_combine(h, hash64(&frame->pixels[line * PPU_WIDTH], PPU_WIDTH, frame->emphasis[line]));
+    }
+    return h;
+}
+
+static void* consumer_main(void* arg) {
+    Consumer* c = (Consumer*)arg;
+    uint64_t last = 0;
+    int first = 1;
+    for (;;) {
+        int idle = 1;
+        const AvVideoBlock* v = av_output_peek_video(c->out);
+        if (v) {
+            if (!first && v->frame_number <= last) c->out_of_order++;
+            if (frame_content_hash(&v->frame) != v->frame.hash) c->corrupted++;
+            last = v->frame_number;
+            first = 0;
+            c->frames++;
+            av_output_release_video(c->out);
+            idle = 0;
+        }
+        const AvAudioBlock* a = av_output_peek_audio(c->out);
+        if (a) {
+            c->samples += a->count;
+            c->audio_blocks++;
+            av_output_release_audio(c->out);
+            idle = 0;
+        }
+        if (idle) {
+            if (atomic_load(&c->done)) break;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    printf("=== Starting AV Output Tests ===\n");
+
+    // ---------------------------------------------------------
+    // 测试 1: 单线程下的队列语义
+    // ---------------------------------------------------------
+    AvOutput* out = av_output_create(3, 2);   // 视频 3 -> 4 个槽位
+    print_result("Create output queues", out != NULL);
+    print_result("Empty queue has nothing to read", av_output_peek_video(out) == NULL);
+
+    for (int i = 0; i < 4; i++) {
+        AvVideoBlock* v = av_output_video_slot(out);
+        if (!v) break;
+        v->frame_number = i;
+        av_output_commit_video(out);
+    }
+    print_result("Full queue refuses a fifth frame", av_output_video_slot(out) == NULL);
+    print_result("Dropped frame is counted", av_output_dropped_video(out) == 1);
+
+    int in_order = 1;
+    for (int i = 0; i < 4; i++) {
+        const AvVideoBlock* v = av_output_peek_video(out);
+        if (!v || v->frame_number != (uint64_t)i) in_order = 0;
+        av_output_release_video(out);
+    }
+    print_result("Frames come out in order", in_order && av_output_peek_video(out) == NULL);
+    print_result("Slot is free again after release", av_output_video_slot(out) != NULL);
+    av_output_destroy(out);
+
+    // ---------------------------------------------------------
+    // 测试 2: 模拟线程发布，消费者线程并发读取
+    // ---------------------------------------------------------
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("[\033[33mSKIP\033[0m] Threaded Test (Could not load test/nestest.nes)\n");
+    } else {
+        static Machine m;
+        machine_init(&m, rom);
+        out = av_output_create(4, 8);
+        machine_attach_output(&m, out);
+
+        Consumer c;
+        memset(&c, 0, sizeof(c));
+        c.out = out;
+        pthread_t th;
+        pthread_create(&th, NULL, consumer_main, &c);
+
+        const int frames = 300;
+        for (int f = 0; f < frames; f++) {
+            machine_run_frame(&m);
+        }
+        atomic_store(&c.done, 1);
+        pthread_join(th, NULL);
+
+        uint64_t dropped = av_output_dropped_video(out);
+        printf("       %d frames published, %d received, %llu dropped, %ld samples\n",
+               frames, c.frames, (unsigned long long)dropped, c.samples);
+        print_result("Every frame is either received or counted as dropped",
+                     c.frames + (int)dropped == frames);
+        print_result("Frames arrive in order", c.out_of_order == 0);
+        print_result("Frames arrive intact", c.corrupted == 0);
+        print_result("Audio blocks arrive", c.audio_blocks > 0 && c.samples > 0);
+
+        machine_attach_output(&m, NULL);
+        av_output_destroy(out);
+    }
+
+    printf("=== All Tests Completed ===\n");
+    return 0;
+}
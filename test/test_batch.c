@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "../code/batch.h"
+#include "../code/hash.h"
+#include "../code/aligned.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+#define MACHINES 24
+#define TASKS 1001
+
+static atomic_int hits[TASKS];
+static atomic_int bad_worker;
+
+static void count_task(void* arg, int index, int worker) {
+    int threads = *(int*)arg;
+    if (worker < 0 || worker >= threads) atomic_store(&bad_worker, 1);
+    atomic_fetch_add(&hits[index], 1);
+}
+
+// 模拟状态 + 画面的指纹
+static uint64_t fingerprint(Machine* m) {
+    uint64_t h = hash64(m->bus.ram, sizeof(m->bus.ram), 0);
+    h = hash64_combine(h, m->bus.cycles);
+    return hash64_combine(h, machine_frame(m)->hash);
+}
+
+// 同一组输入：先跑 70 帧，奇数号机器按 2 帧 Start（开始 nestest 的测试），再跑 60 帧
+static void set_all_input(Machine** ms, int count, int press) {
+    for (int i = 0; i < count; i++) {
+        machine_set_input(ms[i], 0, (press && (i & 1)) ? 0x08 : 0x00);
+    }
+}
+
+static void run_script(ThreadPool* pool, Machine** ms, int count) {
+    set_all_input(ms, count, 0);
+    batch_run_frames(pool, ms, count, 70);
+    set_all_input(ms, count, 1);
+    batch_run_frames(pool, ms, count, 2);
+    set_all_input(ms, count, 0);
+    batch_run_frames(pool, ms, count, 60);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main() {
+    printf("=== Starting Batch Tests ===\n");
+
+    // ---------------------------------------------------------
+    // 测试 1: 线程池把每个任务恰好执行一次
+    // ---------------------------------------------------------
+    int threads = 4;
+    ThreadPool* pool = thread_pool_create(threads, 1);
+    print_result("Create pool", pool != NULL && thread_pool_size(pool) == threads);
+    for (int round = 0; round < 3; round++) {
+        thread_pool_run(pool, TASKS, count_task, &threads);
+    }
+    int exact = 1;
+    for (int i = 0; i < TASKS; i++) exact &= atomic_load(&hits[i]) == 3;
+    print_result("Every task runs exactly once per batch", exact);
+    print_result("Worker ids are in range", !atomic_load(&bad_worker));
+    thread_pool_run(pool, 0, count_task, &threads);
+    print_result("Empty batch returns", 1);
+
+    // ---------------------------------------------------------
+    // 测试 2: 多台机器并行跑，结果和逐台顺序跑完全一致（核心可重入）
+    // ---------------------------------------------------------
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+    Machine* par[MACHINES];
+    Machine* seq[MACHINES];
+    for (int i = 0; i < MACHINES; i++) {
+        par[i] = (Machine*)aligned_calloc(_Alignof(Machine), sizeof(Machine));
+        seq[i] = (Machine*)aligned_calloc(_Alignof(Machine), sizeof(Machine));
+        machine_init(par[i], rom);
+        machine_init(seq[i], rom);
+        machine_set_audio(par[i], 0);
+        machine_set_audio(seq[i], 0);
+    }
+    ThreadPool* single = thread_pool_create(1, 0);
+    run_script(pool, par, MACHINES);
+    run_script(single, seq, MACHINES);
+
+    int same = 1;
+    for (int i = 0; i < MACHINES; i++) same &= fingerprint(par[i]) == fingerprint(seq[i]);
+    print_result("Parallel run matches sequential run", same);
+    print_result("Machines with different input diverge", fingerprint(par[0]) != fingerprint(par[1]) &&
+                 fingerprint(par[0]) == fingerprint(par[2]));
+
+    // ---------------------------------------------------------
+    // 测试 3: 从同一台机器分出去的机器在不同线程上跑（共享写时复制页）
+    // ---------------------------------------------------------
+    for (int i = 0; i < MACHINES; i++) {
+        machine_release(par[i]);
+        machine_fork(seq[1], par[i]);
+        machine_set_input(par[i], 0, (i % 3) ? 0x20 : 0x00); // 有的按下，有的不按
+    }
+    batch_run_frames(pool, par, MACHINES, 30);
+    int forks_ok = 1;
+    for (int i = 3; i < MACHINES; i++) {
+        forks_ok &= fingerprint(par[i]) == fingerprint(par[i % 3]);
+    }
+    print_result("Forked machines run independently across threads", forks_ok);
+    print_result("Forks with different input diverge", fingerprint(par[0]) != fingerprint(par[1]));
+
+    // ---------------------------------------------------------
+    // 测试 4: 吞吐量
+    // ---------------------------------------------------------
+    double t0 = now_seconds();
+    batch_run_frames(single, par, MACHINES, 20);
+    double t1 = now_seconds();
+    batch_run_frames(pool, par, MACHINES, 20);
+    double t2 = now_seconds();
+    printf("  %d CPUs: 1 thread %.0f fps, %d threads %.0f fps\n", thread_pool_cpu_count(),
+           MACHINES * 20 / (t1 - t0), threads, MACHINES * 20 / (t2 - t1));
+
+    for (int i = 0; i < MACHINES; i++) {
+        machine_release(par[i]);
+        machine_release(seq[i]);
+        aligned_free(par[i]);
+        aligned_free(seq[i]);
+    }
+    thread_pool_destroy(single);
+    thread_pool_destroy(pool);
+    free_nes_rom(rom);
+    printf("=== All Batch Tests Passed ===\n");
+    return 0;
+}
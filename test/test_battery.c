@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../code/battery.h"
+#include "../code/machine.h"
+#include "../code/savestate.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 直接从文件读回来，不经过映射
+static int read_file(const char* path, uint8_t* out, size_t size) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return -1;
+    size_t n = fread(out, 1, size, fp);
+    fclose(fp);
+    return (int)n;
+}
+
+static uint8_t file[BUS_PRG_RAM_SIZE];
+
+int main() {
+    printf("=== Starting Battery Save Tests ===\n");
+
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+    print_result("Battery flag comes from flags6 bit 1",
+                 battery_present(rom) == ((rom->header.flags6 & 0x02) != 0));
+
+    char path[64], tmpl[64];
+    snprintf(path, sizeof(path), "/tmp/test_battery_%d.sav", (int)getpid());
+    snprintf(tmpl, sizeof(tmpl), "/tmp/test_battery_%d_template.sav", (int)getpid());
+    remove(path);
+
+    // ---------------------------------------------------------
+    // 测试 1: 共享映射，游戏的写入直接落在文件上
+    // ---------------------------------------------------------
+    static Machine m;
+    machine_init(&m, rom);
+    Battery* battery = battery_open(path, BATTERY_SHARED);
+    print_result("Create a new save file", battery != NULL && read_file(path, file, sizeof(file)) == BUS_PRG_RAM_SIZE);
+    machine_attach_battery(&m, battery);
+    print_result("PRG-RAM points at the mapping", m.bus.prg_ram == battery_data(battery) &&
+                 bus_read(&m.bus, 0x6000) == 0);
+
+    bus_write(&m.bus, 0x6000, 0x12);
+    bus_write(&m.bus, 0x7FFF, 0x34);
+    print_result("Writes reach the file without serialising",
+                 read_file(path, file, sizeof(file)) == BUS_PRG_RAM_SIZE && file[0] == 0x12 && file[0x1FFF] == 0x34);
+    print_result("Sync to disk", battery_sync(battery, 1));
+
+    for (int f = 0; f < 10; f++) machine_run_frame(&m);
+    print_result("Machine runs with a battery attached", bus_read(&m.bus, 0x6000) == 0x12);
+
+    // 分支出来的机器拿到拷贝，不碰存档
+    static Machine child;
+    machine_fork(&m, &child);
+    bus_write(&child.bus, 0x6000, 0x99);
+    print_result("Forked machine gets a private copy",
+                 child.bus.prg_ram == child.bus.prg_ram_store && child.battery == NULL &&
+                 bus_read(&child.bus, 0x7FFF) == 0x34 && bus_read(&m.bus, 0x6000) == 0x12);
+    machine_release(&child);
+
+    // 存档恢复会改写 PRG-RAM，也就改写了文件
+    size_t size = savestate_size(&m);
+    uint8_t* state = (uint8_t*)malloc(size);
+    savestate_save(&m, state, size);
+    bus_write(&m.bus, 0x6000, 0x56);
+    savestate_load(&m, state, size);
+    print_result("Savestate restores PRG-RAM through the mapping",
+                 read_file(path, file, sizeof(file)) == BUS_PRG_RAM_SIZE && file[0] == 0x12);
+    free(state);
+
+    machine_attach_battery(&m, NULL);
+    print_result("Detach copies the contents back", m.bus.prg_ram == m.bus.prg_ram_store &&
+                 bus_read(&m.bus, 0x6000) == 0x12 && m.bus.prg_ram_dirty == 0xFF);
+    battery_close(battery);
+
+    // 重新上电、重新挂上：存档还在
+    machine_init(&m, rom);
+    battery = battery_open(path, BATTERY_SHARED);
+    machine_attach_battery(&m, battery);
+    print_result("Save survives reopening", bus_read(&m.bus, 0x6000) == 0x12 && bus_read(&m.bus, 0x7FFF) == 0x34);
+    machine_attach_battery(&m, NULL);
+    battery_close(battery);
+
+    // ---------------------------------------------------------
+    // 测试 2: 私有映射模板存档，很多实例各写各的，回退到模板
+    // ---------------------------------------------------------
+    for (int i = 0; i < BUS_PRG_RAM_SIZE; i++) file[i] = (uint8_t)(i * 7);
+    FILE* fp = fopen(tmpl, "wb");
+    fwrite(file, 1, sizeof(file), fp);
+    fclose(fp);
+
+    static Machine a, b;
+    machine_init(&a, rom);
+    machine_init(&b, rom);
+    Battery* ba = battery_open(tmpl, BATTERY_PRIVATE);
+    Battery* bb = battery_open(tmpl, BATTERY_PRIVATE);
+    machine_attach_battery(&a, ba);
+    machine_attach_battery(&b, bb);
+    print_result("Instances start from the template", bus_read(&a.bus, 0x6003) == 21 && bus_read(&b.bus, 0x6003) == 21);
+    bus_write(&a.bus, 0x6003, 0xAA);
+    bus_write(&b.bus, 0x6003, 0xBB);
+    uint8_t check[BUS_PRG_RAM_SIZE];
+    print_result("Private writes stay private", bus_read(&a.bus, 0x6003) == 0xAA && bus_read(&b.bus, 0x6003) == 0xBB &&
+                 read_file(tmpl, check, sizeof(check)) == BUS_PRG_RAM_SIZE && check[3] == 21);
+
+    uint8_t* before = battery_data(ba);
+    print_result("Revert drops the writes in place",
+                 machine_revert_battery(&a) && battery_data(ba) == before && a.bus.prg_ram == before &&
+                 bus_read(&a.bus, 0x6003) == 21 && bus_read(&b.bus, 0x6003) == 0xBB);
+
+    // 基准里是写过的值，回退之后的增量存档必须带上回退后的页
+    uint8_t* base = (uint8_t*)malloc(size);
+    uint8_t* delta = (uint8_t*)malloc(size);
+    bus_write(&a.bus, 0x6003, 0xAA);
+    savestate_save_base(&a, base, size);
+    machine_revert_battery(&a);
+    size_t delta_size = savestate_save_delta(&a, delta, size);
+    bus_write(&a.bus, 0x6003, 0x55);
+    print_result("Delta after revert carries the template",
+                 delta_size > 0 && savestate_load_delta(&a, base, size, delta, delta_size) &&
+                 bus_read(&a.bus, 0x6003) == 21);
+    free(delta);
+    free(base);
+    machine_revert_battery(&a);
+
+    int rounds = 10000;
+    double t0 = now_seconds();
+    for (int i = 0; i < rounds; i++) {
+        bus_write(&a.bus, 0x6000 + (i & 0x1FFF), (uint8_t)i);
+        machine_revert_battery(&a);
+    }
+    double t1 = now_seconds();
+    // 时间只打印，不同机器、sanitizer 下差很多
+    printf("  write + revert to template: %.2f us\n", (t1 - t0) / rounds * 1e6);
+    print_result("Repeated reverts restore the template", memcmp(battery_data(ba), file, sizeof(file)) == 0);
+
+    Battery* shared = battery_open(path, BATTERY_SHARED);
+    print_result("Revert is only for private saves", shared && !battery_revert(shared));
+    battery_close(shared);
+    print_result("Private save needs an existing template", battery_open("/nonexistent/x.sav", BATTERY_PRIVATE) == NULL);
+
+    machine_attach_battery(&a, NULL);
+    machine_attach_battery(&b, NULL);
+    battery_close(ba);
+    battery_close(bb);
+    remove(path);
+    remove(tmpl);
+    free_nes_rom(rom);
+    printf("=== All Battery Save Tests Passed ===\n");
+    return 0;
+}
@@ -48,6 +48,35 @@ int main() {
     uint8_t base_val = bus_read(&bus, 0x07FF); // 0x07FF 是物理 RAM 的最后一个字节
     print_result("RAM Reverse Mirror (Write 0x1FFF, Read 0x07FF)", base_val == 0x42);
 
+    // ---------------------------------------------------------
+    // 测试 1b: 手柄移位寄存器 ($4016 / $4017)
+    // ---------------------------------------------------------
+    bus.controller[0] = 0x09; // A + Start
+    bus.controller[1] = 0x80; // 右
+
+    bus_write(&bus, 0x4016, 1);
+    print_result("Strobe high always returns A", (bus_read(&bus, 0x4016) & 1) == 1 && (bus_read(&bus, 0x4016) & 1) == 1);
+    bus_write(&bus, 0x4016, 0);
+
+    uint8_t pad1 = 0, pad2 = 0;
+    for (int i = 0; i < 8; i++) {
+        pad1 |= (bus_read(&bus, 0x4016) & 1) << i;
+        pad2 |= (bus_read(&bus, 0x4017) & 1) << i;
+    }
+    print_result("Controller 1 shifts out A..Right", pad1 == 0x09);
+    print_result("Controller 2 shifts out A..Right", pad2 == 0x80);
+    print_result("Reads after 8 bits return 1", (bus_read(&bus, 0x4016) & 1) == 1);
+
+    // ---------------------------------------------------------
+    // 测试 1c: 卡带 PRG-RAM ($6000 - $7FFF)，按 1KB 页记录写入
+    // ---------------------------------------------------------
+    print_result("PRG-RAM starts cleared", bus_read(&bus, 0x6000) == 0 && bus_read(&bus, 0x7FFF) == 0);
+    bus_write(&bus, 0x6000, 0x80);
+    bus_write(&bus, 0x7FFF, 0x5A);
+    print_result("PRG-RAM Read/Write at 0x6000 and 0x7FFF",
+                 bus_read(&bus, 0x6000) == 0x80 && bus_read(&bus, 0x7FFF) == 0x5A && bus.prg_ram[0x1FFF] == 0x5A);
+    print_result("PRG-RAM writes are tracked per 1KB page", bus.prg_ram_dirty == 0x81);
+
 
     // ---------------------------------------------------------
     // 测试 2: 卡带 (ROM) 读取测试
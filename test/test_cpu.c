@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// 注意：因为我们在 test 目录下，引用 code 目录的头文件需要用 "../code/"
+#include "../code/machine.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+int main() {
+    printf("=== Starting CPU Tests ===\n");
+
+    // 注意：这里假设你在项目根目录运行程序
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("[\033[33mSKIP\033[0m] nestest (Could not load test/nestest.nes)\n");
+        return 0;
+    }
+
+    static Machine m;
+    machine_init(&m, rom);
+
+    // ---------------------------------------------------------
+    // 测试 1: nestest 自动模式
+    // 从 $C000 开始执行，不需要 PPU 画面；结束时 PC 到达 $C66E，
+    // 错误码写在 $02 (官方指令) 和 $03 (非官方指令)，0 表示全部通过。
+    // 官方日志里复位后的周期数从 7 开始，到 $C66E 时是 26554。
+    // ---------------------------------------------------------
+    m.cpu.pc = 0xC000;
+    m.bus.cycles = 7;
+    int steps = 0;
+    while (m.cpu.pc != 0xC66E && steps < 10000 && !m.cpu.jammed) {
+        cpu_step(&m.cpu);
+        steps++;
+    }
+    printf("       $02 = %02X, $03 = %02X, cycles = %llu\n",
+           m.bus.ram[2], m.bus.ram[3], (unsigned long long)m.bus.cycles);
+    print_result("nestest reaches $C66E", m.cpu.pc == 0xC66E);
+    print_result("Official opcodes ($02 == 0)", m.bus.ram[2] == 0x00);
+    print_result("Unofficial opcodes ($03 == 0)", m.bus.ram[3] == 0x00);
+    print_result("Cycle count matches nestest.log", m.bus.cycles == 26554);
+
+    // ---------------------------------------------------------
+    // 测试 2: 整机运行若干帧，主时钟与 PPU 保持 3:1
+    // ---------------------------------------------------------
+    machine_reset(&m);
+    for (int i = 0; i < 10; i++) {
+        machine_run_frame(&m);
+    }
+    bus_sync_ppu(&m.bus);
+    print_result("PPU caught up to master clock", m.ppu.clock == m.bus.cycles * 3);
+
+    free_nes_rom(rom);
+    printf("=== All Tests Completed ===\n");
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../code/env.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+#define ENVS 8
+#define SKIP 4
+#define STEPS 40
+
+// 第 step 步第 i 台的动作：第 15 步起奇数号按 Start（菜单在第 60 帧之后才响应），偶数号按下
+static uint8_t action(int i, int step) {
+    if (step < 15 || step > 16) return 0x00;
+    return (i & 1) ? 0x08 : 0x20;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint8_t obs[ENVS * ENV_OBS_BYTES];
+static uint8_t ram[ENVS * ENV_RAM_BYTES];
+static uint8_t obs2[ENVS * ENV_OBS_BYTES];
+static uint8_t ram2[ENVS * ENV_RAM_BYTES];
+
+int main() {
+    printf("=== Starting Env Tests ===\n");
+
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+
+    // ---------------------------------------------------------
+    // 测试 1: 一步 = SKIP 帧，观测和逐帧运行的参考机器一致
+    // ---------------------------------------------------------
+    EnvBatch* envs = env_create(rom, ENVS, SKIP, NULL);
+    print_result("Create envs", envs != NULL && env_count(envs) == ENVS);
+
+    static Machine ref[ENVS];
+    for (int i = 0; i < ENVS; i++) {
+        machine_init(&ref[i], rom);
+        machine_set_audio(&ref[i], 0);
+    }
+    uint8_t actions[ENVS];
+    int obs_ok = 1, ram_ok = 1;
+    for (int s = 0; s < STEPS; s++) {
+        for (int i = 0; i < ENVS; i++) actions[i] = action(i, s);
+        env_step_batch(envs, actions, ENVS, obs, ram);
+        for (int i = 0; i < ENVS; i++) {
+            machine_set_input(&ref[i], 0, actions[i]);
+            for (int f = 0; f < SKIP; f++) machine_run_frame(&ref[i]);
+            obs_ok &= memcmp(obs + i * ENV_OBS_BYTES, ref[i].ppu.frame.pixels, ENV_OBS_BYTES) == 0;
+            ram_ok &= memcmp(ram + i * ENV_RAM_BYTES, ref[i].bus.ram, ENV_RAM_BYTES) == 0;
+        }
+    }
+    print_result("Observation frames match frame-by-frame emulation", obs_ok);
+    print_result("RAM observations match", ram_ok);
+    print_result("Different actions give different observations",
+                 memcmp(ram, ram + ENV_RAM_BYTES, ENV_RAM_BYTES) != 0 &&
+                 memcmp(ram, ram + 2 * ENV_RAM_BYTES, ENV_RAM_BYTES) == 0);
+
+    // ---------------------------------------------------------
+    // 测试 2: 复位，以及自定义的起始状态
+    // ---------------------------------------------------------
+    env_reset(envs, -1);
+    memset(actions, 0, sizeof(actions));
+    env_step_batch(envs, actions, ENVS, obs2, ram2);
+    static Machine fresh;
+    machine_init(&fresh, rom);
+    machine_set_audio(&fresh, 0);
+    for (int f = 0; f < SKIP; f++) machine_run_frame(&fresh);
+    print_result("Reset returns to power-on", memcmp(ram2, fresh.bus.ram, ENV_RAM_BYTES) == 0 &&
+                 memcmp(obs2, fresh.ppu.frame.pixels, ENV_OBS_BYTES) == 0);
+
+    // 从参考机器当前状态开始（已经进入测试界面）
+    env_set_start_state(envs, &ref[1]);
+    env_reset(envs, 3);
+    print_result("Reset one env from the cached start state",
+                 memcmp(env_machine(envs, 3)->bus.ram, ref[1].bus.ram, ENV_RAM_BYTES) == 0 &&
+                 env_machine(envs, 3)->bus.cycles == ref[1].bus.cycles &&
+                 env_machine(envs, 2)->bus.cycles != ref[1].bus.cycles);
+    env_step_batch(envs, actions, ENVS, obs2, ram2);
+    machine_set_input(&ref[1], 0, 0);
+    for (int f = 0; f < SKIP; f++) machine_run_frame(&ref[1]);
+    print_result("Env continues from the start state", memcmp(ram2 + 3 * ENV_RAM_BYTES, ref[1].bus.ram, ENV_RAM_BYTES) == 0 &&
+                 memcmp(obs2 + 3 * ENV_OBS_BYTES, ref[1].ppu.frame.pixels, ENV_OBS_BYTES) == 0);
+
+    // ---------------------------------------------------------
+    // 测试 3: 线程池上跑，结果与单线程相同；只要 RAM 时不画画面
+    // ---------------------------------------------------------
+    ThreadPool* pool = thread_pool_create(4, 0);
+    EnvBatch* a = env_create(rom, ENVS, SKIP, NULL);
+    EnvBatch* b = env_create(rom, ENVS, SKIP, pool);
+    int same = 1;
+    for (int s = 0; s < STEPS; s++) {
+        for (int i = 0; i < ENVS; i++) actions[i] = action(i, s);
+        env_step_batch(a, actions, ENVS, obs, ram);
+        env_step_batch(b, actions, ENVS, obs2, ram2);
+        same &= memcmp(obs, obs2, sizeof(obs)) == 0 && memcmp(ram, ram2, sizeof(ram)) == 0;
+    }
+    print_result("Thread pool gives the same observations", same);
+
+    double t0 = now_seconds();
+    for (int s = 0; s < STEPS; s++) env_step_batch(a, actions, ENVS, obs, ram);
+    double t1 = now_seconds();
+    for (int s = 0; s < STEPS; s++) env_step_batch(a, actions, ENVS, NULL, ram);
+    double t2 = now_seconds();
+    // 时间只打印，机器忙或者开了 sanitizer 时没有意义
+    printf("  %.0f steps/s with frames, %.0f steps/s RAM only (frame skip %d)\n",
+           ENVS * STEPS / (t1 - t0), ENVS * STEPS / (t2 - t1), SKIP);
+
+    // 只要 RAM 时一帧都不画：先把画面涂成渲染不会写出的值（调色板索引 < 64），走几步之后还在
+    static uint8_t blank[ENV_OBS_BYTES];
+    memset(blank, 0xFF, sizeof(blank));
+    for (int i = 0; i < ENVS; i++) memset(env_machine(a, i)->ppu.frame.pixels, 0xFF, ENV_OBS_BYTES);
+    uint64_t cycles = env_machine(a, 0)->bus.cycles;
+    for (int s = 0; s < 3; s++) env_step_batch(a, actions, ENVS, NULL, ram);
+    int untouched = env_machine(a, 0)->bus.cycles > cycles;
+    for (int i = 0; i < ENVS; i++) untouched &= memcmp(env_machine(a, i)->ppu.frame.pixels, blank, ENV_OBS_BYTES) == 0;
+    print_result("RAM-only steps skip rendering", untouched);
+    env_step_batch(a, actions, ENVS, obs, ram);
+    int drawn = 1;
+    for (int i = 0; i < ENVS; i++) drawn &= memchr(obs + i * ENV_OBS_BYTES, 0xFF, ENV_OBS_BYTES) == NULL;
+    print_result("A step with frames draws again", drawn);
+
+    env_destroy(a);
+    env_destroy(b);
+    env_destroy(envs);
+    thread_pool_destroy(pool);
+    free_nes_rom(rom);
+    printf("=== All Env Tests Passed ===\n");
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../code/env_shm.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+#define ENVS 4
+#define SKIP 4
+#define STEPS 30
+
+// 第 step 步第 i 台的动作：第 15 步起奇数号按 Start，偶数号按下
+static uint8_t action(int i, int step) {
+    if (step < 15 || step > 16) return 0x00;
+    return (i & 1) ? 0x08 : 0x20;
+}
+
+// 奖励：RAM 里第一个字节加上环境编号，训练进程那边可以按同样的规则核对
+static float reward_fn(void* user, Machine* m, int index) {
+    (void)user;
+    return (float)m->bus.ram[0] + (float)index;
+}
+
+// 模拟进程那一侧：一直处理请求，直到对方关闭；返回最后一次 env_shm_serve 的结果
+static void* serve_loop(void* arg) {
+    EnvShm* shm = (EnvShm*)arg;
+    int r;
+    while ((r = env_shm_serve(shm, -1)) > 0) {
+    }
+    return (void*)(intptr_t)r;
+}
+
+static uint8_t ref_obs[ENVS * ENV_OBS_BYTES];
+static uint8_t ref_ram[ENVS * ENV_RAM_BYTES];
+
+int main() {
+    printf("=== Starting Env Shared Memory Tests ===\n");
+
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "/nes_env_test_%d", (int)getpid());
+
+    // ---------------------------------------------------------
+    // 测试 1: 创建、布局、另一侧打开
+    // ---------------------------------------------------------
+    EnvBatch* envs = env_create(rom, ENVS, SKIP, NULL);
+    EnvShm* shm = env_shm_create(name, envs);
+    print_result("Create shared memory", shm != NULL);
+    env_shm_set_reward(shm, reward_fn, NULL);
+    print_result("Refuse to create over an existing region", env_shm_create(name, envs) == NULL);
+
+    EnvShmClient* client = env_shm_open(name);
+    EnvShmHeader* h = client ? env_shm_header(client) : NULL;
+    print_result("Open from the consumer side", h != NULL && h->magic == ENV_SHM_MAGIC &&
+                 h->env_count == ENVS && h->frame_skip == SKIP &&
+                 h->obs_bytes == ENV_OBS_BYTES && h->ram_bytes == ENV_RAM_BYTES);
+    print_result("Arrays are aligned and inside the region",
+                 h->action_offset % 64 == 0 && h->reset_offset % 64 == 0 && h->reward_offset % 64 == 0 &&
+                 h->ram_offset % 4096 == 0 && h->obs_offset % 4096 == 0 &&
+                 h->obs_offset + (uint64_t)ENVS * ENV_OBS_BYTES <= h->total_size);
+    print_result("Step times out with no producer", env_shm_step(client, 20) == 0);
+
+    // 超时那次请求还挂着：不能再发新的，要等模拟进程把它处理掉
+    uint32_t pending = atomic_load(&h->request);
+    print_result("Timed-out request stays pending", env_shm_wait(client, 0) == 0 && atomic_load(&h->done) != pending);
+    print_result("No new request while one is pending",
+                 env_shm_step(client, 0) == 0 && atomic_load(&h->request) == pending);
+    print_result("Producer serves the pending request", env_shm_serve(shm, 0) == 1);
+    print_result("Wait collects the pending request", env_shm_wait(client, 0) == 1 && atomic_load(&h->done) == pending);
+
+    // ---------------------------------------------------------
+    // 测试 2: 多步握手，观测、RAM、奖励和进程内运行的参考一致
+    // ---------------------------------------------------------
+    env_reset(envs, -1);
+
+    EnvBatch* ref = env_create(rom, ENVS, SKIP, NULL);
+    pthread_t thread;
+    pthread_create(&thread, NULL, serve_loop, shm);
+
+    uint8_t* base = (uint8_t*)h;
+    uint8_t* actions = base + h->action_offset;
+    uint8_t* reset = base + h->reset_offset;
+    float* rewards = (float*)(base + h->reward_offset);
+    uint8_t ref_actions[ENVS];
+    int steps_ok = 1, obs_ok = 1, ram_ok = 1, reward_ok = 1;
+    for (int s = 0; s < STEPS; s++) {
+        for (int i = 0; i < ENVS; i++) actions[i] = ref_actions[i] = action(i, s);
+        h->want_obs = 1;
+        steps_ok &= env_shm_step(client, 5000) == 1;
+        env_step_batch(ref, ref_actions, ENVS, ref_obs, ref_ram);
+        obs_ok &= memcmp(base + h->obs_offset, ref_obs, sizeof(ref_obs)) == 0;
+        ram_ok &= memcmp(base + h->ram_offset, ref_ram, sizeof(ref_ram)) == 0;
+        for (int i = 0; i < ENVS; i++) {
+            reward_ok &= rewards[i] == (float)ref_ram[i * ENV_RAM_BYTES] + (float)i;
+        }
+    }
+    print_result("Every step completes", steps_ok);
+    print_result("Frames match in-process stepping", obs_ok);
+    print_result("RAM matches in-process stepping", ram_ok);
+    print_result("Rewards come from the reward function", reward_ok);
+
+    // ---------------------------------------------------------
+    // 测试 3: 复位标志
+    // ---------------------------------------------------------
+    memset(actions, 0, ENVS);
+    memset(ref_actions, 0, ENVS);
+    reset[2] = 1;
+    env_reset(ref, 2);
+    h->want_obs = 0;
+    env_shm_step(client, 5000);
+    env_step_batch(ref, ref_actions, ENVS, NULL, ref_ram);
+    print_result("Reset flag resets before the step and is cleared",
+                 reset[2] == 0 && memcmp(base + h->ram_offset, ref_ram, sizeof(ref_ram)) == 0);
+
+    // ---------------------------------------------------------
+    // 测试 4: 真正的另一个进程
+    // ---------------------------------------------------------
+    pid_t pid = fork();
+    if (pid == 0) {
+        EnvShmClient* other = env_shm_open(name);
+        if (!other) _exit(2);
+        EnvShmHeader* oh = env_shm_header(other);
+        uint32_t done = atomic_load(&oh->done);
+        int r = env_shm_step(other, 5000);
+        // 子进程退出时不关闭，留给父进程
+        _exit(r == 1 && atomic_load(&oh->done) == done + 1 ? 0 : 3);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    print_result("Step from a forked consumer process", WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // ---------------------------------------------------------
+    // 测试 5: 关闭
+    // ---------------------------------------------------------
+    env_shm_close(client);
+    void* last = NULL;
+    pthread_join(thread, &last);
+    print_result("Closing the consumer stops the producer loop", (intptr_t)last == -1);
+
+    env_shm_destroy(shm);
+    print_result("Region is removed on destroy", env_shm_open(name) == NULL);
+
+    env_destroy(ref);
+    env_destroy(envs);
+    free_nes_rom(rom);
+    printf("=== All Env Shared Memory Tests Passed ===\n");
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../code/machine.h"
+#include "../code/savestate.h"
+#include "../code/statehash.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+// nestest 菜单：第 60-61 帧按 Start 运行第一组测试；alt 时在第 140 帧按下，把光标移走
+static void run_frames(Machine* m, int from, int count, int alt) {
+    for (int f = from; f < from + count; f++) {
+        uint8_t buttons = 0;
+        if (f == 60 || f == 61) buttons = 0x08;
+        if (alt && (f == 140 || f == 141)) buttons = 0x20;
+        machine_set_input(m, 0, buttons);
+        machine_run_frame(m);
+    }
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main() {
+    printf("=== Starting Fork Tests ===\n");
+
+    // ---------------------------------------------------------
+    // 测试 1: PPU 存储页写时复制（CHR-RAM 卡带）
+    // ---------------------------------------------------------
+    static PPU a, b;
+    ppu_init(&a, NULL);
+    ppu_bus_write(&a, 0x0010, 0x11); // CHR-RAM bank 0
+    ppu_bus_write(&a, 0x2000, 0x22); // 名称表 A
+    ppu_fork(&a, &b);
+    print_result("All storage pages are shared after fork", a.store_shared == 0x0FFF && b.store_shared == 0x0FFF);
+    print_result("Child sees parent's VRAM", ppu_bus_read(&b, 0x0010) == 0x11 && ppu_bus_read(&b, 0x2000) == 0x22);
+
+    ppu_bus_write(&b, 0x0010, 0x33);
+    print_result("Child write copies only that page", !(b.store_shared & 0x001) && b.store_shared == 0x0FFE);
+    print_result("Parent does not see child's write", ppu_bus_read(&a, 0x0010) == 0x11);
+    ppu_bus_write(&a, 0x2001, 0x44);
+    print_result("Parent write copies its own page",
+                 ppu_bus_read(&a, 0x2001) == 0x44 && ppu_bus_read(&b, 0x2001) == 0x00 && !(a.store_shared & 0x100));
+    print_result("Mirrored nametable follows the copied page", ppu_bus_read(&a, 0x2401) == 0x44);
+
+    // 再分一次：上次之后没写过的页直接共享，不再拷贝
+    static PPU c;
+    uint8_t* before = ppu_store_page(&a, 9);
+    ppu_fork(&a, &c);
+    print_result("Refork reuses untouched shared pages", ppu_store_page(&c, 9) == before);
+    print_result("Refork shares pages written since", ppu_bus_read(&c, 0x2001) == 0x44);
+    ppu_unshare(&a, 1);
+    ppu_unshare(&b, 1);
+    ppu_unshare(&c, 1);
+    print_result("Unshare keeps contents", ppu_bus_read(&a, 0x0010) == 0x11 && ppu_bus_read(&b, 0x0010) == 0x33 &&
+                 ppu_bus_read(&c, 0x2001) == 0x44 && a.store_shared == 0 && c.store_shared == 0);
+
+    // ---------------------------------------------------------
+    // 测试 2: 分支出来的机器和原机器逐周期一致
+    // ---------------------------------------------------------
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+    static Machine parent, child, reference;
+    machine_init(&parent, rom);
+    machine_init(&reference, rom);
+    run_frames(&parent, 0, 70, 0);
+    run_frames(&reference, 0, 70, 0);
+
+    print_result("Fork succeeds", machine_fork(&parent, &child));
+    print_result("Fork starts from the same state", statehash_digest(&child) == statehash_digest(&parent));
+    size_t size = savestate_size(&parent);
+    uint8_t* s1 = (uint8_t*)malloc(size);
+    uint8_t* s2 = (uint8_t*)malloc(size);
+    savestate_save(&parent, s1, size);
+    savestate_save(&child, s2, size);
+    print_result("Fork saves an identical state", memcmp(s1, s2, size) == 0);
+
+    run_frames(&parent, 70, 60, 0);
+    run_frames(&child, 70, 60, 0);
+    run_frames(&reference, 70, 60, 0);
+    print_result("Same input gives the same result", statehash_digest(&child) == statehash_digest(&parent));
+    print_result("Parent matches a machine that never forked", statehash_digest(&parent) == statehash_digest(&reference));
+    print_result("Child renders the same frame", machine_frame(&child)->hash == machine_frame(&parent)->hash);
+
+    // ---------------------------------------------------------
+    // 测试 3: 分支之后输入不同，互不影响
+    // ---------------------------------------------------------
+    machine_release(&child);
+    machine_fork(&parent, &child);
+    run_frames(&child, 130, 60, 1);
+    run_frames(&parent, 130, 60, 0);
+    run_frames(&reference, 130, 60, 0);
+    print_result("Diverging child does not disturb parent", statehash_digest(&parent) == statehash_digest(&reference));
+    print_result("Child really diverged", statehash_digest(&child) != statehash_digest(&parent));
+
+    // 打开分支的音频：合成器在这时才初始化
+    machine_set_audio(&child, 1);
+    run_frames(&child, 190, 2, 0);
+    int16_t samples[2048];
+    int n = machine_read_audio(&child, samples, 2048);
+    print_result("Child audio can be enabled", n > 1400 && n < 1800); // 两帧
+    machine_release(&child);
+
+    // ---------------------------------------------------------
+    // 测试 4: 分支的代价。时间只打印，机器忙或者开了 sanitizer 时没有意义
+    // ---------------------------------------------------------
+    const int rounds = 20000;
+    uint64_t parent_state = statehash_digest(&parent);
+    double t0 = now_seconds();
+    for (int i = 0; i < rounds; i++) {
+        machine_fork(&parent, &child);
+        machine_release(&child);
+    }
+    double t1 = now_seconds();
+    for (int i = 0; i < rounds / 10; i++) {
+        machine_fork(&parent, &child);
+        run_frames(&child, 190, 1, 0);
+        machine_release(&child);
+    }
+    double t2 = now_seconds();
+    printf("  fork+release %.0f ns, fork+1 frame+release %.1f us\n", (t1 - t0) / rounds * 1e9,
+           (t2 - t1) / (rounds / 10) * 1e6);
+    print_result("Repeated forks leave the parent untouched", statehash_digest(&parent) == parent_state);
+
+    // 渲染线程模式下不能分支
+    machine_start_render_thread(&parent);
+    print_result("Fork is refused with render thread", !machine_fork(&parent, &child));
+    machine_stop_render_thread(&parent);
+
+    machine_release(&parent);
+    free(s1);
+    free(s2);
+    free_nes_rom(rom);
+    printf("=== All Fork Tests Passed ===\n");
+    return 0;
+}
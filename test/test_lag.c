@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../code/machine.h"
+#include "../code/savestate.h"
+#include "../code/env.h"
+#include "../code/search.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+// 隔一帧读一次手柄的 ROM：NMI 里帧计数 $00 加 1，奇数帧锁存手柄并把 A 键累加到 $01
+static const uint8_t program[] = {
+    0x78,                   // C000: SEI
+    0xA9, 0x80,             // C001: LDA #$80
+    0x8D, 0x00, 0x20,       // C003: STA $2000  打开 NMI
+    0x4C, 0x06, 0xC0,       // C006: JMP $C006
+};
+static const uint8_t nmi[] = {
+    0xE6, 0x00,             // C010: INC $00
+    0xA5, 0x00,             // C012: LDA $00
+    0x4A,                   // C014: LSR A
+    0x90, 0x14,             // C015: BCC $C02B  偶数帧不碰手柄
+    0xA9, 0x01,             // C017: LDA #1
+    0x8D, 0x16, 0x40,       // C019: STA $4016
+    0xA9, 0x00,             // C01C: LDA #0
+    0x8D, 0x16, 0x40,       // C01E: STA $4016
+    0xAD, 0x16, 0x40,       // C021: LDA $4016
+    0x29, 0x01,             // C024: AND #1
+    0x18,                   // C026: CLC
+    0x65, 0x01,             // C027: ADC $01
+    0x85, 0x01,             // C029: STA $01
+    0x40,                   // C02B: RTI
+};
+
+static NesRom* build_rom(void) {
+    static uint8_t image[16 + 0x4000];
+    static const uint8_t header[16] = {'N', 'E', 'S', 0x1A, 1, 0, 0, 0};
+    uint8_t* prg = image + 16;
+    memcpy(image, header, sizeof(header));
+    memset(prg, 0xEA, 0x4000); // NOP
+    memcpy(prg, program, sizeof(program));
+    memcpy(prg + 0x10, nmi, sizeof(nmi));
+    prg[0x3FFA] = 0x10; prg[0x3FFB] = 0xC0; // NMI
+    prg[0x3FFC] = 0x00; prg[0x3FFD] = 0xC0; // RESET
+    prg[0x3FFE] = 0x2B; prg[0x3FFF] = 0xC0; // IRQ -> RTI
+    return load_nes_rom_from_buffer(image, sizeof(image));
+}
+
+// A 键累加到 3 次
+static int three_presses(void* user, const Machine* m) {
+    (void)user;
+    return m->bus.ram[1] >= 3;
+}
+
+int main() {
+    printf("=== Starting Lag Frame Tests ===\n");
+
+    NesRom* nestest = load_nes_rom("test/nestest.nes");
+    NesRom* rom = build_rom();
+    if (!nestest || !rom) {
+        printf("Cannot load ROMs\n");
+        return 1;
+    }
+
+    // ---------------------------------------------------------
+    // 测试 1: nestest 上电的几帧不读手柄，进菜单之后每帧都读
+    // ---------------------------------------------------------
+    static Machine m;
+    machine_init(&m, nestest);
+    machine_set_audio(&m, 0);
+    print_result("No lag frames before the first frame", machine_lag_count(&m) == 0);
+    for (int f = 0; f < 20; f++) machine_run_frame(&m);
+    uint32_t boot_lag = machine_lag_count(&m);
+    print_result("Boot frames are lag frames", boot_lag > 0 && boot_lag < 20);
+    for (int f = 0; f < 60; f++) machine_run_frame(&m);
+    print_result("Menu polls input every frame", machine_lag_count(&m) == boot_lag && !machine_lag_frame(&m));
+
+    // ---------------------------------------------------------
+    // 测试 2: 隔帧读手柄的 ROM
+    // ---------------------------------------------------------
+    static Machine a;
+    machine_init(&a, rom);
+    machine_set_audio(&a, 0);
+    for (int f = 0; f < 4; f++) machine_run_frame(&a);
+    uint32_t base = machine_lag_count(&a);
+    int alternates = 1, previous = machine_lag_frame(&a);
+    for (int f = 0; f < 20; f++) {
+        machine_run_frame(&a);
+        alternates &= machine_lag_frame(&a) != previous;
+        previous = machine_lag_frame(&a);
+    }
+    print_result("Lag flag alternates with the polling frames", alternates);
+    print_result("Lag counter counts every other frame", machine_lag_count(&a) - base == 10);
+
+    // 一个延迟帧之后 machine_skip_lag 正好再跑一帧
+    if (!machine_lag_frame(&a)) machine_run_frame(&a);
+    int skipped = machine_skip_lag(&a, 8);
+    print_result("Skip lag runs to the next polling frame", skipped == 1 && !machine_lag_frame(&a));
+    print_result("Skip lag does nothing on a polling frame", machine_skip_lag(&a, 8) == 0);
+
+    // ---------------------------------------------------------
+    // 测试 3: 存档和预跑
+    // ---------------------------------------------------------
+    size_t size = savestate_size(&a);
+    uint8_t* state = (uint8_t*)malloc(size);
+    savestate_save(&a, state, size);
+    uint32_t saved = machine_lag_count(&a);
+    for (int f = 0; f < 7; f++) machine_run_frame(&a);
+    savestate_load(&a, state, size);
+    print_result("Savestate restores the lag counter", machine_lag_count(&a) == saved && !machine_lag_frame(&a));
+
+    static Machine plain, ahead;
+    machine_fork(&a, &plain);
+    machine_fork(&a, &ahead);
+    machine_set_run_ahead(&ahead, 2);
+    for (int f = 0; f < 11; f++) {
+        machine_run_frame(&plain);
+        machine_run_frame(&ahead);
+    }
+    print_result("Run-ahead frames are not counted", machine_lag_count(&ahead) == machine_lag_count(&plain) &&
+                 machine_lag_frame(&ahead) == machine_lag_frame(&plain));
+    machine_set_run_ahead(&ahead, 0);
+
+    // ---------------------------------------------------------
+    // 测试 4: 环境和搜索跳过延迟帧
+    // ---------------------------------------------------------
+    EnvBatch* envs = env_create(rom, 2, 1, NULL);
+    env_set_skip_lag(envs, 4);
+    uint8_t actions[2] = {0x01, 0x00};
+    int never_lag = 1;
+    for (int s = 0; s < 10; s++) {
+        env_step_batch(envs, actions, 2, NULL, NULL);
+        never_lag &= !machine_lag_frame(env_machine(envs, 0));
+    }
+    print_result("Env steps never end on a lag frame", never_lag && env_machine(envs, 0)->bus.ram[1] == 10);
+    env_destroy(envs);
+
+    static const uint8_t buttons[] = {0x00, 0x01};
+    SearchConfig config;
+    memset(&config, 0, sizeof(config));
+    config.mode = SEARCH_BFS;
+    config.actions = buttons;
+    config.action_count = 2;
+    config.frames_per_step = 1;
+    config.max_depth = 10;
+    config.width = 64;
+    config.goal = three_presses;
+    SearchResult every, merged;
+    machine_run_frame(&plain); // 从哪一帧开始都一样
+    search_run(&plain, &config, NULL, &every);
+    config.skip_lag = 4;
+    search_run(&plain, &config, NULL, &merged);
+    printf("  %d steps frame by frame, %d steps with lag frames merged\n", every.steps, merged.steps);
+    print_result("Search merges lag frames into decision points", every.found && merged.found &&
+                 merged.steps == 3 && every.steps > merged.steps && merged.nodes < every.nodes);
+    free(every.actions);
+    free(merged.actions);
+
+    free(state);
+    machine_release(&a);
+    machine_release(&plain);
+    machine_release(&ahead);
+    free_nes_rom(rom);
+    free_nes_rom(nestest);
+    printf("=== All Lag Frame Tests Passed ===\n");
+    return 0;
+}
@@ -21,7 +21,8 @@ int main(int argc, char* argv[]) {
     // 打印读取到的信息进行验证
     printf("=== ROM Info ===\n");
     printf("Mapper ID: %d\n", rom->mapper_id);
-    printf("Mirroring: %s\n", rom->mirroring ? "Vertical" : "Horizontal");
+    const char* mirroring_names[] = { "Horizontal", "Vertical", "Single (low)", "Single (high)", "Four-screen" };
+    printf("Mirroring: %s\n", mirroring_names[rom->mirroring]);
     printf("Has Trainer: %s\n", rom->has_trainer ? "Yes" : "No");
     
     // 验证 PRG 大小 (Header 中的值 vs 实际计算)
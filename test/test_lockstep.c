@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../code/lockstep.h"
+#include "../code/statehash.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+#define LANES 16
+#define FRAMES 240
+
+// 每条 lane 的输入：有的按下移动光标，有的在不同的帧按 Start 跑测试
+static uint8_t lane_input(int lane, int frame) {
+    if ((lane & 3) == 1 && (frame == 50 || frame == 51)) return 0x20;
+    if ((lane & 3) == 2 && (frame == 50 || frame == 51)) return 0x10;
+    if (frame == 60 + (lane >> 2) * 7 || frame == 61 + (lane >> 2) * 7) return 0x08;
+    return 0x00;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static Machine lanes[LANES], ref[LANES];
+
+// 锁步跑 FRAMES 帧，每帧和逐台标量运行的参考比较
+static int run_and_compare(NesRom* rom, int split_after, Lockstep* ls) {
+    Machine* ptrs[LANES];
+    for (int i = 0; i < LANES; i++) {
+        machine_init(&lanes[i], rom);
+        machine_init(&ref[i], rom);
+        // lane 0 打开音频，检查锁步期间 APU 的追赶也没有偏差
+        machine_set_audio(&lanes[i], i == 0);
+        machine_set_audio(&ref[i], i == 0);
+        ptrs[i] = &lanes[i];
+    }
+    if (!lockstep_init(ls, ptrs, LANES)) return 0;
+    ls->split_after = split_after;
+
+    int16_t a[2048], b[2048];
+    for (int f = 0; f < FRAMES; f++) {
+        for (int i = 0; i < LANES; i++) {
+            machine_set_input(&lanes[i], 0, lane_input(i, f));
+            machine_set_input(&ref[i], 0, lane_input(i, f));
+            machine_run_frame(&ref[i]);
+        }
+        lockstep_run_frame(ls);
+        // 存档里的全部状态按部件逐一比较（状态哈希），再加上画面
+        for (int i = 0; i < LANES; i++) {
+            StateHash x, y;
+            statehash_compute(&lanes[i], &x);
+            statehash_compute(&ref[i], &y);
+            for (int part = 0; part < STATE_SECTIONS; part++) {
+                if (x.part[part] != y.part[part]) {
+                    printf("  lane %d %s state differs at frame %d\n", i, statehash_part_name(part), f);
+                    return 0;
+                }
+            }
+            if (x.cycles != y.cycles || machine_frame(&lanes[i])->hash != machine_frame(&ref[i])->hash) {
+                printf("  lane %d differs at frame %d\n", i, f);
+                return 0;
+            }
+        }
+        int na = machine_read_audio(&lanes[0], a, 2048);
+        int nb = machine_read_audio(&ref[0], b, 2048);
+        if (na != nb || memcmp(a, b, na * sizeof(int16_t)) != 0) {
+            printf("  audio differs at frame %d\n", f);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main() {
+    printf("=== Starting Lockstep Tests ===\n");
+
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+
+    // ---------------------------------------------------------
+    // 测试 1: 参数检查
+    // ---------------------------------------------------------
+    static Lockstep ls;
+    Machine* one[1] = {&lanes[0]};
+    machine_init(&lanes[0], rom);
+    print_result("Reject zero lanes", !lockstep_init(&ls, one, 0));
+    print_result("Reject too many lanes", !lockstep_init(&ls, one, LOCKSTEP_LANES + 1));
+
+    // ---------------------------------------------------------
+    // 测试 2: 锁步结果和逐台标量运行逐周期一致
+    // ---------------------------------------------------------
+    print_result("Lockstep matches the scalar core frame by frame", run_and_compare(rom, 256, &ls));
+    print_result("Lanes really diverged", statehash_digest(&lanes[0]) != statehash_digest(&lanes[1]) &&
+                 statehash_digest(&lanes[0]) != statehash_digest(&lanes[4]));
+    double lanes_in_lockstep = (double)ls.lockstep_instructions / (ls.lockstep_instructions + ls.scalar_instructions);
+    double width = (double)ls.lockstep_instructions / ls.lockstep_groups;
+    printf("  %.1f%% of instructions in lockstep, average group width %.1f\n", lanes_in_lockstep * 100, width);
+    print_result("Most instructions run in lockstep", lanes_in_lockstep > 0.5);
+    print_result("Groups hold several lanes", width > 2.0);
+
+    // 拆分得很激进时也一样（大部分指令走拆出去的标量路径）
+    print_result("Aggressive splitting matches too", run_and_compare(rom, 1, &ls));
+
+    // ---------------------------------------------------------
+    // 测试 3: 吞吐量（只打印：收益取决于 lane 之间分叉得多厉害）。
+    // 不画画面，只比 CPU 这一侧
+    // ---------------------------------------------------------
+    Machine* ptrs[LANES];
+    for (int i = 0; i < LANES; i++) {
+        ptrs[i] = &lanes[i];
+        lanes[i].ppu.skip_render = 1;
+        ref[i].ppu.skip_render = 1;
+    }
+    lockstep_init(&ls, ptrs, LANES);
+    double t0 = now_seconds();
+    for (int f = 0; f < 60; f++) lockstep_run_frame(&ls);
+    double t1 = now_seconds();
+    for (int f = 0; f < 60; f++) {
+        for (int i = 0; i < LANES; i++) machine_run_frame(&ref[i]);
+    }
+    double t2 = now_seconds();
+    printf("  lockstep %.0f fps, scalar %.0f fps (%d lanes)\n", LANES * 60 / (t1 - t0), LANES * 60 / (t2 - t1), LANES);
+
+    free_nes_rom(rom);
+    printf("=== All Lockstep Tests Passed ===\n");
+    return 0;
+}
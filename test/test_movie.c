@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../code/movie.h"
+#include "../code/machine.h"
+#include "../code/hash.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+#define MOVIE_PATH "test_movie.tmp"
+#define FRAMES 240
+
+// nestest 菜单：第 60-61 帧按 Start，运行第一组测试
+static uint8_t scripted_input(int frame) {
+    return (frame == 60 || frame == 61) ? 0x08 : 0x00;
+}
+
+// 整台机器可见状态的指纹：画面 + RAM + 周期数
+static uint64_t machine_fingerprint(Machine* m) {
+    uint64_t h = machine_frame(m)->hash;
+    h = hash64_combine(h, hash64(m->bus.ram, sizeof(m->bus.ram), 0));
+    return hash64_combine(h, m->bus.cycles);
+}
+
+int main() {
+    printf("=== Starting Movie Tests ===\n");
+
+    // ---------------------------------------------------------
+    // 测试 1: 录制与读回
+    // ---------------------------------------------------------
+    MovieWriter writer;
+    print_result("Open movie for recording", movie_writer_open(&writer, MOVIE_PATH, 2, 1));
+    for (int f = 0; f < FRAMES; f++) {
+        uint8_t input[2] = {scripted_input(f), (uint8_t)f};
+        movie_writer_frame(&writer, input);
+    }
+    print_result("Close movie", movie_writer_close(&writer));
+
+    Movie movie;
+    print_result("Open movie for playback", movie_open(&movie, MOVIE_PATH));
+    print_result("Header is parsed", movie.frame_count == FRAMES && movie.ports == 2 && movie.stride == 2);
+    print_result("File is 1 byte per frame per port", movie.map_size == MOVIE_HEADER_SIZE + FRAMES * 2);
+    print_result("Frame data reads back",
+                 movie_buttons(&movie, 60, 0) == 0x08 && movie_buttons(&movie, 59, 0) == 0 &&
+                 movie_buttons(&movie, 123, 1) == 123 && movie_commands(&movie, 60) == 0);
+
+    // ---------------------------------------------------------
+    // 测试 2: 回放是确定的，并且和手动输入完全一致
+    // ---------------------------------------------------------
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("[\033[33mSKIP\033[0m] Playback Test (Could not load test/nestest.nes)\n");
+    } else {
+        static Machine m;
+        uint64_t played[2];
+        for (int run = 0; run < 2; run++) {
+            machine_init(&m, rom);
+            machine_set_audio(&m, 0);
+            machine_play_movie(&m, &movie);
+            while (machine_movie_playing(&m)) {
+                machine_run_frame(&m);
+            }
+            played[run] = machine_fingerprint(&m);
+        }
+        print_result("Playback is deterministic", played[0] == played[1]);
+
+        machine_init(&m, rom);
+        machine_set_audio(&m, 0);
+        for (int f = 0; f < FRAMES; f++) {
+            machine_set_input(&m, 0, scripted_input(f));
+            machine_set_input(&m, 1, (uint8_t)f);
+            machine_run_frame(&m);
+        }
+        print_result("Playback matches live input", machine_fingerprint(&m) == played[0]);
+
+        machine_init(&m, rom);
+        machine_set_audio(&m, 0);
+        for (int f = 0; f < FRAMES; f++) {
+            machine_run_frame(&m);
+        }
+        print_result("Input actually reaches the game", machine_fingerprint(&m) != played[0]);
+
+        // 放完之后回到无输入
+        machine_init(&m, rom);
+        machine_play_movie(&m, &movie);
+        for (int f = 0; f < FRAMES + 1; f++) machine_run_frame(&m);
+        print_result("Playback stops at the end", !machine_movie_playing(&m) && m.movie == NULL);
+    }
+
+    // ---------------------------------------------------------
+    // 测试 3: 没有正常关闭的录像按文件长度推算帧数；坏文件被拒绝
+    // ---------------------------------------------------------
+    movie_close(&movie);
+    movie_writer_open(&writer, MOVIE_PATH, 1, 2);
+    for (int f = 0; f < 10; f++) {
+        uint8_t input[2] = {0x01, f == 5 ? MOVIE_CMD_RESET : 0};
+        movie_writer_frame(&writer, input);
+    }
+    fclose(writer.fp); // 模拟录制中途崩溃：没有写回帧数
+    print_result("Unfinished movie uses file length",
+                 movie_open(&movie, MOVIE_PATH) && movie.frame_count == 10 &&
+                 movie_commands(&movie, 5) == MOVIE_CMD_RESET);
+    movie_close(&movie);
+
+    FILE* fp = fopen(MOVIE_PATH, "wb");
+    fputs("not a movie file", fp);
+    fclose(fp);
+    print_result("Bad header is rejected", !movie_open(&movie, MOVIE_PATH));
+    remove(MOVIE_PATH);
+
+    printf("=== All Tests Completed ===\n");
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 注意：因为我们在 test 目录下，引用 code 目录的头文件需要用 "../code/"
+#include "../code/ppu.h"
+#include "../code/ppu_thread.h"
+#include "../code/ines.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+// 准备一个能画出东西的 PPU：随便填一些名称表、调色板和精灵
+static void setup_scene(PPU* ppu) {
+    for (int i = 0; i < 0x800; i++) {
+        ppu->ciram[i] = (uint8_t)(i * 7);
+    }
+    for (int i = 0; i < 32; i++) {
+        ppu->palette[i] = (uint8_t)(i * 3) & 0x3F;
+    }
+    for (int i = 0; i < 256; i++) {
+        ppu->oam[i] = (uint8_t)(i * 13);
+    }
+    for (int i = 0; i < 8192; i++) {
+        ppu->chr_ram[i] = (uint8_t)(i * 31 + (i >> 8));
+    }
+    ppu_write_register(ppu, 0x0000, 0x10); // 背景用 $1000 图案表
+    ppu_write_register(ppu, 0x0001, 0x1E); // 打开背景和精灵
+    ppu_write_register(ppu, 0x0005, 13);   // 滚动 X
+    ppu_write_register(ppu, 0x0005, 21);   // 滚动 Y
+}
+
+int main() {
+    printf("=== Starting PPU Tests ===\n");
+
+    static PPU ppu;
+    static PPU lazy;
+    static PPU eager;
+    static PPU inline_ppu;
+    static PPU threaded;
+    uint64_t frame_dots = (uint64_t)PPU_DOTS_PER_LINE * PPU_LINES_PER_FRAME;
+
+    // ---------------------------------------------------------
+    // 测试 1: 名称表镜像 与 $2007 缓冲读取
+    // ---------------------------------------------------------
+    ppu_init(&ppu, NULL);
+    ppu_set_mirroring(&ppu, MIRROR_VERTICAL); // 垂直镜像: $2000 与 $2800 是同一张表
+    ppu_write_register(&ppu, 0x0006, 0x20);
+    ppu_write_register(&ppu, 0x0006, 0x05);
+    ppu_write_register(&ppu, 0x0007, 0x5A);
+
+    ppu_write_register(&ppu, 0x0006, 0x28);
+    ppu_write_register(&ppu, 0x0006, 0x05);
+    ppu_read_register(&ppu, 0x0007); // 第一次读到的是旧缓冲
+    print_result("Vertical mirroring + buffered $2007 read", ppu_read_register(&ppu, 0x0007) == 0x5A);
+
+    // 切换镜像方式只改页表指针：水平镜像下 $2000 与 $2400 是同一张表
+    ppu_set_mirroring(&ppu, MIRROR_HORIZONTAL);
+    print_result("Horizontal mirroring ($2405 -> $2005)", ppu_bus_read(&ppu, 0x2405) == 0x5A);
+    print_result("$3000-$3EFF mirrors nametables", ppu_bus_read(&ppu, 0x3005) == 0x5A);
+    ppu_set_mirroring(&ppu, MIRROR_FOUR_SCREEN);
+    ppu_bus_write(&ppu, 0x2C00, 0x77);
+    print_result("Four-screen nametables are independent",
+                 ppu_bus_read(&ppu, 0x2C00) == 0x77 && ppu_bus_read(&ppu, 0x2400) != 0x77 &&
+                 ppu_bus_read(&ppu, 0x2000) != 0x77 && ppu_bus_read(&ppu, 0x2800) != 0x77);
+
+    // CHR bank 切换：把槽位 0 映射到 CHR-RAM 的第 3 个 1KB
+    ppu_bus_write(&ppu, 0x0C10, 0x99);
+    ppu_map_chr(&ppu, 0, 3);
+    print_result("CHR bank switch remaps pattern page", ppu_bus_read(&ppu, 0x0010) == 0x99);
+
+    // ---------------------------------------------------------
+    // 测试 2: VBlank 标志在第 241 行 dot 1 置位，读 $2002 清除
+    // ---------------------------------------------------------
+    ppu_init(&ppu, NULL);
+    uint64_t vblank = (uint64_t)241 * PPU_DOTS_PER_LINE + 1;
+    print_result("Next event is the first VBlank", ppu_next_event(&ppu) == vblank);
+    ppu_run_to(&ppu, vblank - 1);
+    print_result("VBlank not yet set one dot early", (ppu.status & 0x80) == 0);
+    ppu_run_to(&ppu, vblank);
+    print_result("VBlank set at scanline 241 dot 1", (ppu.status & 0x80) && ppu.frame_complete);
+    print_result("Next event is one frame later", ppu_next_event(&ppu) == vblank + frame_dots);
+    ppu_read_register(&ppu, 0x0002);
+    print_result("Reading $2002 clears VBlank", (ppu.status & 0x80) == 0);
+
+    // ---------------------------------------------------------
+    // 测试 3: 一次性追赶 与 逐 dot 推进 结果完全一致
+    // ---------------------------------------------------------
+    ppu_init(&lazy, NULL);
+    ppu_init(&eager, NULL);
+    setup_scene(&lazy);
+    setup_scene(&eager);
+
+    uint64_t target = frame_dots * 3 + 12345;
+    ppu_run_to(&lazy, target);
+    for (uint64_t t = 1; t <= target; t++) {
+        ppu_run_to(&eager, t);
+    }
+    print_result("Batch catch-up reaches same position",
+                 lazy.scanline == eager.scanline && lazy.dot == eager.dot &&
+                 lazy.frame_count == eager.frame_count && lazy.clock == target);
+    print_result("Batch catch-up produces same registers",
+                 lazy.v == eager.v && lazy.status == eager.status);
+    print_result("Batch catch-up produces same frame",
+                 memcmp(&lazy.frame, &eager.frame, sizeof(PpuFrame)) == 0);
+
+    // 奇数帧 pre-render 行少一个 dot：前 3 帧里有 1 个奇数帧，所以位置多走 1 个 dot
+    print_result("Odd frame is one dot shorter",
+                 lazy.frame_count == 3 && lazy.scanline * PPU_DOTS_PER_LINE + lazy.dot == 12345 + 1);
+
+    // ---------------------------------------------------------
+    // 测试 4: 渲染线程重放日志 与 CPU 线程直接渲染 画面一致
+    // ---------------------------------------------------------
+    ppu_init(&inline_ppu, NULL);
+    ppu_init(&threaded, NULL);
+    setup_scene(&inline_ppu);
+    setup_scene(&threaded);
+    PpuThread* th = ppu_thread_start(&threaded);
+    print_result("Render thread started", th != NULL && threaded.worker == th);
+
+    PPU* both[2] = { &inline_ppu, &threaded };
+    for (int f = 1; f <= 4; f++) {
+        for (int k = 0; k < 2; k++) {
+            PPU* p = both[k];
+            // 帧中途改滚动、写名称表/调色板/CHR-RAM/OAM，验证日志顺序正确
+            ppu_run_to(p, frame_dots * f - 60000);
+            ppu_write_register(p, 0x0005, (uint8_t)(f * 40));
+            ppu_write_register(p, 0x0005, (uint8_t)(f * 9));
+            ppu_write_register(p, 0x0006, 0x3F);
+            ppu_write_register(p, 0x0006, 0x01);
+            ppu_write_register(p, 0x0007, (uint8_t)(f * 5));
+            ppu_write_register(p, 0x0006, 0x10);
+            ppu_write_register(p, 0x0006, (uint8_t)(f * 16));
+            ppu_write_register(p, 0x0007, 0xFF);
+            ppu_write_register(p, 0x0003, 0x00);
+            ppu_write_register(p, 0x0004, (uint8_t)(f * 20));
+            ppu_run_to(p, frame_dots * f);
+        }
+    }
+    static PpuFrame expected;
+    expected = inline_ppu.frame;
+
+    // 停在第 4 帧最后一条可见扫描线：这一帧的精灵 0 命中 / 溢出标志都已产生
+    ppu_run_to(&inline_ppu, frame_dots * 4 + 239 * PPU_DOTS_PER_LINE);
+    ppu_run_to(&threaded, frame_dots * 4 + 239 * PPU_DOTS_PER_LINE);
+    printf("       PPUSTATUS = %02X\n", inline_ppu.status);
+    print_result("CPU-side status matches inline render", threaded.status == inline_ppu.status);
+
+    ppu_thread_flush(th);
+    uint64_t frame_no = 0;
+    const PpuFrame* frame = ppu_thread_acquire_frame(th, &frame_no);
+    print_result("Render thread publishes latest frame", frame_no == inline_ppu.frame_count - 1);
+    print_result("Render thread frame matches inline render",
+                 memcmp(frame, &expected, sizeof(PpuFrame)) == 0);
+
+    // 日志空着的时候渲染线程睡下，不占 CPU（clock() 是整个进程所有线程的 CPU 时间）
+    clock_t idle_start = clock();
+    struct timespec idle = {0, 200 * 1000 * 1000};
+    nanosleep(&idle, NULL);
+    double idle_cpu = (double)(clock() - idle_start) / CLOCKS_PER_SEC;
+    printf("       CPU time while idle for 200 ms: %.1f ms\n", idle_cpu * 1000);
+    print_result("Idle render thread does not spin", idle_cpu < 0.02);
+    ppu_thread_stop(th);
+    print_result("Stopping thread restores inline rendering",
+                 threaded.worker == NULL &&
+                 memcmp(&threaded.frame, &inline_ppu.frame, sizeof(PpuFrame)) == 0);
+
+    // ---------------------------------------------------------
+    // 测试 5: 脏行标记与整帧哈希
+    // ---------------------------------------------------------
+    ppu_init(&ppu, NULL);
+    setup_scene(&ppu);
+    ppu_run_to(&ppu, frame_dots * 2 - 1000);
+    uint64_t first_hash = ppu.frame.hash;
+    print_result("First frame after power-on is dirty", ppu.frame.dirty_count > 0);
+
+    ppu_run_to(&ppu, frame_dots * 3 - 1000);
+    print_result("Static frame has no dirty lines", ppu.frame.dirty_count == 0);
+    print_result("Static frame keeps the same hash", ppu.frame.hash == first_hash);
+
+    // 改一个名称表字节：只有这一行瓦片覆盖的扫描线会变
+    ppu.ciram[0x0100] ^= 0xFF;
+    ppu_run_to(&ppu, frame_dots * 4 - 1000);
+    int dirty_lines = 0;
+    for (int line = 0; line < PPU_HEIGHT; line++) {
+        dirty_lines += ppu_frame_line_dirty(&ppu.frame, line);
+    }
+    printf("       dirty lines after one tile change: %d\n", ppu.frame.dirty_count);
+    print_result("One tile change dirties a few lines",
+                 ppu.frame.dirty_count > 0 && ppu.frame.dirty_count <= 8 && dirty_lines == ppu.frame.dirty_count);
+    print_result("Frame hash changes with content", ppu.frame.hash != first_hash);
+
+    printf("=== All Tests Completed ===\n");
+    return 0;
+}
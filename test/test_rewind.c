@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../code/rewind.h"
+#include "../code/xdelta.h"
+#include "../code/savestate.h"
+#include "../code/machine.h"
+#include "../code/statehash.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+#define FRAMES 300
+
+// nestest 菜单：第 60-61 帧按 Start，运行第一组测试
+static void run_frame(Machine* m, int f) {
+    machine_set_input(m, 0, (f == 60 || f == 61) ? 0x08 : 0x00);
+    machine_run_frame(m);
+}
+
+int main() {
+    printf("=== Starting Rewind Tests ===\n");
+
+    // ---------------------------------------------------------
+    // 测试 1: XOR 差分编码
+    // ---------------------------------------------------------
+    enum { N = 5000 };
+    static uint8_t a[N], b[N], work[N], enc[XDELTA_BOUND(N)];
+    srand(1);
+    for (int i = 0; i < N; i++) a[i] = b[i] = (uint8_t)rand();
+    for (int i = 100; i < 110; i++) b[i] ^= 0x5A;      // 短的改动
+    for (int i = 2000; i < 2400; i++) b[i] = (uint8_t)rand(); // 长的改动
+    b[N - 1] ^= 1;                                      // 末尾
+
+    size_t len = xdelta_encode(a, b, N, enc);
+    memcpy(work, a, N);
+    print_result("Delta applies a -> b", xdelta_apply(work, N, enc, len) && memcmp(work, b, N) == 0);
+    print_result("Same delta applies b -> a", xdelta_apply(work, N, enc, len) && memcmp(work, a, N) == 0);
+    print_result("Sparse delta is small", len < 500);
+
+    size_t same = xdelta_encode(a, a, N, enc);
+    print_result("Identical data encodes to a few bytes", same <= N / 255 + 2);
+
+    for (int i = 0; i < N; i++) b[i] = (uint8_t)(a[i] + 1 + (i % 7)); // 全部不同
+    len = xdelta_encode(a, b, N, enc);
+    memcpy(work, a, N);
+    print_result("Incompressible data stays within bound",
+                 len <= XDELTA_BOUND(N) && xdelta_apply(work, N, enc, len) && memcmp(work, b, N) == 0);
+    print_result("Truncated delta is rejected", !xdelta_apply(work, N, enc, len - 1));
+    print_result("Delta for a shorter buffer is rejected", !xdelta_apply(work, N - 1, enc, len));
+
+    // ---------------------------------------------------------
+    // 测试 2: 倒带逐帧回到记录时的状态
+    // ---------------------------------------------------------
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+    static Machine m;
+    machine_init(&m, rom);
+
+    Rewind* r = rewind_create(&m, 8 << 20);
+    print_result("Create rewind buffer", r != NULL);
+    print_result("Tiny budget is refused", rewind_create(&m, 16 << 10) == NULL);
+
+    static uint64_t fp[FRAMES];
+    for (int f = 0; f < FRAMES; f++) {
+        run_frame(&m, f);
+        fp[f] = statehash_digest(&m);
+        rewind_push(r, &m);
+    }
+    printf("  %u frames in %zu bytes (%.0f bytes/frame)\n", rewind_frames(r), rewind_used_bytes(r),
+           (double)rewind_used_bytes(r) / rewind_frames(r));
+    print_result("All frames fit in the budget", rewind_frames(r) == FRAMES - 1);
+
+    int ok = 1;
+    for (int f = FRAMES - 2; f >= 150; f--) {
+        ok &= rewind_step_back(r, &m) && statehash_digest(&m) == fp[f];
+    }
+    print_result("Step back restores each earlier frame", ok);
+
+    // 倒带之后继续跑，和原来的时间线一致
+    for (int f = 151; f < FRAMES; f++) {
+        run_frame(&m, f);
+        rewind_push(r, &m);
+    }
+    print_result("Running on after rewind matches the original timeline", statehash_digest(&m) == fp[FRAMES - 1]);
+
+    while (rewind_step_back(r, &m)) {
+    }
+    print_result("Rewinds all the way to the first frame", statehash_digest(&m) == fp[0] && rewind_frames(r) == 0);
+    rewind_destroy(r);
+
+    // ---------------------------------------------------------
+    // 测试 3: 内存预算有界，用满时丢掉最早的帧
+    // ---------------------------------------------------------
+    machine_init(&m, rom);
+    size_t budget = 96 << 10;
+    r = rewind_create(&m, budget);
+    print_result("Create small rewind buffer", r != NULL);
+    for (int f = 0; f < FRAMES; f++) {
+        run_frame(&m, f);
+        fp[f] = statehash_digest(&m);
+        rewind_push(r, &m);
+    }
+    uint32_t kept = rewind_frames(r);
+    printf("  %zu KB budget keeps %u frames\n", budget >> 10, kept);
+    print_result("Small budget keeps only recent frames", kept > 10 && kept < FRAMES - 1);
+    print_result("Used bytes stay within budget", rewind_used_bytes(r) < budget);
+    // 扣掉固定部分（两份存档 + 编码缓冲）之后，绕过一圈的环形缓冲区仍然大半是满的
+    print_result("Wrapping keeps most of the ring", rewind_used_bytes(r) > (budget - 3 * savestate_size(&m)) / 3);
+
+    ok = 1;
+    for (uint32_t i = 1; i <= kept; i++) {
+        ok &= rewind_step_back(r, &m) && statehash_digest(&m) == fp[FRAMES - 1 - i];
+    }
+    print_result("Every kept frame is still exact", ok);
+    print_result("Oldest frames are gone", !rewind_step_back(r, &m));
+
+    rewind_destroy(r);
+    free_nes_rom(rom);
+    printf("=== All Rewind Tests Passed ===\n");
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../code/machine.h"
+#include "../code/hash.h"
+#include "../code/statehash.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+#define FRAMES 200
+#define AHEAD 2
+
+// nestest 菜单：第 60-61 帧按 Start，运行第一组测试
+static uint8_t scripted_input(int frame) {
+    return (frame == 60 || frame == 61) ? 0x08 : 0x00;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main() {
+    printf("=== Starting Run-Ahead Tests ===\n");
+
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+
+    // ---------------------------------------------------------
+    // 测试 1: 参考时间线（不预跑）
+    // ---------------------------------------------------------
+    static Machine ref;
+    static uint64_t ref_state[FRAMES], ref_frame[FRAMES], ref_audio[FRAMES];
+    int16_t samples[2048];
+    machine_init(&ref, rom);
+    for (int f = 0; f < FRAMES; f++) {
+        machine_set_input(&ref, 0, scripted_input(f));
+        machine_run_frame(&ref);
+        ref_state[f] = statehash_digest(&ref);
+        ref_frame[f] = machine_frame(&ref)->hash;
+        int n = machine_read_audio(&ref, samples, 2048);
+        ref_audio[f] = hash64(samples, n * sizeof(int16_t), n);
+    }
+
+    // ---------------------------------------------------------
+    // 测试 2: 预跑 AHEAD 帧
+    // ---------------------------------------------------------
+    static Machine m;
+    machine_init(&m, rom);
+    print_result("Enable run-ahead", machine_set_run_ahead(&m, AHEAD));
+
+    int state_ok = 1, audio_ok = 1, frame_ok = 1, checked = 0;
+    for (int f = 0; f < FRAMES; f++) {
+        machine_set_input(&m, 0, scripted_input(f));
+        machine_run_frame(&m);
+        state_ok &= statehash_digest(&m) == ref_state[f];
+        int n = machine_read_audio(&m, samples, 2048);
+        audio_ok &= hash64(samples, n * sizeof(int16_t), n) == ref_audio[f];
+
+        // 显示的是 f + AHEAD 帧；预跑时按住的是当前按键，后面几帧按键不变时才和参考一致
+        int same_input = f + AHEAD < FRAMES;
+        for (int k = 1; k <= AHEAD && same_input; k++) {
+            same_input = scripted_input(f + k) == scripted_input(f);
+        }
+        if (same_input) {
+            frame_ok &= machine_frame(&m)->hash == ref_frame[f + AHEAD];
+            checked++;
+        }
+    }
+    print_result("Real timeline is unaffected by run-ahead", state_ok);
+    print_result("Audio matches the real timeline sample for sample", audio_ok);
+    print_result("Shown frame is AHEAD frames in the future", frame_ok && checked > FRAMES / 2);
+
+    // ---------------------------------------------------------
+    // 测试 3: 代价，以及关掉之后恢复正常
+    // ---------------------------------------------------------
+    double t0 = now_seconds();
+    for (int f = 0; f < 60; f++) machine_run_frame(&m);
+    double t1 = now_seconds();
+    machine_set_run_ahead(&m, 0);
+    print_result("Disable run-ahead frees the buffer", m.run_ahead == 0 && m.run_ahead_state == NULL);
+    for (int f = 0; f < 60; f++) machine_run_frame(&m);
+    double t2 = now_seconds();
+    // 时间只打印，机器忙或者开了 sanitizer 时没有意义
+    printf("  run-ahead %d: %.2fx the cost of a plain frame\n", AHEAD, (t1 - t0) / (t2 - t1));
+
+    // 关掉之后仍然和参考时间线一致
+    machine_init(&m, rom);
+    machine_set_run_ahead(&m, 1);
+    for (int f = 0; f < 100; f++) {
+        machine_set_input(&m, 0, scripted_input(f));
+        machine_run_frame(&m);
+    }
+    machine_set_run_ahead(&m, 0);
+    for (int f = 100; f < FRAMES; f++) {
+        machine_set_input(&m, 0, scripted_input(f));
+        machine_run_frame(&m);
+    }
+    print_result("Switching run-ahead off mid-game stays on the timeline",
+                 statehash_digest(&m) == ref_state[FRAMES - 1] && machine_frame(&m)->hash == ref_frame[FRAMES - 1]);
+
+    free_nes_rom(rom);
+    printf("=== All Run-Ahead Tests Passed ===\n");
+    return 0;
+}
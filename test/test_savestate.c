@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../code/savestate.h"
+#include "../code/machine.h"
+#include "../code/hash.h"
+#include "../code/statehash.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+// nestest 菜单：第 60-61 帧按 Start，运行第一组测试
+static void run_frames(Machine* m, int from, int count) {
+    for (int f = from; f < from + count; f++) {
+        machine_set_input(m, 0, (f == 60 || f == 61) ? 0x08 : 0x00);
+        machine_run_frame(m);
+    }
+}
+
+// 模拟状态（状态哈希）再加上最新一帧的画面
+static uint64_t machine_fingerprint(Machine* m) {
+    return hash64_combine(statehash_digest(m), machine_frame(m)->hash);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main() {
+    printf("=== Starting Save State Tests ===\n");
+
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+    static Machine m;
+    machine_init(&m, rom);
+
+    size_t size = savestate_size(&m);
+    uint8_t* buf = (uint8_t*)malloc(size);
+    printf("  save state size: %zu bytes\n", size);
+
+    // ---------------------------------------------------------
+    // 测试 1: 格式
+    // ---------------------------------------------------------
+    print_result("Small buffer is rejected", savestate_save(&m, buf, size - 1) == 0);
+    print_result("Save writes the full size", savestate_save(&m, buf, size) == size);
+    print_result("Header carries magic and version",
+                 memcmp(buf, "NESS", 4) == 0 && buf[4] == SAVESTATE_VERSION && buf[5] == 0);
+    print_result("Size is independent of machine state", savestate_size(&m) == size);
+
+    // ---------------------------------------------------------
+    // 测试 2: 保存 -> 继续跑 -> 恢复 -> 再跑，两次结果逐周期一致
+    // ---------------------------------------------------------
+    run_frames(&m, 0, 70); // 测试已经在跑，CPU/PPU/APU 都处于忙碌状态
+    savestate_save(&m, buf, size);
+    uint8_t* again = (uint8_t*)malloc(size);
+
+    run_frames(&m, 70, 60);
+    uint64_t first = machine_fingerprint(&m);
+
+    print_result("Load succeeds", savestate_load(&m, buf, size));
+    // 画面不在存档里，恢复后下一帧才更新，所以这里只比较模拟状态：重新保存，逐字节相同
+    print_result("Loaded state matches saved state", savestate_save(&m, again, size) == size &&
+                 memcmp(again, buf, size) == 0);
+    free(again);
+    run_frames(&m, 70, 60);
+    print_result("Replay after load is identical", machine_fingerprint(&m) == first);
+
+    // ---------------------------------------------------------
+    // 测试 3: 坏的存档不改动机器
+    // ---------------------------------------------------------
+    uint64_t before = machine_fingerprint(&m);
+    buf[4]++;
+    print_result("Wrong version is rejected", !savestate_load(&m, buf, size));
+    buf[4]--;
+    buf[0] = 'X';
+    print_result("Wrong magic is rejected", !savestate_load(&m, buf, size));
+    buf[0] = 'N';
+    print_result("Truncated buffer is rejected", !savestate_load(&m, buf, size - 1));
+    print_result("Rejected loads leave the machine untouched", machine_fingerprint(&m) == before);
+
+    // ---------------------------------------------------------
+    // 测试 4: 渲染线程模式下恢复
+    // ---------------------------------------------------------
+    print_result("Load succeeds with render thread", machine_start_render_thread(&m) && savestate_load(&m, buf, size));
+    run_frames(&m, 70, 60);
+    uint64_t threaded = machine_fingerprint(&m);
+    machine_stop_render_thread(&m);
+    print_result("Render thread replay is identical", threaded == first);
+
+    // ---------------------------------------------------------
+    // 测试 5: 增量存档只包含基准之后被写过的页
+    // ---------------------------------------------------------
+    uint8_t* delta = (uint8_t*)malloc(size);
+    uint8_t* other = (uint8_t*)malloc(size);
+    savestate_save(&m, buf, size);
+    print_result("Plain save is not a delta base", savestate_save_delta(&m, delta, size) == 0);
+    savestate_save_base(&m, buf, size); // 基准
+    print_result("Fresh base has an empty delta",
+                 savestate_delta_size(&m) < size / 8 && m.bus.ram_dirty == 0 && m.ppu.vram_dirty == 0);
+    run_frames(&m, 130, 1);
+    size_t delta_size = savestate_save_delta(&m, delta, size);
+    uint64_t delta_fp = statehash_digest(&m);
+    printf("  delta after 1 frame: %zu bytes (full %zu)\n", delta_size, size);
+    print_result("One-frame delta is much smaller than a full state", delta_size > 0 && delta_size < size / 4);
+    print_result("Small buffer is rejected for delta", savestate_save_delta(&m, delta, delta_size - 1) == 0);
+
+    run_frames(&m, 131, 30);
+    uint64_t delta_first = machine_fingerprint(&m);
+    print_result("Later deltas keep the same base", savestate_delta_size(&m) >= delta_size);
+
+    print_result("Load base + delta", savestate_load_delta(&m, buf, size, delta, delta_size));
+    print_result("Base + delta matches the delta point", statehash_digest(&m) == delta_fp);
+    run_frames(&m, 131, 30);
+    print_result("Replay after base + delta is identical", machine_fingerprint(&m) == delta_first);
+
+    savestate_save_base(&m, other, size); // 另一个基准
+    before = machine_fingerprint(&m);
+    print_result("Delta with the wrong base is rejected", !savestate_load_delta(&m, other, size, delta, delta_size));
+    print_result("Full state is not accepted as a delta", !savestate_load_delta(&m, buf, size, other, size));
+    print_result("Rejected delta leaves the machine untouched", machine_fingerprint(&m) == before);
+
+    // 同一时刻分出去、按键不同的两台：主时钟一样，基准却不能互换
+    static Machine left, right;
+    machine_fork(&m, &left);
+    machine_fork(&m, &right);
+    machine_set_input(&left, 0, 0x20);
+    machine_set_input(&right, 0, 0x10);
+    for (int f = 0; f < 3; f++) {
+        machine_run_frame(&left);
+        machine_run_frame(&right);
+    }
+    savestate_save_base(&left, buf, size);
+    savestate_save_base(&right, other, size);
+    print_result("Sibling bases share the clock", left.bus.cycles == right.bus.cycles &&
+                 memcmp(buf, other, SAVESTATE_HEADER_SIZE) != 0);
+    run_frames(&left, 200, 1);
+    delta_size = savestate_save_delta(&left, delta, size);
+    print_result("Delta is refused on a sibling's base", !savestate_load_delta(&right, other, size, delta, delta_size));
+    print_result("Delta is accepted on its own base", savestate_load_delta(&right, buf, size, delta, delta_size) &&
+                 statehash_digest(&right) == statehash_digest(&left));
+    buf[size - 1] ^= 1;
+    // 校验内容只发生在机器不认识这个基准的时候
+    print_result("Modified base is refused", !savestate_load_delta(&m, buf, size, delta, delta_size));
+    buf[size - 1] ^= 1;
+    machine_release(&left);
+    machine_release(&right);
+
+    // PRG-RAM 的写入也按页进增量存档
+    savestate_save_base(&m, buf, size);
+    bus_write(&m.bus, 0x6ABC, 0x42);
+    size_t prg_delta = savestate_save_delta(&m, delta, size);
+    bus_write(&m.bus, 0x6ABC, 0x00);
+    print_result("PRG-RAM page round-trips through a delta",
+                 prg_delta >= 1024 && delta[13] == 0x04 &&
+                 savestate_load_delta(&m, buf, size, delta, prg_delta) && m.bus.prg_ram[0x0ABC] == 0x42);
+    free(other);
+    free(delta);
+
+    // ---------------------------------------------------------
+    // 测试 6: 速度（不分配内存，只有定长拷贝）。只打印，机器忙或者开了 sanitizer 时时间没有意义
+    // ---------------------------------------------------------
+    const int rounds = 20000;
+    uint64_t round_trip = machine_fingerprint(&m);
+    double t0 = now_seconds();
+    for (int i = 0; i < rounds; i++) {
+        savestate_save(&m, buf, size);
+    }
+    double t1 = now_seconds();
+    for (int i = 0; i < rounds; i++) {
+        savestate_load(&m, buf, size);
+    }
+    double t2 = now_seconds();
+    printf("  save %.0f ns, load %.0f ns\n", (t1 - t0) / rounds * 1e9, (t2 - t1) / rounds * 1e9);
+    print_result("Repeated save and load keep the state", machine_fingerprint(&m) == round_trip);
+
+    free(buf);
+    free_nes_rom(rom);
+    printf("=== All Save State Tests Passed ===\n");
+    return 0;
+}
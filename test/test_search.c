@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../code/search.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+// nestest 菜单的光标在 RAM $D7；每次按下（松开之后再按）往下一格
+#define CURSOR 0xD7
+#define STEP_FRAMES 4
+
+static int cursor_at(void* user, const Machine* m) {
+    return m->bus.ram[CURSOR] == *(const uint8_t*)user;
+}
+
+// 离目标越近分数越高（按上会从顶部绕到底部）
+static double cursor_score(void* user, const Machine* m) {
+    return -abs((int)m->bus.ram[CURSOR] - (int)*(const uint8_t*)user);
+}
+
+static const uint8_t actions[] = {0x00, 0x20, 0x10}; // 不按 / 下 / 上
+
+// 在 m 的分支上重放按键，返回最后的光标位置
+static int replay(Machine* m, const uint8_t* keys, int steps) {
+    static Machine copy;
+    machine_fork(m, &copy);
+    for (int s = 0; s < steps; s++) {
+        machine_set_input(&copy, 0, keys[s]);
+        for (int f = 0; f < STEP_FRAMES; f++) machine_run_frame(&copy);
+    }
+    int cursor = copy.bus.ram[CURSOR];
+    machine_release(&copy);
+    return cursor;
+}
+
+int main() {
+    printf("=== Starting Search Tests ===\n");
+
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+    // 菜单在第 60 帧之后才响应
+    static Machine start;
+    machine_init(&start, rom);
+    machine_set_audio(&start, 0);
+    for (int f = 0; f < 70; f++) machine_run_frame(&start);
+    uint8_t target = 3;
+    print_result("Cursor starts at the top", start.bus.ram[CURSOR] == 0);
+
+    SearchConfig config;
+    memset(&config, 0, sizeof(config));
+    config.mode = SEARCH_BFS;
+    config.actions = actions;
+    config.action_count = 3;
+    config.frames_per_step = STEP_FRAMES;
+    config.max_depth = 8;
+    config.width = 64;
+    config.goal = cursor_at;
+    config.user = &target;
+
+    // ---------------------------------------------------------
+    // 测试 1: BFS 找到最短的序列，重放能到达目标
+    // ---------------------------------------------------------
+    SearchResult serial;
+    print_result("BFS runs", search_run(&start, &config, NULL, &serial));
+    printf("  found in %d steps, %llu nodes, %llu duplicates, %.0f frames/s\n", serial.steps,
+           (unsigned long long)serial.nodes, (unsigned long long)serial.duplicates, serial.frames / serial.seconds);
+    // 三次按下，中间至少要松开两次
+    print_result("BFS finds the shortest input sequence", serial.found && serial.steps == 5);
+    print_result("Replaying the sequence reaches the goal", replay(&start, serial.actions, serial.steps) == target);
+    print_result("Identical RAM states are merged", serial.duplicates > 0);
+    print_result("Start state is untouched", start.bus.ram[CURSOR] == 0);
+
+    // ---------------------------------------------------------
+    // 测试 2: 线程池上跑，结果与单线程相同
+    // ---------------------------------------------------------
+    ThreadPool* pool = thread_pool_create(4, 0);
+    SearchResult parallel;
+    search_run(&start, &config, pool, &parallel);
+    printf("  %.0f frames/s on %d threads\n", parallel.frames / parallel.seconds, thread_pool_size(pool));
+    print_result("Thread pool finds the same sequence", parallel.found && parallel.steps == serial.steps &&
+                 memcmp(parallel.actions, serial.actions, (size_t)serial.steps) == 0 &&
+                 parallel.nodes == serial.nodes && parallel.duplicates == serial.duplicates);
+    free(parallel.actions);
+
+    // ---------------------------------------------------------
+    // 测试 3: 束搜索和随机搜索
+    // ---------------------------------------------------------
+    config.mode = SEARCH_BEAM;
+    config.width = 4;
+    config.score = cursor_score;
+    SearchResult beam;
+    search_run(&start, &config, pool, &beam);
+    print_result("Beam search reaches the goal", beam.found && replay(&start, beam.actions, beam.steps) == target);
+    print_result("Beam search expands fewer nodes", beam.nodes < serial.nodes);
+    free(beam.actions);
+
+    config.mode = SEARCH_RANDOM;
+    config.width = 64;
+    config.max_depth = 16;
+    config.seed = 12345;
+    SearchResult random1, random2;
+    search_run(&start, &config, pool, &random1);
+    search_run(&start, &config, NULL, &random2);
+    print_result("Random search reaches the goal", random1.found && replay(&start, random1.actions, random1.steps) == target);
+    print_result("Random search is deterministic for a seed", random2.found && random1.steps == random2.steps &&
+                 memcmp(random1.actions, random2.actions, (size_t)random1.steps) == 0);
+    free(random1.actions);
+    free(random2.actions);
+
+    // ---------------------------------------------------------
+    // 测试 4: 找不到和参数不合法
+    // ---------------------------------------------------------
+    config.mode = SEARCH_BFS;
+    config.max_depth = 2;
+    config.width = 64;
+    SearchResult none;
+    print_result("Unreachable goal is reported", search_run(&start, &config, pool, &none) && !none.found && none.actions == NULL);
+    config.frames_per_step = 0;
+    print_result("Invalid config is rejected", !search_run(&start, &config, pool, &none));
+
+    free(serial.actions);
+    thread_pool_destroy(pool);
+    machine_release(&start);
+    free_nes_rom(rom);
+    printf("=== All Search Tests Passed ===\n");
+    return 0;
+}
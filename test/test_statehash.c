@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../code/statehash.h"
+#include "../code/batch.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+#define FRAMES 120
+#define MACHINES 4
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 按同样的按键跑 frames 帧：第 60 帧按 Start 进入测试
+static void run(Machine* m, int frames) {
+    for (int f = 0; f < frames; f++) {
+        machine_set_input(m, 0, (f >= 60 && f < 64) ? 0x08 : 0x00);
+        machine_run_frame(m);
+    }
+}
+
+int main() {
+    printf("=== Starting State Hash Tests ===\n");
+
+    NesRom* rom = load_nes_rom("test/nestest.nes");
+    if (!rom) {
+        printf("Cannot load test/nestest.nes\n");
+        return 1;
+    }
+
+    // ---------------------------------------------------------
+    // 测试 1: 同样的输入，两台机器的日志完全一致
+    // ---------------------------------------------------------
+    static Machine a, b;
+    StateHashLog* la = statehash_log_create();
+    StateHashLog* lb = statehash_log_create();
+    machine_init(&a, rom);
+    machine_init(&b, rom);
+    machine_attach_hash_log(&a, la);
+    machine_attach_hash_log(&b, lb);
+    run(&a, FRAMES);
+    run(&b, FRAMES);
+    print_result("One record per frame", statehash_log_count(la) == FRAMES);
+    int part = 0;
+    print_result("Identical runs give identical logs", statehash_log_compare(la, lb, &part) == -1);
+
+    // 关掉音频合成时声道的波形不走，但它不在哈希里：两份日志逐帧一致
+    static Machine quiet;
+    StateHashLog* lq = statehash_log_create();
+    machine_init(&quiet, rom);
+    machine_set_audio(&quiet, 0);
+    machine_attach_hash_log(&quiet, lq);
+    run(&quiet, FRAMES);
+    print_result("Audio on and audio off give identical logs", statehash_log_compare(la, lq, &part) == -1);
+    // 存档正文里各部件逐字节相同，只有后面的波形状态不同
+    size_t body = savestate_size(&a);
+    uint8_t* sa = (uint8_t*)malloc(body);
+    uint8_t* sq = (uint8_t*)malloc(body);
+    size_t marks[STATE_SECTIONS + 1];
+    size_t end = savestate_save_sections(&a, sa, body, marks);
+    savestate_save_sections(&quiet, sq, body, marks);
+    print_result("Only the waveform state differs",
+                 memcmp(sa, sq, marks[STATE_SECTIONS]) == 0 &&
+                 memcmp(sa + marks[STATE_SECTIONS], sq + marks[STATE_SECTIONS], end - marks[STATE_SECTIONS]) != 0);
+    free(sq);
+    free(sa);
+
+    // nestest 几乎不出声：每帧开头再写一个 APU 寄存器，让各声道和 DMC 都响起来，比较仍然逐帧一致
+    static const uint16_t regs[] = {0x4015, 0x4000, 0x4003, 0x4004, 0x4007, 0x4008, 0x400B,
+                                    0x400C, 0x400F, 0x4010, 0x4012, 0x4013, 0x4015, 0x4017};
+    static const uint8_t values[] = {0x1F, 0xBF, 0x48, 0x9F, 0x30, 0xFF, 0x58,
+                                     0x3F, 0x70, 0x4C, 0x10, 0x03, 0x1F, 0x00};
+    const int nregs = sizeof(regs) / sizeof(regs[0]);
+    static Machine loud;
+    StateHashLog* ll = statehash_log_create();
+    statehash_log_clear(lq);
+    machine_init(&loud, rom);
+    machine_init(&quiet, rom);
+    machine_set_audio(&quiet, 0);
+    machine_attach_hash_log(&loud, ll);
+    machine_attach_hash_log(&quiet, lq);
+    int peak = 0;
+    for (int f = 0; f < FRAMES; f++) {
+        if (f < nregs) {
+            bus_write(&loud.bus, regs[f], values[f]);
+            bus_write(&quiet.bus, regs[f], values[f]);
+        }
+        run(&loud, 1);
+        run(&quiet, 1);
+        int16_t pcm[1024];
+        int n = machine_read_audio(&loud, pcm, 1024);
+        for (int i = 0; i < n; i++) peak = abs(pcm[i]) > peak ? abs(pcm[i]) : peak;
+    }
+    print_result("Audio on and off agree while every channel plays",
+                 peak > 1000 && statehash_log_count(ll) == FRAMES &&
+                 statehash_log_compare(ll, lq, &part) == -1);
+    statehash_log_destroy(ll);
+    statehash_log_destroy(lq);
+
+    StateHash now;
+    statehash_compute(&a, &now);
+    print_result("Log record matches a direct hash",
+                 memcmp(&now, statehash_log_get(la, FRAMES - 1), sizeof(now)) == 0 &&
+                 now.cycles == a.bus.cycles);
+    const StateHash* h0 = statehash_log_get(la, 0);
+    const StateHash* h1 = statehash_log_get(la, FRAMES - 1);
+    print_result("Hashes change as the game runs", h0->part[STATE_SECTION_CPU] != h1->part[STATE_SECTION_CPU] &&
+                 h0->part[STATE_SECTION_RAM] != h1->part[STATE_SECTION_RAM]);
+
+    // 哈希不能改变机器状态（包括增量存档的基准）
+    uint64_t base = a.state_base;
+    uint8_t dirty = a.bus.ram_dirty;
+    statehash_compute(&a, &now);
+    print_result("Hashing leaves the machine untouched", a.state_base == base && a.bus.ram_dirty == dirty);
+
+    // ---------------------------------------------------------
+    // 测试 2: 找出第一次分叉的帧和部件
+    // ---------------------------------------------------------
+    statehash_log_clear(la);
+    statehash_log_clear(lb);
+    machine_init(&a, rom);
+    machine_init(&b, rom);
+    machine_attach_hash_log(&a, la);
+    machine_attach_hash_log(&b, lb);
+    run(&a, 30);
+    run(&b, 30);
+    b.bus.ram[0x7FF] ^= 0x5A; // 一个没人用的字节：只有 RAM 不同
+    run(&a, 1);
+    run(&b, 1);
+    print_result("Pinpoint first diverging frame and component",
+                 statehash_log_compare(la, lb, &part) == 30 && part == STATE_SECTION_RAM &&
+                 strcmp(statehash_part_name(part), "ram") == 0);
+
+    // 同一个状态分出去，只改一个寄存器
+    static Machine c;
+    machine_fork(&a, &c);
+    c.cpu.x ^= 1;
+    statehash_log_clear(la);
+    statehash_log_clear(lb);
+    statehash_log_append(la, &a);
+    statehash_log_append(lb, &c);
+    print_result("CPU divergence is reported as cpu",
+                 statehash_log_compare(la, lb, &part) == 0 && part == STATE_SECTION_CPU);
+    machine_release(&c);
+    machine_release(&a);
+
+    statehash_log_clear(lb);
+    statehash_log_append(lb, &a);
+    statehash_log_append(la, &a);
+    print_result("Length mismatch after a common prefix",
+                 statehash_log_compare(la, lb, &part) == 1 && part == -1);
+
+    // ---------------------------------------------------------
+    // 测试 3: 存档恢复、分支出来的机器，哈希和原机器一致
+    // ---------------------------------------------------------
+    machine_init(&a, rom);
+    run(&a, 70);
+    size_t size = savestate_size(&a);
+    uint8_t* state = (uint8_t*)malloc(size);
+    savestate_save(&a, state, size);
+    StateHash before, after;
+    statehash_compute(&a, &before);
+    run(&a, 5);
+    savestate_load(&a, state, size);
+    statehash_compute(&a, &after);
+    print_result("Savestate round trip keeps the hash", memcmp(&before, &after, sizeof(before)) == 0);
+
+    static Machine child;
+    machine_fork(&a, &child);
+    statehash_compute(&child, &after);
+    print_result("Forked machine has the parent's hash", memcmp(&before, &after, sizeof(before)) == 0);
+    machine_release(&child);
+    machine_release(&a);
+    free(state);
+
+    // ---------------------------------------------------------
+    // 测试 4: 线程池批量运行和逐台运行的日志一致；写文件再读回
+    // ---------------------------------------------------------
+    static Machine serial[MACHINES], pooled[MACHINES];
+    StateHashLog* ls[MACHINES];
+    StateHashLog* lp[MACHINES];
+    Machine* ptrs[MACHINES];
+    ThreadPool* pool = thread_pool_create(MACHINES, 0);
+    for (int i = 0; i < MACHINES; i++) {
+        ls[i] = statehash_log_create();
+        lp[i] = statehash_log_create();
+        machine_init(&serial[i], rom);
+        machine_init(&pooled[i], rom);
+        machine_attach_hash_log(&serial[i], ls[i]);
+        machine_attach_hash_log(&pooled[i], lp[i]);
+        ptrs[i] = &pooled[i];
+    }
+    for (int i = 0; i < MACHINES; i++) {
+        for (int f = 0; f < FRAMES; f++) machine_run_frame(&serial[i]);
+    }
+    batch_run_frames(pool, ptrs, MACHINES, FRAMES);
+    int same = 1;
+    for (int i = 0; i < MACHINES; i++) same &= statehash_log_compare(ls[i], lp[i], NULL) == -1;
+    print_result("Thread pool run matches serial run", same);
+
+    const char* path = "/tmp/test_statehash.nesh";
+    StateHashLog* loaded = statehash_log_create();
+    print_result("Save and load log file", statehash_log_save(ls[0], path) && statehash_log_load(loaded, path) &&
+                 statehash_log_compare(ls[0], loaded, NULL) == -1);
+    remove(path);
+
+    // ---------------------------------------------------------
+    // 测试 5: 开销
+    // ---------------------------------------------------------
+    machine_init(&a, rom);
+    machine_set_audio(&a, 0);
+    machine_attach_hash_log(&a, NULL);
+    double t0 = now_seconds();
+    run(&a, FRAMES);
+    double t1 = now_seconds();
+    statehash_log_clear(la);
+    machine_attach_hash_log(&a, la);
+    run(&a, FRAMES);
+    statehash_log_clear(lb);
+    double t2 = now_seconds();
+    for (int f = 0; f < FRAMES; f++) statehash_log_append(lb, &a);
+    double t3 = now_seconds();
+    // 时间只打印，机器忙或者开了 sanitizer 时没有意义
+    printf("  frame %.1f us, frame + hash %.1f us, hash alone %.2f us\n",
+           (t1 - t0) / FRAMES * 1e6, (t2 - t1) / FRAMES * 1e6, (t3 - t2) / FRAMES * 1e6);
+    // 机器没动，反复哈希都和帧末记下的那一条一样
+    same = statehash_log_count(lb) == FRAMES;
+    const StateHash* last = statehash_log_get(la, statehash_log_count(la) - 1);
+    for (int f = 0; same && f < FRAMES; f++) same = memcmp(statehash_log_get(lb, f), last, sizeof(*last)) == 0;
+    print_result("Repeated hashing matches the end-of-frame entry", same);
+
+    for (int i = 0; i < MACHINES; i++) {
+        statehash_log_destroy(ls[i]);
+        statehash_log_destroy(lp[i]);
+    }
+    thread_pool_destroy(pool);
+    statehash_log_destroy(loaded);
+    statehash_log_destroy(la);
+    statehash_log_destroy(lb);
+    free_nes_rom(rom);
+    printf("=== All State Hash Tests Passed ===\n");
+    return 0;
+}
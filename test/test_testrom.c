@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../code/testrom.h"
+#include "../code/machine.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+// 16KB PRG-ROM，映射在 $8000 和 $C000；程序从 $C000 开始，文字放在 $C100，中断向量指向 $C0F0 的 RTI
+#define PRG_SIZE 0x4000
+static uint8_t prg[PRG_SIZE];
+
+// 写签名、状态 0x80、文字，最后写结果码 result 并原地循环。返回写了多少字节
+static int emit_report(uint8_t* p, int at, uint8_t result) {
+    static const uint8_t code[] = {
+        0xA9, 0xDE, 0x8D, 0x01, 0x60,   // LDA #$DE; STA $6001
+        0xA9, 0xB0, 0x8D, 0x02, 0x60,   // LDA #$B0; STA $6002
+        0xA9, 0x61, 0x8D, 0x03, 0x60,   // LDA #$61; STA $6003
+        0xA9, 0x80, 0x8D, 0x00, 0x60,   // LDA #$80; STA $6000
+        0xA2, 0x00,                     // LDX #0
+        0xBD, 0x00, 0xC1,               // loop: LDA $C100,X
+        0x9D, 0x04, 0x60,               //       STA $6004,X
+        0xF0, 0x03,                     //       BEQ done
+        0xE8,                           //       INX
+        0xD0, 0xF5,                     //       BNE loop
+        0xA9, 0x00, 0x8D, 0x00, 0x60,   // done: LDA #result; STA $6000
+        0x4C, 0x00, 0x00,               // forever: JMP forever
+    };
+    int n = (int)sizeof(code);
+    memcpy(p + at, code, n);
+    p[at + 34] = result;
+    uint16_t forever = (uint16_t)(0xC000 + at + n - 3);
+    p[at + n - 2] = forever & 0xFF;
+    p[at + n - 1] = forever >> 8;
+    return n;
+}
+
+static void write_rom(const char* dir, const char* name, int mapper) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    uint8_t header[16] = {'N', 'E', 'S', 0x1A, 1, 0, (uint8_t)(mapper << 4), 0};
+    FILE* fp = fopen(path, "wb");
+    fwrite(header, 1, sizeof(header), fp);
+    fwrite(prg, 1, sizeof(prg), fp);
+    fclose(fp);
+}
+
+static void begin_rom(const char* text) {
+    memset(prg, 0xEA, sizeof(prg)); // NOP
+    prg[0xF0] = 0x40;               // RTI
+    strcpy((char*)prg + 0x100, text);
+    prg[0x3FFA] = 0xF0; prg[0x3FFB] = 0xC0; // NMI
+    prg[0x3FFC] = 0x00; prg[0x3FFD] = 0xC0; // RESET
+    prg[0x3FFE] = 0xF0; prg[0x3FFF] = 0xC0; // IRQ
+}
+
+static const TestRomResult* find(const TestRomResult* results, int count, const char* name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(results[i].name, name) == 0) return &results[i];
+    }
+    return NULL;
+}
+
+int main() {
+    printf("=== Starting Test ROM Runner Tests ===\n");
+
+    char dir[64];
+    snprintf(dir, sizeof(dir), "/tmp/testrom_%d", (int)getpid());
+    mkdir(dir, 0700);
+
+    // 通过
+    begin_rom("\nPassed\n");
+    emit_report(prg, 0, 0);
+    write_rom(dir, "a_pass.nes", 0);
+
+    // 失败，结果码 3
+    begin_rom("Branch timing\nFailed #3\n");
+    emit_report(prg, 0, 3);
+    write_rom(dir, "b_fail.nes", 0);
+
+    // 第一次上电要求复位（$6010 做标记），复位之后才报告通过
+    begin_rom("After reset\n");
+    static const uint8_t first_boot[] = {
+        0xAD, 0x10, 0x60,               // LDA $6010
+        0xC9, 0x42,                     // CMP #$42
+        0xF0, 0x1C,                     // BEQ report
+        0xA9, 0x42, 0x8D, 0x10, 0x60,   // LDA #$42; STA $6010
+        0xA9, 0xDE, 0x8D, 0x01, 0x60,
+        0xA9, 0xB0, 0x8D, 0x02, 0x60,
+        0xA9, 0x61, 0x8D, 0x03, 0x60,
+        0xA9, 0x81, 0x8D, 0x00, 0x60,   // LDA #$81; STA $6000
+        0x4C, 0x20, 0xC0,               // JMP * ($C020)
+    };
+    memcpy(prg, first_boot, sizeof(first_boot));
+    emit_report(prg, (int)sizeof(first_boot), 0);
+    write_rom(dir, "c_reset.nes", 0);
+
+    // 从来不报告
+    begin_rom("");
+    prg[0] = 0x4C; prg[1] = 0x00; prg[2] = 0xC0; // JMP $C000
+    write_rom(dir, "d_silent.nes", 0);
+
+    // 不支持的 Mapper，坏文件，以及不是 .nes 的文件
+    begin_rom("\nPassed\n");
+    emit_report(prg, 0, 0);
+    write_rom(dir, "e_mmc1.nes", 1);
+    char path[512];
+    snprintf(path, sizeof(path), "%s/f_broken.nes", dir);
+    FILE* fp = fopen(path, "wb");
+    fputs("not a rom", fp);
+    fclose(fp);
+    snprintf(path, sizeof(path), "%s/readme.txt", dir);
+    fp = fopen(path, "wb");
+    fclose(fp);
+
+    // ---------------------------------------------------------
+    // 测试 1: 单个 ROM，读出状态和文字
+    // ---------------------------------------------------------
+    TestRomResult one;
+    snprintf(path, sizeof(path), "%s/a_pass.nes", dir);
+    testrom_run(path, 60, &one);
+    print_result("Passing ROM reports PASS", one.status == TESTROM_PASS && one.code == 0 && one.protocol &&
+                 strcmp(one.name, "a_pass.nes") == 0 && strcmp(one.text, "\nPassed\n") == 0);
+    print_result("Cycles and frames are counted", one.frames >= 1 && one.frames < 60 && one.cycles > 0);
+
+    // ---------------------------------------------------------
+    // 测试 2: 整个目录并行跑，结果与逐个跑相同
+    // ---------------------------------------------------------
+    ThreadPool* pool = thread_pool_create(4, 0);
+    TestRomResult* results = NULL;
+    int count = testrom_run_dir(pool, dir, 120, &results);
+    print_result("Runs every .nes file in the directory", count == 6);
+    print_result("Results are sorted by name", count == 6 && strcmp(results[0].name, "a_pass.nes") == 0 &&
+                 strcmp(results[5].name, "f_broken.nes") == 0);
+
+    const TestRomResult* r = find(results, count, "b_fail.nes");
+    print_result("Failing ROM reports its result code", r && r->status == TESTROM_FAIL && r->code == 3 &&
+                 strcmp(r->text, "Branch timing\nFailed #3\n") == 0);
+    r = find(results, count, "c_reset.nes");
+    print_result("Reset request is honoured", r && r->status == TESTROM_PASS && r->frames > 10 &&
+                 strcmp(r->text, "After reset\n") == 0);
+    r = find(results, count, "d_silent.nes");
+    print_result("Silent ROM times out", r && r->status == TESTROM_TIMEOUT && !r->protocol &&
+                 r->frames == 120 && r->code == -1);
+    r = find(results, count, "e_mmc1.nes");
+    print_result("Unsupported mapper is not run", r && r->status == TESTROM_UNSUPPORTED && r->frames == 0);
+    r = find(results, count, "f_broken.nes");
+    print_result("Broken file is a load error", r && r->status == TESTROM_LOAD_ERROR);
+
+    TestRomResult* serial = NULL;
+    int serial_count = testrom_run_dir(NULL, dir, 120, &serial);
+    int same = serial_count == count;
+    for (int i = 0; same && i < count; i++) {
+        same = serial[i].status == results[i].status && serial[i].frames == results[i].frames &&
+               serial[i].cycles == results[i].cycles;
+    }
+    print_result("Thread pool gives the same results", same);
+
+    testrom_print_matrix(results, count, stdout);
+    TestRomResult* missing = NULL;
+    print_result("Missing directory is reported",
+                 testrom_run_dir(pool, "/nonexistent/roms", 60, &missing) == -1 && missing == NULL);
+
+    // nestest 不用 $6000 约定：跑满超时
+    testrom_run("test/nestest.nes", 30, &one);
+    print_result("ROM without the protocol times out", one.status == TESTROM_TIMEOUT && !one.protocol);
+
+    free(results);
+    free(serial);
+    thread_pool_destroy(pool);
+    const char* names[] = {"a_pass.nes", "b_fail.nes", "c_reset.nes", "d_silent.nes", "e_mmc1.nes", "f_broken.nes", "readme.txt"};
+    for (int i = 0; i < 7; i++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+        remove(path);
+    }
+    rmdir(dir);
+    printf("=== All Test ROM Runner Tests Passed ===\n");
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 注意：因为我们在 test 目录下，引用 code 目录的头文件需要用 "../code/"
+#include "../code/video.h"
+
+// 辅助打印函数：绿色显示通过，红色显示失败
+void print_result(const char* test_name, int passed) {
+    if (passed) {
+        printf("[\033[32mPASS\033[0m] %s\n", test_name);
+    } else {
+        printf("[\033[31mFAIL\033[0m] %s\n", test_name);
+        exit(1); // 遇到错误直接退出
+    }
+}
+
+int main() {
+    printf("=== Starting Video Tests ===\n");
+
+    static VideoPalette pal;
+    static PpuFrame frame;
+    static uint32_t rgba[PPU_WIDTH * PPU_HEIGHT];
+    static uint16_t rgb565[PPU_WIDTH * PPU_HEIGHT];
+    static uint8_t y[PPU_WIDTH * PPU_HEIGHT];
+    static uint8_t u[PPU_WIDTH * PPU_HEIGHT / 4];
+    static uint8_t v[PPU_WIDTH * PPU_HEIGHT / 4];
+    video_palette_init(&pal);
+
+    // 每个像素都是颜色号 x % 64；第 1 行打开红色强调
+    for (int i = 0; i < PPU_WIDTH * PPU_HEIGHT; i++) {
+        frame.pixels[i] = (uint8_t)(i % 64);
+    }
+    memset(frame.emphasis, 0, sizeof(frame.emphasis));
+    frame.emphasis[1] = 0x01;
+
+    // ---------------------------------------------------------
+    // 测试 1: RGBA 查表（包括整行 8 像素一组的快速路径和尾部）
+    // ---------------------------------------------------------
+    video_to_rgba(&pal, &frame, rgba, PPU_WIDTH);
+    print_result("Color $30 is white", rgba[0x30] == 0xFFFFFEFF);
+    print_result("Color $0F is black", rgba[0x0F] == 0xFF000000);
+    int all_match = 1;
+    for (int i = 0; i < PPU_WIDTH * PPU_HEIGHT; i++) {
+        if (rgba[i] != pal.rgba[frame.emphasis[i / PPU_WIDTH]][frame.pixels[i]]) all_match = 0;
+    }
+    print_result("Every pixel uses its line's emphasis table", all_match);
+
+    // 红色强调：红色通道不变，绿/蓝变暗
+    uint32_t plain = rgba[0x30];
+    uint32_t emph = rgba[PPU_WIDTH + 0x30];
+    print_result("Red emphasis keeps red, dims green/blue",
+                 (emph & 0xFF0000) == (plain & 0xFF0000) &&
+                 (emph & 0x00FF00) < (plain & 0x00FF00) && (emph & 0xFF) < (plain & 0xFF));
+
+    // ---------------------------------------------------------
+    // 测试 2: RGB565 与 YUV420
+    // ---------------------------------------------------------
+    video_to_rgb565(&pal, &frame, rgb565, PPU_WIDTH);
+    print_result("RGB565 white", rgb565[0x30] == 0xFFFF);
+
+    video_to_yuv420(&pal, &frame, y, u, v);
+    print_result("Y of black is 16", y[0x0F] == 16);
+    print_result("Y of white is 235", y[0x30] == 235);
+    // 第一个 2x2 块：(0,1) 与 (256,257) 两行颜色相同但第 1 行有强调
+    int expect_u = (pal.u[0][0] + pal.u[0][1] + pal.u[1][0] + pal.u[1][1] + 2) >> 2;
+    print_result("Chroma is a 2x2 average", u[0] == expect_u);
+
+    printf("=== All Tests Completed ===\n");
+    return 0;
+}